@@ -0,0 +1,385 @@
+// --- Host Benchmark / Replay Harness for the ADC Processing Kernel ---
+// Feeds TYPE2 DMA frames (synthetic waveforms or recorded scope captures) through the
+// same kernel the ADC task runs (arduino/sketch/adc_kernel.cpp): accumulate_frame per
+// frame, block_close / window_push / window_compute_result per output period. Reports
+// kernel throughput and checks the last window's RMS/frequency against references
+// computed independently in double precision. The same frames also go through the
+// packed waveform codec (arduino/sketch/wave_codec.cpp, as the stream link packs them):
+// every block must decode back to the exact codes, and the packed size is reported.
+//
+//   make run                          synthetic scenarios
+//   ./adc_bench --seconds 20          longer runs (steadier timing)
+//   ./adc_bench --capture file.json   replay an S3 scope capture (.json, packed .wave, or a text file of raw codes)
+//
+// Exit status is non-zero if any accuracy check fails.
+
+#include "adc_kernel.h"
+#include "scope.h"
+#include "spectrum.h"
+#include "wave_codec.h"
+
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// --- Sinks for the kernel's optional outputs (firmware: scope.cpp / spectrum.cpp) ---
+static uint16_t bench_scope_ring[SCOPE_SAMPLES];
+ScopeWriter scope_writer = { bench_scope_ring, SCOPE_SAMPLES - 1, 0 };
+SpectrumCapture spectrum_capture;
+static uint32_t spectrum_captures = 0;
+void spectrum_capture_complete(SpectrumCapture *cap) {
+    cap->position = 0;
+    spectrum_captures++;
+}
+
+// --- Calibration Model ---
+// Linear 0..BENCH_FULL_SCALE_MV over the 12-bit range (roughly the C3 at 11 dB).
+// The kernel only sees the LUT, so the exact curve does not matter for the checks.
+static const double BENCH_FULL_SCALE_MV = 3100.0;
+
+static void build_bench_lut() {
+    for (uint32_t raw = 0; raw < ADC_RAW_CODE_COUNT; ++raw) {
+        adc_raw_to_mv_lut[raw] = (uint16_t)lround(raw * BENCH_FULL_SCALE_MV / (ADC_RAW_CODE_COUNT - 1));
+    }
+}
+
+static uint16_t mv_to_code(double mv) {
+    long code = lround(mv * (ADC_RAW_CODE_COUNT - 1) / BENCH_FULL_SCALE_MV);
+    return (uint16_t)std::min(std::max(code, 0L), (long)(ADC_RAW_CODE_COUNT - 1));
+}
+
+// --- Scenarios ---
+enum class SignalKind { SINE, PWM_CHOPPED, DC, NOISY_SINE, CAPTURE };
+
+struct Scenario {
+    std::string name;
+    SignalKind kind;
+    double freq_hz;      // Fundamental (0 for DC / captures)
+    double amplitude_mv;
+    double offset_mv;
+    double noise_mv;     // Gaussian sigma
+    double pwm_hz;       // PWM carrier for PWM_CHOPPED
+    double pwm_duty;
+    std::vector<uint16_t> capture; // Raw primary codes for CAPTURE (replayed in a loop)
+    double ripple_hz = 0.0; // Switching ripple added on top (left out of the reference)
+    double ripple_mv = 0.0;
+    uint8_t filter_sections = 0; // IIR_SECTION_* bits run by the kernel (iir_filter.h)
+};
+
+// Primary-channel input (mV, before quantization) for sample n at the per-channel rate.
+struct SignalGenerator {
+    const Scenario *sc;
+    std::mt19937 rng{12345};
+    std::normal_distribution<double> noise{0.0, 1.0};
+
+    // Switching ripple of sample n, also part of sample_mv()
+    double ripple_mv(uint64_t n) const {
+        return sc->ripple_mv * sin(2.0 * M_PI * sc->ripple_hz * (double)n / ADC_SAMPLE_FREQ_HZ);
+    }
+
+    double sample_mv(uint64_t n) {
+        double t = (double)n / ADC_SAMPLE_FREQ_HZ;
+        double ac = sc->amplitude_mv * sin(2.0 * M_PI * sc->freq_hz * t) + ripple_mv(n);
+        switch (sc->kind) {
+        case SignalKind::SINE:
+            return sc->offset_mv + ac;
+        case SignalKind::PWM_CHOPPED: {
+            // Phase current only flows while the switch is on: sine gated by the carrier
+            double carrier_phase = fmod(t * sc->pwm_hz, 1.0);
+            return sc->offset_mv + (carrier_phase < sc->pwm_duty ? ac : 0.0);
+        }
+        case SignalKind::DC:
+            return sc->offset_mv + sc->noise_mv * noise(rng);
+        case SignalKind::NOISY_SINE:
+            return sc->offset_mv + ac + sc->noise_mv * noise(rng);
+        case SignalKind::CAPTURE:
+            return adc_raw_to_mv_lut[sc->capture[n % sc->capture.size()]];
+        }
+        return 0.0;
+    }
+};
+
+// Constant levels for the secondary pattern slots (auxiliary phase, battery divider pin)
+static uint16_t secondary_code(int slot) {
+    return mv_to_code(ADC_PATTERN[slot].role == ChannelRole::BATTERY_VOLTAGE ? 1200.0 : CURRENT_SENSOR_ZERO_MV);
+}
+
+struct RunResult {
+    MeasurementResult result;
+    WindowOutcome outcome;
+    double ref_rms_mv;
+    double kernel_ns;
+    uint64_t slots;
+    uint32_t windows;
+    uint64_t packed_bytes; // Codec: blocks for every frame, headers included
+    double encode_ns;
+    bool codec_ok;         // Every block decoded back to its input
+};
+
+// Packs each frame like stream_push_frame (one block per pattern slot), decodes it again
+// and compares.
+static void run_codec(const std::vector<adc_digi_output_data_t> &stream, RunResult *run) {
+    using clock = std::chrono::steady_clock;
+    clock::duration encode_time{};
+    static uint16_t slot_codes[ADC_PATTERN_LEN][ADC_READ_LEN];
+    static uint16_t decoded[ADC_READ_LEN];
+    static uint8_t packed[ADC_PATTERN_LEN * wave_max_block_bytes(ADC_READ_LEN)];
+    run->packed_bytes = 0;
+    run->codec_ok = true;
+    for (size_t frame = 0; frame + ADC_READ_LEN <= stream.size(); frame += ADC_READ_LEN) {
+        uint32_t slot_count[ADC_PATTERN_LEN] = {};
+        for (int i = 0; i < ADC_READ_LEN; ++i) {
+            const adc_digi_output_data_t &d = stream[frame + i];
+            uint32_t slot = adc_channel_slot[d.type2.channel];
+            slot_codes[slot][slot_count[slot]++] = d.type2.data;
+        }
+        uint32_t len = 0;
+        clock::time_point t0 = clock::now();
+        for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+            len += wave_encode_block(slot_codes[slot], slot_count[slot], ADC_PATTERN[slot].channel, (uint32_t)frame, &packed[len]);
+        }
+        encode_time += clock::now() - t0;
+        run->packed_bytes += len;
+        uint32_t pos = 0;
+        for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+            WaveBlockInfo info;
+            uint32_t used = wave_decode_block(&packed[pos], len - pos, decoded, ADC_READ_LEN, &info);
+            if (used == 0 || info.samples != slot_count[slot] || info.channel != ADC_PATTERN[slot].channel ||
+                memcmp(decoded, slot_codes[slot], info.samples * sizeof(uint16_t)) != 0) {
+                run->codec_ok = false;
+                break;
+            }
+            pos += used;
+        }
+    }
+    run->encode_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(encode_time).count();
+}
+
+static RunResult run_scenario(const Scenario &sc, double seconds) {
+    // Pre-build every DMA frame so only the kernel is timed
+    const uint64_t total_slots = (uint64_t)(seconds * ADC_CONVERSION_FREQ_HZ) / ADC_READ_LEN * ADC_READ_LEN;
+    std::vector<adc_digi_output_data_t> stream(total_slots);
+    std::vector<double> primary_mv; // Unquantized primary input without the ripple, for the reference
+    primary_mv.reserve(total_slots / ADC_PATTERN_LEN + 1);
+    SignalGenerator gen{&sc};
+    uint64_t n = 0;
+    for (uint64_t i = 0; i < total_slots; ++i) {
+        int slot = (int)(i % ADC_PATTERN_LEN);
+        adc_digi_output_data_t d = {};
+        d.type2.channel = ADC_PATTERN[slot].channel;
+        if (slot == 0) {
+            double ripple = gen.ripple_mv(n);
+            double mv = gen.sample_mv(n++);
+            primary_mv.push_back(sc.kind == SignalKind::CAPTURE ? mv : std::min(std::max(mv, 0.0), BENCH_FULL_SCALE_MV) - ripple);
+            d.type2.data = (sc.kind == SignalKind::CAPTURE) ? sc.capture[(n - 1) % sc.capture.size()] : mv_to_code(mv);
+        } else {
+            d.type2.data = secondary_code(slot);
+        }
+        stream[i] = d;
+    }
+
+    // Kernel state, set up exactly like adcProcessingTask (GAPLESS mode)
+    static BatchAccumulator batch;
+    static CycleDetector zc;
+    static CicDecimator cic;
+    static IirChain iir;
+    static WindowRing window;
+    batch = {};
+    batch_reset(&batch);
+    zc_init(&zc, PROCESSING_SAMPLE_FREQ_HZ);
+    cic_init(&cic, ADC_DECIMATION_FACTOR);
+    iir_design(&iir, FILTER_CHAIN_SPEC, sc.filter_sections, PROCESSING_SAMPLE_FREQ_HZ);
+    window_reset(&window, WINDOW_BLOCKS, PROCESSING_SAMPLE_FREQ_HZ);
+    const uint32_t block_slots = BLOCK_SAMPLES * ADC_PATTERN_LEN;
+    uint32_t block_slots_remaining = block_slots;
+
+    RunResult run = {};
+    uint64_t primary_done = 0;    // Primary samples consumed so far
+    uint64_t window_end = 0;      // Primary sample index where the last published window ended
+    using clock = std::chrono::steady_clock;
+    clock::duration kernel_time{};
+    const uint8_t *bytes = (const uint8_t *)stream.data();
+    for (uint64_t frame = 0; frame < total_slots; frame += ADC_READ_LEN) {
+        uint32_t offset = 0;
+        while (offset < (uint32_t)ADC_READ_LEN) {
+            uint32_t chunk = std::min((uint32_t)ADC_READ_LEN - offset, block_slots_remaining);
+            clock::time_point t0 = clock::now();
+            primary_done += accumulate_frame<AdcPipeline>(bytes + (frame + offset) * SOC_ADC_DIGI_RESULT_BYTES, chunk, &batch, &zc, &cic, &iir);
+            kernel_time += clock::now() - t0;
+            offset += chunk;
+            block_slots_remaining -= chunk;
+            if (block_slots_remaining > 0) {
+                break;
+            }
+            block_slots_remaining = block_slots;
+            t0 = clock::now();
+            BlockPartial block;
+            block_close(&batch, &zc, 0, true, &block);
+            window_push(&window, &block);
+            MeasurementResult result = {};
+            run.outcome = window_compute_result(&window, &result, NULL);
+            if (run.outcome == WindowOutcome::VALID) {
+                zc.reference_mv = (int32_t)result.mean_mv;
+            }
+            kernel_time += clock::now() - t0;
+            run.result = result;
+            run.windows++;
+            window_end = primary_done;
+        }
+    }
+    run.kernel_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(kernel_time).count();
+    run.slots = total_slots;
+    run_codec(stream, &run);
+
+    // Reference: two-pass AC RMS over exactly the samples of the last window
+    uint64_t window_len = (uint64_t)window.filled * BLOCK_SAMPLES;
+    uint64_t first = window_end - std::min(window_end, window_len);
+    double mean = 0.0;
+    for (uint64_t i = first; i < window_end; ++i) {
+        mean += primary_mv[i];
+    }
+    mean /= (double)std::max<uint64_t>(window_end - first, 1);
+    double var = 0.0;
+    for (uint64_t i = first; i < window_end; ++i) {
+        var += (primary_mv[i] - mean) * (primary_mv[i] - mean);
+    }
+    run.ref_rms_mv = sqrt(var / (double)std::max<uint64_t>(window_end - first, 1));
+    return run;
+}
+
+static bool load_capture(const char *path, std::vector<uint16_t> *codes) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, len);
+    }
+    fclose(f);
+    // Packed S3 scope captures (.wave): concatenated wave_codec.h blocks
+    std::string name(path);
+    if (name.size() > 5 && name.compare(name.size() - 5, 5, ".wave") == 0) {
+        static uint16_t block[WAVE_MAX_BLOCK_SAMPLES];
+        const uint8_t *in = (const uint8_t *)text.data();
+        size_t pos = 0;
+        while (pos < text.size()) {
+            WaveBlockInfo info;
+            uint32_t used = wave_decode_block(in + pos, (uint32_t)(text.size() - pos), block, WAVE_MAX_BLOCK_SAMPLES, &info);
+            if (used == 0) {
+                fprintf(stderr, "%s: malformed block at byte %zu\n", path, pos);
+                return false;
+            }
+            codes->insert(codes->end(), block, block + info.samples);
+            pos += used;
+        }
+        return !codes->empty();
+    }
+    size_t pos = text.find("\"samples\"");
+    pos = (pos == std::string::npos) ? 0 : text.find('[', pos) + 1;
+    size_t end = text.find(']', pos);
+    if (end == std::string::npos) {
+        end = text.size();
+    }
+    const char *p = text.c_str() + pos;
+    const char *stop = text.c_str() + end;
+    while (p < stop) {
+        char *next;
+        long v = strtol(p, &next, 10);
+        if (next == p) {
+            p++;
+            continue;
+        }
+        if (v < 0 || v >= ADC_RAW_CODE_COUNT) {
+            fprintf(stderr, "%s: raw code %ld out of range\n", path, v);
+            return false;
+        }
+        codes->push_back((uint16_t)v);
+        p = next;
+    }
+    if (codes->empty()) {
+        fprintf(stderr, "%s: no samples\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    double seconds = 10.0;
+    std::vector<Scenario> scenarios = {
+        { "sine_50Hz", SignalKind::SINE, 50.0, 500.0, CURRENT_SENSOR_ZERO_MV, 0.0, 0.0, 0.0, {} },
+        { "sine_217Hz", SignalKind::SINE, 217.3, 300.0, CURRENT_SENSOR_ZERO_MV, 0.0, 0.0, 0.0, {} },
+        { "pwm_chopped_120Hz", SignalKind::PWM_CHOPPED, 120.0, 600.0, CURRENT_SENSOR_ZERO_MV, 0.0, 8000.0, 0.75, {} },
+        { "dc", SignalKind::DC, 0.0, 0.0, CURRENT_SENSOR_ZERO_MV, 2.0, 0.0, 0.0, {} },
+        { "noisy_sine_80Hz", SignalKind::NOISY_SINE, 80.0, 400.0, CURRENT_SENSOR_ZERO_MV, 5.0, 0.0, 0.0, {} },
+    };
+    if (FILTER_AVAILABLE_SECTIONS != 0) {
+        // 10 kHz ESC ripple on a 50 Hz phase current, through every filter section the build has:
+        // the ripple must not reach the RMS, and the DC blocker must keep the sine intact
+        scenarios.push_back({ "ripple_filtered_50Hz", SignalKind::SINE, 50.0, 500.0, CURRENT_SENSOR_ZERO_MV, 0.0, 0.0, 0.0, {},
+                              10000.0, 200.0, FILTER_AVAILABLE_SECTIONS });
+    }
+    build_bench_lut();
+    kernel_build_channel_map();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (arg == "--capture" && i + 1 < argc) {
+            Scenario sc = { std::string("capture:") + argv[i + 1], SignalKind::CAPTURE, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, {} };
+            if (!load_capture(argv[++i], &sc.capture)) {
+                return 2;
+            }
+            scenarios.push_back(sc);
+        } else {
+            fprintf(stderr, "Usage: %s [--seconds N] [--capture file]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seconds * 1000.0 < WINDOW_LENGTH_MS) {
+        fprintf(stderr, "--seconds must cover at least one window (%d ms)\n", WINDOW_LENGTH_MS);
+        return 2;
+    }
+
+    printf("ADC kernel bench: %d Hz x %d channel(s), decimation %d, %d-sample frames, %d ms window, %.0f s per scenario\n",
+           ADC_SAMPLE_FREQ_HZ, ADC_PATTERN_LEN, ADC_DECIMATION_FACTOR, ADC_READ_LEN, WINDOW_LENGTH_MS, seconds);
+    printf("%-28s %10s %8s %9s %9s %8s %8s %9s %8s  %s\n", "scenario", "Msamples/s", "ns/samp",
+           "rms_mV", "ref_mV", "freq_Hz", "ref_Hz", "pack_bits", "enc_ns", "check");
+    int failures = 0;
+    for (const Scenario &sc : scenarios) {
+        RunResult run = run_scenario(sc, seconds);
+        double msps = run.slots / run.kernel_ns * 1e3;
+        double ns_per_sample = run.kernel_ns / run.slots;
+        double rms = run.result.rms_mv;
+        double freq = run.result.freq_dhz / 10.0;
+        bool ok = (run.outcome == WindowOutcome::VALID);
+        // RMS within 0.5 % (or 1 mV of rounding); frequency within 0.2 Hz, or no cycles for DC
+        ok = ok && fabs(rms - run.ref_rms_mv) <= std::max(1.0, 0.005 * run.ref_rms_mv);
+        char ref_freq[16] = "-";
+        if (sc.kind == SignalKind::DC) {
+            ok = ok && run.result.freq_dhz == 0 && (run.result.flags & RESULT_FLAG_NO_CYCLES);
+            snprintf(ref_freq, sizeof(ref_freq), "0");
+        } else if (sc.kind != SignalKind::CAPTURE) {
+            ok = ok && fabs(freq - sc.freq_hz) <= 0.2;
+            snprintf(ref_freq, sizeof(ref_freq), "%.1f", sc.freq_hz);
+        }
+        ok = ok && run.codec_ok; // Lossless round trip through the packed format
+        failures += ok ? 0 : 1;
+        // Packed size in bits per sample (header included; plain 12-bit packing is 12)
+        double pack_bits = run.packed_bytes * 8.0 / run.slots;
+        printf("%-28s %10.1f %8.2f %9u %9.1f %8.1f %8s %9.2f %8.2f  %s\n", sc.name.c_str(), msps, ns_per_sample,
+               run.result.rms_mv, run.ref_rms_mv, freq, ref_freq, pack_bits, run.encode_ns / run.slots,
+               ok ? "PASS" : (run.codec_ok ? "FAIL" : "FAIL (codec)"));
+    }
+    if (SPECTRUM_MODE_ENABLED) {
+        printf("Spectrum captures completed: %u\n", spectrum_captures);
+    }
+    return failures ? 1 : 0;
+}
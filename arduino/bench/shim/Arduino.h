@@ -0,0 +1,20 @@
+#ifndef BENCH_SHIM_ARDUINO_H
+#define BENCH_SHIM_ARDUINO_H
+
+// --- Host shim for the sketch headers (arduino/bench only) ---
+// Just enough of Arduino.h for globals.h and the processing kernel to compile on
+// x86: fixed-width types, math and the std::min/std::max the ESP32 core exposes.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+#endif // BENCH_SHIM_ARDUINO_H
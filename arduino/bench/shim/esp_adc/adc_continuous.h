@@ -0,0 +1,36 @@
+#ifndef BENCH_SHIM_ADC_CONTINUOUS_H
+#define BENCH_SHIM_ADC_CONTINUOUS_H
+
+// Host shim: ESP32-C3 ADC constants and the TYPE2 DMA result layout, as in
+// ESP-IDF 5.x (hal/adc_types.h, soc/soc_caps.h). No driver functions.
+#include <stdint.h>
+
+#define SOC_ADC_DIGI_RESULT_BYTES 4
+#define SOC_ADC_SAMPLE_FREQ_THRES_HIGH 83333
+#define SOC_ADC_SAMPLE_FREQ_THRES_LOW 611
+
+typedef enum { ADC_UNIT_1, ADC_UNIT_2 } adc_unit_t;
+typedef enum {
+    ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4,
+    ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8, ADC_CHANNEL_9,
+} adc_channel_t;
+typedef enum { ADC_ATTEN_DB_0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_12 } adc_atten_t;
+#define ADC_ATTEN_DB_11 ADC_ATTEN_DB_12
+typedef enum { ADC_BITWIDTH_DEFAULT = 0, ADC_BITWIDTH_9 = 9, ADC_BITWIDTH_10, ADC_BITWIDTH_11, ADC_BITWIDTH_12 } adc_bitwidth_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t data : 12;
+            uint32_t reserved12 : 1;
+            uint32_t channel : 3;
+            uint32_t unit : 1;
+            uint32_t reserved17_31 : 15;
+        } type2;
+        uint32_t val;
+    };
+} adc_digi_output_data_t;
+
+typedef struct adc_continuous_ctx_t *adc_continuous_handle_t;
+
+#endif // BENCH_SHIM_ADC_CONTINUOUS_H
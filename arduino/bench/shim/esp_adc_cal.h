@@ -0,0 +1,13 @@
+#ifndef BENCH_SHIM_ESP_ADC_CAL_H
+#define BENCH_SHIM_ESP_ADC_CAL_H
+
+// Host shim: the calibration struct is only declared extern by globals.h. The bench
+// fills adc_raw_to_mv_lut from its own calibration model instead.
+#include <stdint.h>
+
+typedef struct {
+    uint32_t coeff_a;
+    uint32_t coeff_b;
+} esp_adc_cal_characteristics_t;
+
+#endif // BENCH_SHIM_ESP_ADC_CAL_H
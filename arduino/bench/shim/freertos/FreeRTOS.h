@@ -0,0 +1,10 @@
+#ifndef BENCH_SHIM_FREERTOS_H
+#define BENCH_SHIM_FREERTOS_H
+
+// Host shim: types referenced by globals.h declarations only (no scheduler).
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#endif // BENCH_SHIM_FREERTOS_H
@@ -0,0 +1,8 @@
+#ifndef BENCH_SHIM_FREERTOS_TASK_H
+#define BENCH_SHIM_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+
+#endif // BENCH_SHIM_FREERTOS_TASK_H
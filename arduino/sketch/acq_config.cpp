@@ -0,0 +1,110 @@
+#include "acq_config.h"
+
+ResultSnapshot<ConfigStatus> config_status;
+
+// --- Pending Slot ---
+// Written only by the I2C receive handler, read by the ADC task at block boundaries.
+struct PendingConfig {
+    AcquisitionConfig config;
+    uint32_t request; // Accepted writes since boot
+};
+static ResultSnapshot<PendingConfig> pending_config;
+static volatile uint32_t request_sequence = 0; // Sequence of the latest accepted write (I2C side)
+static volatile uint8_t last_reject = 0;       // CONFIG_REJECT_* of the latest write, 0 if accepted
+
+AcquisitionConfig acq_config_defaults() {
+    AcquisitionConfig cfg = {};
+    cfg.sample_freq_hz = ADC_SAMPLE_FREQ_HZ;
+    cfg.window_length_ms = WINDOW_LENGTH_MS;
+    cfg.output_rate_hz = OUTPUT_RATE_HZ;
+    cfg.atten = (uint8_t)ADC_ATTEN;
+    cfg.filter_sections = FILTER_DEFAULT_SECTIONS;
+    return cfg;
+}
+
+// The run-time counterparts of the PipelineConfig static_asserts that depend on these settings
+uint8_t acq_config_validate(const AcquisitionConfig &cfg) {
+    uint8_t reject = 0;
+    uint64_t conversion_hz = (uint64_t)cfg.sample_freq_hz * ADC_PATTERN_LEN;
+    if (conversion_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || conversion_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH ||
+        cfg.sample_freq_hz % ADC_DECIMATION_FACTOR != 0 ||
+        (uint64_t)ADC_READ_LEN * 1000 / conversion_hz < 1 ||
+        (AdcPipeline::HAS_SPECTRUM && cfg.sample_freq_hz != (uint32_t)ADC_SAMPLE_FREQ_HZ)) {
+        // The spectrum capture and FFT bins are sized for the build's rate
+        reject |= CONFIG_REJECT_SAMPLE_RATE;
+    }
+    if (cfg.output_rate_hz == 0 || cfg.output_rate_hz > CONFIG_MAX_OUTPUT_RATE_HZ || cfg.sample_freq_hz % cfg.output_rate_hz != 0) {
+        reject |= CONFIG_REJECT_OUTPUT_RATE;
+    } else {
+        uint32_t span = (uint32_t)cfg.window_length_ms * cfg.output_rate_hz;
+        if (span % 1000 != 0 || span / 1000 < 1 || span / 1000 > (uint32_t)MAX_WINDOW_BLOCKS) {
+            reject |= CONFIG_REJECT_WINDOW;
+        }
+    }
+    if (cfg.atten > ADC_ATTEN_DB_11) {
+        reject |= CONFIG_REJECT_ATTEN;
+    }
+    if ((cfg.filter_sections & ~FILTER_AVAILABLE_SECTIONS) != 0 ||
+        iir_unsupported_sections(FILTER_CHAIN_SPEC, cfg.filter_sections, cfg.sample_freq_hz / ADC_DECIMATION_FACTOR) != 0) {
+        reject |= CONFIG_REJECT_FILTER;
+    }
+    return reject;
+}
+
+uint32_t acq_config_block_slots(const AcquisitionConfig &cfg) {
+    if (MEASUREMENT_MODE == MeasurementMode::GAPLESS) {
+        return cfg.sample_freq_hz / cfg.output_rate_hz * ADC_PATTERN_LEN;
+    }
+    return cfg.sample_freq_hz * ADC_PATTERN_LEN * NUM_CYCLES_AVERAGE / MIN_EXPECTED_FREQ_HZ;
+}
+
+uint32_t acq_config_warmup_slots(const AcquisitionConfig &cfg) {
+    uint32_t slots = cfg.sample_freq_hz * WARMUP_BLOCK_MS / 1000 * ADC_PATTERN_LEN;
+    uint32_t block_slots = acq_config_block_slots(cfg);
+    return (slots == 0 || slots > block_slots) ? block_slots : slots;
+}
+
+uint32_t acq_config_window_blocks(const AcquisitionConfig &cfg) {
+    if (MEASUREMENT_MODE == MeasurementMode::GAPLESS) {
+        return (uint32_t)cfg.window_length_ms * cfg.output_rate_hz / 1000;
+    }
+    return 1;
+}
+
+uint8_t acq_config_request(const AcquisitionConfig &cfg) {
+    uint8_t reject = acq_config_validate(cfg);
+    if (reject == 0) {
+        PendingConfig pending = { cfg, request_sequence + 1 };
+        pending_config.publish(pending);
+        request_sequence = pending.request;
+    }
+    acq_config_reject(reject);
+    return reject;
+}
+
+void acq_config_reject(uint8_t reject) {
+    last_reject = reject;
+}
+
+ConfigState acq_config_state(const ConfigStatus &status, uint8_t *reject) {
+    *reject = last_reject;
+    if (*reject != 0) {
+        return ConfigState::REJECTED;
+    }
+    if (request_sequence != status.applied_request) {
+        return ConfigState::PENDING;
+    }
+    return status.failed ? ConfigState::FAILED : ConfigState::ACTIVE;
+}
+
+bool acq_config_take_pending(AcquisitionConfig *cfg, uint32_t *request) {
+    static uint32_t taken = 0; // ADC task only
+    PendingConfig pending;
+    if (!pending_config.read(&pending) || pending.request == taken) {
+        return false;
+    }
+    taken = pending.request;
+    *cfg = pending.config;
+    *request = pending.request;
+    return true;
+}
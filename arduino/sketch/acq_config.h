@@ -0,0 +1,102 @@
+#ifndef ACQ_CONFIG_H
+#define ACQ_CONFIG_H
+
+#include "globals.h"
+
+// --- Runtime Acquisition Configuration ---
+// The per-session settings the master may change without a reflash (I2C REG_CONFIG).
+// Everything that sizes buffers or selects kernel stages stays compile-time (AdcPipeline
+// in globals.h); this is only the rates, window, attenuation and the choice of filter
+// sections within those limits.
+// A master write is validated in the I2C callback and left in a pending slot; the ADC
+// task applies it at the next block boundary, so no result mixes samples of two
+// configurations: the pending and active configurations are never the same buffer.
+
+struct AcquisitionConfig {
+    uint32_t sample_freq_hz;   // Conversions per second per channel (before decimation)
+    uint16_t window_length_ms; // Signal span covered by each result
+    uint8_t output_rate_hz;    // Results per second (gapless blocks)
+    uint8_t atten;             // adc_atten_t shared by every pattern entry
+    uint8_t filter_sections;   // IIR_SECTION_* bits of FILTER_BIQUADS / the DC blocker that run
+};
+
+enum class ConfigState : uint8_t {
+    ACTIVE = 0,   // The latest write (or the build defaults) is in use
+    PENDING = 1,  // Accepted, waiting for the next block boundary
+    REJECTED = 2, // Failed validation (reject bits say why), the active config is unchanged
+    FAILED = 3,   // The ADC driver refused it; the previous config was restored
+};
+
+const uint8_t CONFIG_REJECT_FORMAT = 1 << 0;      // Wrong payload length or CRC
+const uint8_t CONFIG_REJECT_SAMPLE_RATE = 1 << 1; // Outside the ADC range, not a multiple of the decimation, or fixed by the spectrum stage
+const uint8_t CONFIG_REJECT_OUTPUT_RATE = 1 << 2; // 0, above CONFIG_MAX_OUTPUT_RATE_HZ, or not a whole number of samples per block
+const uint8_t CONFIG_REJECT_WINDOW = 1 << 3;      // Not a multiple of the output period, or more than MAX_WINDOW_BLOCKS blocks
+const uint8_t CONFIG_REJECT_ATTEN = 1 << 4;       // Not an adc_atten_t
+const uint8_t CONFIG_REJECT_FILTER = 1 << 5;      // A section this build lacks, or one above Nyquist at the new rate
+
+// State of the configuration as the ADC task applied it
+struct ConfigStatus {
+    AcquisitionConfig active;
+    uint16_t version;          // Configurations applied since boot (0 = the build defaults)
+    uint32_t applied_request;  // Request sequence of the latest write the ADC task handled
+    bool failed;               // That write was refused by the driver (ConfigState::FAILED)
+};
+
+extern ResultSnapshot<ConfigStatus> config_status; // Published by the ADC task
+
+/**
+ * @brief The build's configuration (globals.h), active at boot.
+ */
+AcquisitionConfig acq_config_defaults();
+
+/**
+ * @brief Checks a configuration against the hardware rate range and the compile-time
+ * pipeline (pattern length, decimation, block ring, filter sections). @return CONFIG_REJECT_* bits, 0 if valid.
+ */
+uint8_t acq_config_validate(const AcquisitionConfig &cfg);
+
+/**
+ * @brief Conversion slots per block: one output period in GAPLESS mode, the legacy batch
+ * (NUM_CYCLES_AVERAGE cycles at MIN_EXPECTED_FREQ_HZ) otherwise.
+ */
+uint32_t acq_config_block_slots(const AcquisitionConfig &cfg);
+
+/**
+ * @brief Conversion slots in the warm-up block that starts each (re)started window:
+ * WARMUP_BLOCK_MS of conversions, at most one regular block.
+ */
+uint32_t acq_config_warmup_slots(const AcquisitionConfig &cfg);
+
+/**
+ * @brief Blocks per window in GAPLESS mode (1 in legacy mode).
+ */
+uint32_t acq_config_window_blocks(const AcquisitionConfig &cfg);
+
+// --- Master side (I2C receive handler) ---
+
+/**
+ * @brief Validates a write and, if valid, makes it the pending configuration
+ * (a later write before the boundary replaces it). @return CONFIG_REJECT_* bits.
+ */
+uint8_t acq_config_request(const AcquisitionConfig &cfg);
+
+/**
+ * @brief Records the latest write as rejected before validation (CONFIG_REJECT_FORMAT),
+ * or clears the rejection (0).
+ */
+void acq_config_reject(uint8_t reject);
+
+/**
+ * @brief Outcome of the latest write; `reject` gets its CONFIG_REJECT_* bits.
+ */
+ConfigState acq_config_state(const ConfigStatus &status, uint8_t *reject);
+
+// --- ADC task side ---
+
+/**
+ * @brief Takes the pending configuration if one arrived since the last call.
+ * @param request Set to the request sequence to report in ConfigStatus.
+ */
+bool acq_config_take_pending(AcquisitionConfig *cfg, uint32_t *request);
+
+#endif // ACQ_CONFIG_H
@@ -1,6 +1,21 @@
 #include "adc_handler.h"
 #include "globals.h"
+#include "adc_kernel.h"
+#include "spectrum.h"
+#include "scope.h"
+#include "logger.h"
+#include "profiler.h"
+#include "benchmark.h"
+#include "stream.h"
+#include "arena.h"
+#include "acq_config.h"
+#include "overcurrent.h"
+#include "i2c_handler.h"
+#include "time_sync.h"
+#include "charge_counter.h"
+#include <esp_timer.h>
 #include <cmath> // For sqrt
+#include <string.h> // For memset
 // #include <esp_adc_cal.h> // Included via globals.h now
 // #include <esp_log.h> // Using Serial.printf instead
 // #include <driver/adc.h> // Removed - adc1_get_raw no longer used
@@ -11,31 +26,79 @@ static const char *TAG = "ADCHandler";
 esp_adc_cal_characteristics_t adc_chars; // Definition for ADC calibration characteristics
 TaskHandle_t adcProcessingTaskHandle = NULL;
 adc_continuous_handle_t adcHandle = NULL;
+ResultSnapshot<MeasurementResult> latest_result;
 
 // static esp_adc_cal_characteristics_t *adc_chars = NULL; // Now a global extern variable `adc_chars`
-// --- Static variables for processing state ---
-static int32_t last_sample_mv = -1; // Initialize to invalid state (Using mV now)
 
-// --- Initialize ADC Continuous Mode & Perform Calibration ---
-bool init_adc() {
-    Serial.printf("I (%s): Initializing ADC and Calibration...\n", TAG);
+// --- DMA Conversion-Done Callback (ISR context) ---
+// Fires once per completed conv frame and wakes the processing task, so the task
+// sleeps exactly until data is available instead of polling on fixed delays.
+// It also dates the frame for the window sample times (Frame Timing below).
+static volatile uint32_t frames_completed = 0;  // Conv frames completed since boot
+static volatile int64_t last_frame_done_us = 0; // esp_timer when the newest one completed
+
+static bool IRAM_ATTR adc_conv_done_callback(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+    last_frame_done_us = esp_timer_get_time(); // Time before count: the reader retries on a count change
+    frames_completed = frames_completed + 1;
+    BaseType_t must_yield = pdFALSE;
+    if (adcProcessingTaskHandle != NULL) { // Task may not exist yet right after adc_continuous_start()
+        vTaskNotifyGiveFromISR(adcProcessingTaskHandle, &must_yield);
+    }
+    return (must_yield == pdTRUE);
+}
 
-    // 1. Check for eFuse Two Point calibration values
-    esp_err_t ret_cal = esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP);
-    if (ret_cal == ESP_ERR_NOT_SUPPORTED) {
-        Serial.printf("E (%s): Calibration scheme not supported by this ESP32-C3!\n", TAG);
-        return false;
-    } else if (ret_cal == ESP_ERR_INVALID_VERSION) {
-        Serial.printf("E (%s): Calibration version mismatch!\n", TAG);
-        return false;
-    } else if (ret_cal != ESP_OK) {
-        Serial.printf("E (%s): eFuse Two Point calibration values not available! Cannot proceed.\n", TAG);
-        return false; // Halt initialization as TP is required by the plan
+// --- DMA Pool Overflow Callback (ISR context) ---
+// The pool was full when a frame completed, so the driver dropped that frame. Counted here
+// (this callback is the only writer), accounted as a gap by the ADC task at its next read.
+static volatile uint32_t pool_overflow_frames = 0;
+
+static bool IRAM_ATTR adc_pool_ovf_callback(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+    pool_overflow_frames = pool_overflow_frames + 1;
+    return false;
+}
+
+// --- Frame Timing (ADC task) ---
+// Every frame the pool holds completed one frame period before the next, and the kernel reads
+// the oldest first: the frame just read was the newest completion minus one period per frame
+// still queued behind it. That dates each conversion from the interrupt, however late the task
+// gets to the frame. Every read from the pool goes through read_pool_frame() so the queue
+// depth stays known; a new or drained pool re-bases it (frame_timing_rebase).
+static uint32_t frames_taken = 0; // Frames read from the pool since boot (plus those it dropped, see rebase)
+
+static esp_err_t read_pool_frame(uint8_t *buffer, uint32_t *bytes_read) {
+    esp_err_t ret = adc_continuous_read(adcHandle, buffer, ADC_CONV_FRAME_SIZE, bytes_read, 0);
+    if (ret == ESP_OK) {
+        frames_taken++;
     }
+    return ret;
+}
 
-    // 2. Characterize ADC using Two Point values
-    Serial.printf("I (%s): eFuse Two Point calibration values available. Characterizing...\n", TAG);
-    // Note: adc_chars is now a global variable, no need to calloc here
+// The pool is empty (drained, or a new handle): everything completed so far is accounted for
+static void frame_timing_rebase() {
+    frames_taken = frames_completed - pool_overflow_frames;
+}
+
+// esp_timer time of the last conversion in the frame just read
+static int64_t frame_end_us(uint32_t frame_period_us) {
+    uint32_t completed;
+    int64_t done_us;
+    do {
+        completed = frames_completed;
+        done_us = last_frame_done_us;
+    } while (completed != frames_completed); // The callback ran in between: read the pair again
+    int32_t queued = (int32_t)(completed - pool_overflow_frames - frames_taken);
+    return done_us - (int64_t)max(queued, (int32_t)0) * frame_period_us;
+}
+
+// Time of conversion slot `slot` of a frame of `slots` that ended at `end_us`
+static int64_t slot_time_us(int64_t end_us, uint32_t slot, uint32_t slots, uint32_t conversion_freq_hz) {
+    return end_us - (int64_t)(slots - 1 - slot) * 1000000 / conversion_freq_hz;
+}
+
+// --- Calibration (eFuse Two Point) -> raw code to mV lookup table ---
+// init_adc() and runtime attenuation changes (ADC task, driver stopped: the kernel is the
+// only reader of the table and runs in the same task).
+static bool build_calibration(adc_atten_t atten) {
     // Convert ADC_BITWIDTH enum for the calibration function
     adc_bits_width_t width_cal;
     switch (ADC_BITWIDTH) {
@@ -43,392 +106,677 @@ bool init_adc() {
         // Add other cases if needed, though C3 likely only supports 12
         default: width_cal = ADC_WIDTH_BIT_12; break;
     }
-    esp_adc_cal_value_t val_type = esp_adc_cal_characterize(ADC_UNIT, ADC_ATTEN, width_cal, 1100, &adc_chars); // Use literal 1100 as fallback (shouldn't be used with TP)
+    esp_adc_cal_value_t val_type = esp_adc_cal_characterize(ADC_UNIT, atten, width_cal, 1100, &adc_chars); // Use literal 1100 as fallback (shouldn't be used with TP)
     if (val_type != ESP_ADC_CAL_VAL_EFUSE_TP) {
-         Serial.printf("E (%s): Characterized using method (%d) other than expected Two Point! Cannot proceed.\n", TAG, val_type);
-         // Consider clearing adc_chars or setting a flag? For now, fail init.
-         return false;
+        return false;
     }
-    Serial.printf("I (%s): Characterized successfully using Two Point Value.\n", TAG);
+    for (uint32_t raw = 0; raw < ADC_RAW_CODE_COUNT; ++raw) {
+        adc_raw_to_mv_lut[raw] = (uint16_t)esp_adc_cal_raw_to_voltage(raw, &adc_chars);
+    }
+    return true;
+}
 
-    // --- Continuous Mode Setup ---
+// --- Continuous Mode Pattern and Rate (driver must be stopped) ---
+static esp_err_t configure_continuous(const AcquisitionConfig &cfg) {
+    adc_digi_pattern_config_t adc_pattern[ADC_PATTERN_LEN] = {};
+    for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+        adc_pattern[slot].atten = cfg.atten;
+        adc_pattern[slot].channel = ADC_PATTERN[slot].channel;
+        adc_pattern[slot].unit = ADC_UNIT;       // Use the unit defined in globals.h
+        adc_pattern[slot].bit_width = ADC_BITWIDTH;
+    }
+
+    // Define the configuration for the continuous mode itself
+    adc_continuous_config_t continuous_cfg = {
+        .pattern_num = ADC_PATTERN_LEN,
+        .adc_pattern = adc_pattern,
+        .sample_freq_hz = cfg.sample_freq_hz * ADC_PATTERN_LEN, // Shared by all pattern entries
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    return adc_continuous_config(adcHandle, &continuous_cfg);
+}
 
+// --- Continuous Driver Bring-up (init_adc, and stall recovery in the ADC task) ---
+// New handle, pattern and rate, callbacks, start. On failure the handle is released and
+// `failed_step` names the step that failed (a static string, for the log).
+static esp_err_t open_continuous(const AcquisitionConfig &cfg, const char **failed_step) {
     adc_continuous_handle_cfg_t adc_config = {
         // Allocate DMA buffer size. Larger can handle higher speeds/longer processing delays.
         // Must be multiple of SOC_ADC_DMA_MAX_BUFFER_SIZE if defined.
         .max_store_buf_size = ADC_DMA_BUF_SIZE, // Use increased buffer size from globals.h
         .conv_frame_size = ADC_CONV_FRAME_SIZE,
-        .flags = 0 // Added to address warning
+        .flags = 0 // No flush_pool: an overflow drops only the frame that did not fit
     };
     esp_err_t ret = adc_continuous_new_handle(&adc_config, &adcHandle);
     if (ret != ESP_OK) {
-        Serial.printf("E (%s): Failed to create ADC continuous handle: %s\n", TAG, esp_err_to_name(ret));
-        return false;
+        *failed_step = "create ADC continuous handle";
+        adcHandle = NULL;
+        return ret;
+    }
+    ret = configure_continuous(cfg);
+    if (ret != ESP_OK) {
+        *failed_step = "configure ADC continuous mode";
+    } else {
+        // Register the frame-ready and overflow callbacks (must happen before adc_continuous_start)
+        adc_continuous_evt_cbs_t adc_callbacks = {
+            .on_conv_done = adc_conv_done_callback,
+            .on_pool_ovf = adc_pool_ovf_callback,
+        };
+        ret = adc_continuous_register_event_callbacks(adcHandle, &adc_callbacks, NULL);
+        if (ret != ESP_OK) {
+            *failed_step = "register ADC event callbacks";
+        } else {
+            ret = adc_continuous_start(adcHandle);
+            if (ret != ESP_OK) {
+                *failed_step = "start ADC continuous mode";
+            }
+        }
     }
-    Serial.printf("I (%s): ADC continuous handle created.\n", TAG);
-
-    // Revert to directly configuring the pattern using globals.h definitions
-    adc_digi_pattern_config_t adc_pattern[1] = {0}; // Only one channel in the pattern
-    adc_pattern[0].atten = ADC_ATTEN;
-    adc_pattern[0].channel = ADC_CHANNEL; // Use the channel defined in globals.h
-    adc_pattern[0].unit = ADC_UNIT;       // Use the unit defined in globals.h
-    adc_pattern[0].bit_width = ADC_BITWIDTH;
-
-    // Define the configuration for the continuous mode itself
-    adc_continuous_config_t continuous_cfg = {
-        .pattern_num = 1,
-        .adc_pattern = adc_pattern,
-        .sample_freq_hz = TARGET_SAMPLE_FREQ_HZ,
-        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
-        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
-    };
-
-    // Pass the correct configuration structure type
-    ret = adc_continuous_config(adcHandle, &continuous_cfg);
     if (ret != ESP_OK) {
-        Serial.printf("E (%s): Failed to configure ADC continuous mode: %s\n", TAG, esp_err_to_name(ret));
         adc_continuous_deinit(adcHandle); // Clean up handle
         adcHandle = NULL;
+    }
+    return ret;
+}
+
+// --- Initialize ADC Continuous Mode & Perform Calibration ---
+bool init_adc() {
+    Serial.printf("I (%s): Initializing ADC and Calibration...\n", TAG);
+
+    // 1. Check for eFuse Two Point calibration values
+    esp_err_t ret_cal = esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP);
+    if (ret_cal == ESP_ERR_NOT_SUPPORTED) {
+        Serial.printf("E (%s): Calibration scheme not supported by this ESP32-C3!\n", TAG);
         return false;
+    } else if (ret_cal == ESP_ERR_INVALID_VERSION) {
+        Serial.printf("E (%s): Calibration version mismatch!\n", TAG);
+        return false;
+    } else if (ret_cal != ESP_OK) {
+        Serial.printf("E (%s): eFuse Two Point calibration values not available! Cannot proceed.\n", TAG);
+        return false; // Halt initialization as TP is required by the plan
     }
-    Serial.printf("I (%s): ADC continuous mode configured. Target Freq: %d Hz\n", TAG, TARGET_SAMPLE_FREQ_HZ);
 
-    ret = adc_continuous_start(adcHandle);
+    // 2. Characterize ADC using Two Point values, 3. build the raw -> mV lookup table
+    Serial.printf("I (%s): eFuse Two Point calibration values available. Characterizing...\n", TAG);
+    if (!build_calibration(ADC_ATTEN)) {
+         Serial.printf("E (%s): Characterized using a method other than expected Two Point! Cannot proceed.\n", TAG);
+         return false;
+    }
+    Serial.printf("I (%s): Characterized successfully using Two Point Value.\n", TAG);
+    Serial.printf("I (%s): mV lookup table built (%d entries, %u..%u mV).\n", TAG,
+                  ADC_RAW_CODE_COUNT, adc_raw_to_mv_lut[0], adc_raw_to_mv_lut[ADC_RAW_CODE_COUNT - 1]);
+
+    // --- Continuous Mode Setup ---
+    // Configure the conversion pattern from the ADC_PATTERN table in globals.h
+    kernel_build_channel_map();
+    for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+        Serial.printf("I (%s): Pattern slot %d: ADC1 channel %d (GPIO%d), role %d\n", TAG,
+                      slot, ADC_PATTERN[slot].channel, ADC_PATTERN[slot].gpio, (int)ADC_PATTERN[slot].role);
+    }
+    const char *failed_step = "";
+    esp_err_t ret = open_continuous(acq_config_defaults(), &failed_step);
     if (ret != ESP_OK) {
-        Serial.printf("E (%s): Failed to start ADC continuous mode: %s\n", TAG, esp_err_to_name(ret));
-        adc_continuous_deinit(adcHandle); // Clean up handle
-        adcHandle = NULL;
+        Serial.printf("E (%s): Failed to %s: %s\n", TAG, failed_step, esp_err_to_name(ret));
         return false;
     }
+    Serial.printf("I (%s): ADC continuous mode configured. Target Freq: %d Hz (%d channel(s) at %d Hz, decimation %d -> %d Hz)\n", TAG,
+                  ADC_CONVERSION_FREQ_HZ, ADC_PATTERN_LEN, ADC_SAMPLE_FREQ_HZ, ADC_DECIMATION_FACTOR, PROCESSING_SAMPLE_FREQ_HZ);
     Serial.printf("I (%s): ADC continuous mode started.\n", TAG);
     return true;
 }
 
-void adcProcessingTask(void *pvParameters) {
-    Serial.printf("I (%s): ADC Processing Task started.\n", TAG);
+// --- Runtime Reconfiguration: Driver Restart (ADC task, at a block boundary) ---
+// adc_continuous_config() refuses a running unit, so a rate or attenuation change stops the
+// driver, reconfigures it (recalibrating the mV table for a new attenuation) and starts it
+// again. Frames still in the pool were converted with the old settings: anything readable
+// right after the start predates it (a new frame takes a full frame period) and is dropped.
+static esp_err_t restart_continuous(const AcquisitionConfig &cfg, bool recalibrate) {
+    esp_err_t ret = adc_continuous_stop(adcHandle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = configure_continuous(cfg);
+    if (ret == ESP_OK && recalibrate && !build_calibration((adc_atten_t)cfg.atten)) {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    if (ret == ESP_OK) {
+        ret = adc_continuous_start(adcHandle);
+    }
+    if (ret == ESP_OK) {
+        uint32_t stale_bytes = 0;
+        while (read_pool_frame(buffer_arena.adc_frame, &stale_bytes) == ESP_OK) {
+        }
+        ulTaskNotifyTake(pdTRUE, 0); // Notifications of the dropped frames
+        frame_timing_rebase();
+    }
+    return ret;
+}
+
+// --- Stall Recovery (ADC task) ---
+// Tear-down and bring-up of the whole driver with the active configuration: the mV table
+// still matches its attenuation, so no recalibration.
+struct StallRecovery {
+    uint32_t failures;        // Failed frame waits (timeouts, read errors) since the last good frame
+    uint32_t attempts;        // Restarts tried since the last good frame
+    uint32_t backoff_ms;      // Wait after this attempt before the next one
+    uint32_t next_attempt_ms; // millis() from which the next attempt may run
+    uint32_t recoveries;      // Restarts that brought frames back, since boot
+};
+
+static void stall_recovery_reset(StallRecovery *s) {
+    s->failures = 0;
+    s->attempts = 0;
+    s->backoff_ms = ADC_RECOVERY_BACKOFF_MIN_MS;
+}
+
+static bool stall_recovery_due(const StallRecovery *s, uint32_t now_ms) {
+    return (adcHandle == NULL || s->failures >= ADC_STALL_FAILURES) && (int32_t)(now_ms - s->next_attempt_ms) >= 0;
+}
 
-    // Calculate max samples for the batch based on lowest expected frequency (20Hz) and average count
-    const uint32_t MAX_SAMPLES_PER_BATCH = (uint32_t)((1.0 / MIN_EXPECTED_FREQ_HZ) * NUM_CYCLES_AVERAGE * TARGET_SAMPLE_FREQ_HZ);
-    Serial.printf("I (%s): Max samples per batch set to %lu\n", TAG, MAX_SAMPLES_PER_BATCH);
+static esp_err_t stall_recover(StallRecovery *s, const AcquisitionConfig &cfg) {
+    s->attempts++;
+    LOG_E(TAG, "ADC stalled (%lu failed frame waits), restarting the driver (attempt %lu)", s->failures, s->attempts);
+    if (adcHandle != NULL) {
+        adc_continuous_stop(adcHandle); // Fails if the driver already stopped itself: nothing to undo
+        adc_continuous_deinit(adcHandle);
+        adcHandle = NULL;
+    }
+    const char *failed_step = "";
+    esp_err_t ret = open_continuous(cfg, &failed_step);
+    if (ret != ESP_OK) {
+        LOG_E(TAG, "ADC restart failed to %s: %s", failed_step, esp_err_to_name(ret));
+    } else {
+        frame_timing_rebase(); // The old pool went with the old handle
+    }
+    ulTaskNotifyTake(pdTRUE, 0); // Notifications from the old handle
+    s->next_attempt_ms = millis() + s->backoff_ms;
+    s->backoff_ms = min(s->backoff_ms * 2, ADC_RECOVERY_BACKOFF_MAX_MS);
+    return ret;
+}
 
+// --- Continuity Break (read timeout/error, dropped frames, legacy discard) ---
+// State that depends on consecutive samples restarts; the block sums keep what they have.
+static void break_continuity(CycleDetector *zc, CicDecimator *cic, IirChain *iir) {
+    zc_reset_edges(zc); // A gap breaks cycle timing continuity
+    cic_reset(cic);
+    iir_reset(iir);
+    spectrum_capture_reset(&spectrum_capture);
+    scope_reset_history();
+    stream_mark_gap();
+}
+
+static uint32_t frame_period_us_at(const AcquisitionConfig &cfg) {
+    return (uint32_t)((uint64_t)ADC_READ_LEN * 1000000 / (cfg.sample_freq_hz * ADC_PATTERN_LEN));
+}
+
+// --- IIR Chain Design (task start and every applied configuration) ---
+static void design_filter(IirChain *iir, const AcquisitionConfig &cfg) {
+    uint32_t processing_freq_hz = cfg.sample_freq_hz / ADC_DECIMATION_FACTOR;
+    if (!iir_design(iir, FILTER_CHAIN_SPEC, cfg.filter_sections, processing_freq_hz)) {
+        // acq_config_validate() rejects such configurations, so only a bad build default gets here
+        LOG_E(TAG, "Filter sections 0x%02X cannot run at %lu Hz, filter bypassed", cfg.filter_sections, processing_freq_hz);
+    }
+}
 
-    uint8_t raw_result_buffer[ADC_CONV_FRAME_SIZE] = {0}; // Buffer to store raw DMA results
-    uint32_t voltage_buffer[ADC_READ_LEN] = {0}; // Buffer to store converted voltage values (mV)
+// --- Boot Milestones (setup() before the ADC task starts, then the ADC task only) ---
+static uint32_t boot_milestone_us[BOOT_MILESTONE_COUNT];
+
+void boot_milestone(BootMilestone milestone) {
+    if (boot_milestone_us[milestone] == 0) {
+        boot_milestone_us[milestone] = (uint32_t)micros();
+    }
+}
+
+static void log_boot_milestones() {
+    LOG_I(TAG, "Boot milestones (us since reset): setup %lu, I2C %lu, ADC %lu, first frame %lu, first result %lu, steady %lu",
+          boot_milestone_us[BOOT_SETUP], boot_milestone_us[BOOT_I2C_READY], boot_milestone_us[BOOT_ADC_STARTED],
+          boot_milestone_us[BOOT_FIRST_FRAME], boot_milestone_us[BOOT_FIRST_RESULT], boot_milestone_us[BOOT_STEADY]);
+}
+
+void adcProcessingTask(void *pvParameters) {
+    LOG_I(TAG, "ADC Processing Task started.");
+
+    LOG_I(TAG, "Max samples per batch set to %lu", MAX_SAMPLES_PER_BATCH);
+    // The build defaults until the master writes a runtime configuration (acq_config.h),
+    // which is swapped in at a block boundary below; everything derived from it is refreshed there.
+    AcquisitionConfig active = acq_config_defaults();
+    static uint16_t config_version = 0; // Configurations applied since boot
+    ConfigStatus boot_status = {};
+    boot_status.active = active;
+    config_status.publish(boot_status);
+    // Block length in conversion slots. Gapless blocks are cut at an exact slot so every
+    // sample lands in exactly one block, and each result covers the last WINDOW_BLOCKS blocks;
+    // legacy mode keeps the original batch length as a single-block (tumbling) window.
+    const bool gapless = (MEASUREMENT_MODE == MeasurementMode::GAPLESS);
+    uint32_t block_slots = acq_config_block_slots(active);
+    static WindowRing window;
+    window_reset(&window, acq_config_window_blocks(active), PROCESSING_SAMPLE_FREQ_HZ);
+    // Warm-up: a short first block gives a provisional result within about one frame, then
+    // results stay provisional until the window holds window.capacity full blocks.
+    uint32_t block_slots_remaining = acq_config_warmup_slots(active);
+    bool warmup_block = block_slots_remaining < block_slots; // The current block is the short one
+    uint32_t full_blocks = 0;                                // Full blocks pushed since the window restarted
+    // Detailed logs once per TARGET_BATCH_INTERVAL_MS instead of once per output
+    uint32_t report_every_blocks = gapless ? max(1, active.output_rate_hz * TARGET_BATCH_INTERVAL_MS / 1000) : 1;
+    uint32_t blocks_since_report = 0;
+    LOG_I(TAG, "Measurement mode: %s, block %lu samples, window %lu blocks (%d Hz output)",
+          gapless ? "GAPLESS" : "LEGACY_DISCARD", block_slots, window.capacity,
+          gapless ? OUTPUT_RATE_HZ : 1000 / TARGET_BATCH_INTERVAL_MS);
+
+
+    uint8_t *raw_result_buffer = buffer_arena.adc_frame; // Raw DMA results (static arena, not the stack)
     uint32_t bytes_read = 0; // Number of bytes read from DMA
 
     // Initialize processing state
-    static bool batch_valid = true; // Flag to track if the current averaging batch is valid
-    static uint32_t samples_in_current_batch = 0; // Counter for total valid samples within the current batch
-    static double sum_mv_current_batch = 0.0;     // Accumulator for sum of mV for the entire batch
-    static double sum_sq_current_batch = 0.0;    // Accumulator for sum of squares of mV for the entire batch
-    static uint32_t valid_samples_in_current_batch = 0; // Counter for valid samples in the entire batch (for DC RMS)
-
-    last_sample_mv = -1;
+    static bool batch_valid = true; // Flag to track if the current block is valid
+    static BatchAccumulator batch = {}; // Sample count and sums for the current block
+    batch_reset(&batch);
+    static uint16_t window_flags = 0;   // RESULT_FLAG_* error bits collected during the current block
+    static CycleDetector zc;            // Zero-crossing frequency detector
+    static uint32_t window_sequence = 0; // Sequence number of the last published window
+    zc_init(&zc, PROCESSING_SAMPLE_FREQ_HZ);
+    static CicDecimator cic;            // High-rate mode decimator (unused when ADC_DECIMATION_FACTOR == 1)
+    cic_init(&cic, ADC_DECIMATION_FACTOR);
+    static IirChain iir;                // DC blocker + biquads (pass-through unless sections are selected)
+    design_filter(&iir, active);
 
     uint8_t consecutive_timeouts = 0;
     uint32_t total_successful_reads = 0;
+    StallRecovery stall = {};
+    stall_recovery_reset(&stall);
+    // DMA pool overflows (adc_pool_ovf_callback): frames lost since boot, and in the current block
+    uint32_t overflow_frames_seen = pool_overflow_frames;
+    uint32_t block_dropped_frames = 0;
+    // esp_timer time of the current block's first conversion, once its first frame was read
+    int64_t block_first_us = 0;
+    bool block_timed = false;
     static unsigned long lastPrintTime = 0; // For throttling voltage print
     
-    Serial.printf("I (%s): ADC Task starting. Sample Rate: %d Hz, Read Length: %d samples, Avg Cycles: %d\n",
-                 TAG, TARGET_SAMPLE_FREQ_HZ, ADC_READ_LEN, NUM_CYCLES_AVERAGE);
+    LOG_I(TAG, "ADC Task starting. Sample Rate: %d Hz (processed at %d Hz), Read Length: %d samples, Avg Cycles: %d",
+          ADC_SAMPLE_FREQ_HZ, PROCESSING_SAMPLE_FREQ_HZ, ADC_READ_LEN, NUM_CYCLES_AVERAGE);
 
     static uint32_t actual_batch_start_time = 0; // Track start time of the batch interval
     if (actual_batch_start_time == 0) { // Initialize on first run
         actual_batch_start_time = millis();
     }
  
-    // Timing statistics for adc_continuous_read within a batch
-    uint64_t batch_read_time_sum_us = 0;
-    uint32_t batch_read_time_min_us = UINT32_MAX;
-    uint32_t batch_read_time_max_us = 0;
-    uint32_t batch_read_count = 0;
-    uint64_t total_batch_samples_read = 0; // Accumulator for total samples read in main loop
-    uint32_t batch_samples_min = UINT32_MAX; // Min samples per main read call
-    uint32_t batch_samples_max = 0;          // Max samples per main read call
- 
-    // Statistics for processing time between main reads
-    uint64_t processing_time_sum_us = 0;
-    uint32_t processing_time_min_us = UINT32_MAX;
-    uint32_t processing_time_max_us = 0;
-    uint32_t processing_read_count = 0; // Count of reads used for processing time calc
-    static uint32_t last_read_complete_time_us = 0; // Time the previous read finished
- 
-    // Timing statistics for adc_continuous_read within the discard loop
-    uint64_t discard_read_time_sum_us = 0;
-    uint32_t discard_read_time_min_us = UINT32_MAX;
-    uint32_t discard_read_time_max_us = 0;
-    uint32_t discard_read_count = 0;
-    uint64_t total_discard_samples_read = 0; // Accumulator for total samples read in discard loop
-    uint32_t discard_samples_min = UINT32_MAX; // Min samples per discard read call
-    uint32_t discard_samples_max = 0;          // Max samples per discard read call
-    uint32_t SAFETY_MARGIN_MS = 3;          // Max samples per discard read call
-    uint32_t theoretical_acquisition_time_ms = (ADC_READ_LEN * 1000.0) / TARGET_SAMPLE_FREQ_HZ;
+    // Timing is collected by the profiler probes (profiler.h) and reported per interval
+    uint32_t last_read_end_cycles = 0; // End of the previous successful read (PROBE_READ_GAP)
+    bool have_last_read = false;
+    // CPU budget: the kernel must finish a frame well within one frame period at the hardware rate
+    uint32_t frame_period_us = AdcPipeline::FRAME_PERIOD_US;
+    // Frames normally arrive every AdcPipeline::FRAME_PERIOD_MS and wake the task via
+    // adc_conv_done_callback. Missing several in a row is treated as a read timeout.
+    TickType_t frame_wait_ticks = pdMS_TO_TICKS(AdcPipeline::FRAME_PERIOD_MS * 4 + 10);
     // uint32_t processing_time_ms = 9 * ADC_READ_LEN / 512; // Removed unused variable
 
     while (1)
     {
-        // uint32_t batch_start_time = millis(); // REMOVED - No longer needed here
-        // Add periodic health report every ~5 seconds (assuming ~5ms per iteration)
-        if (total_successful_reads % 1000 == 0 && total_successful_reads > 0) {
-            Serial.printf("I (%s): ADC Task health: %lu successful reads, %u timeouts in current streak\n",
-                         TAG, total_successful_reads, consecutive_timeouts);
-        }
         if (!adcHandle) {
-             Serial.printf("E (%s): ADC handle is NULL, skipping read.\n", TAG);
-             vTaskDelay(pdMS_TO_TICKS(1000));
+             // A restart left the driver down: retry once the backoff has passed
+             int32_t wait_ms = (int32_t)(stall.next_attempt_ms - millis());
+             if (wait_ms > 0) {
+                 vTaskDelay(pdMS_TO_TICKS(wait_ms));
+             } else if (stall_recover(&stall, active) == ESP_OK) {
+                 window_flags |= RESULT_FLAG_ADC_RESTARTED;
+                 have_last_read = false;
+             }
              continue;
         }
 
-        uint32_t read_start_us = micros(); // Start timing
-        esp_err_t ret = adc_continuous_read(adcHandle, raw_result_buffer, ADC_CONV_FRAME_SIZE, &bytes_read, 30);
-        uint32_t read_end_us = micros(); // End timing
+        uint32_t read_start_cycles = profiler_cycles();
+        // Non-blocking read: frames are drained as soon as the conv-done callback reports them
+        esp_err_t ret = read_pool_frame(raw_result_buffer, &bytes_read);
+        uint32_t read_end_cycles = profiler_cycles();
+
+        if (ret == ESP_ERR_TIMEOUT) {
+            // DMA pool is empty: sleep until the next frame completes. Only a missing
+            // notification within frame_wait_ticks is handled as a real timeout below.
+            if (ulTaskNotifyTake(pdTRUE, frame_wait_ticks) > 0) {
+                continue;
+            }
+        }
  
         if (ret == ESP_OK) {
-            uint32_t duration_us = read_end_us - read_start_us;
-            batch_read_time_sum_us += duration_us;
-            batch_read_time_min_us = min(batch_read_time_min_us, duration_us);
-            batch_read_time_max_us = max(batch_read_time_max_us, duration_us);
-            batch_read_count++;
- 
-            // Calculate samples and update sample stats for the main read
-            int samples_in_buffer = bytes_read / SOC_ADC_DIGI_RESULT_BYTES;
-            total_batch_samples_read += samples_in_buffer;
-            batch_samples_min = min(batch_samples_min, (uint32_t)samples_in_buffer);
-            batch_samples_max = max(batch_samples_max, (uint32_t)samples_in_buffer);
- 
-            // Calculate processing time since last read completed
-            if (last_read_complete_time_us != 0) { // Skip first iteration
-                 uint32_t current_processing_time_us = read_start_us - last_read_complete_time_us;
-                 processing_time_sum_us += current_processing_time_us;
-                 processing_time_min_us = min(processing_time_min_us, current_processing_time_us);
-                 processing_time_max_us = max(processing_time_max_us, current_processing_time_us);
-                 processing_read_count++;
+            profiler_record(PROBE_ADC_READ, read_end_cycles - read_start_cycles);
+            if (have_last_read) {
+                // Processing and waiting since the previous frame was read
+                profiler_record(PROBE_READ_GAP, read_start_cycles - last_read_end_cycles);
             }
-            last_read_complete_time_us = read_end_us; // Store end time for next iteration's calc
+            last_read_end_cycles = read_end_cycles;
+            have_last_read = true;
+            int samples_in_buffer = bytes_read / SOC_ADC_DIGI_RESULT_BYTES;
+            int64_t frame_end = frame_end_us(frame_period_us);
+            uint32_t conversion_freq_hz = active.sample_freq_hz * ADC_PATTERN_LEN;
  
             consecutive_timeouts = 0; // Reset timeout counter on success
-            total_successful_reads++;
-            // Declare sum and count before the loop
-            double voltage_sum = 0.0;
-            int valid_samples = 0;
-            for (int i = 0; i < samples_in_buffer; ++i) {
-                 adc_digi_output_data_t *p = (adc_digi_output_data_t *)&raw_result_buffer[i * SOC_ADC_DIGI_RESULT_BYTES];
-                 if (p->type2.channel == ADC_CHANNEL) {
-                     int32_t raw_adc = p->type2.data; // Declare raw_adc here
-                     // Convert to voltage using ESP-IDF calibration
-                     voltage_buffer[i] = esp_adc_cal_raw_to_voltage(raw_adc, &adc_chars);
-                     // Check if calibration seems valid (basic check)
-                     // Note: esp_adc_cal_raw_to_voltage returns 0 if chars is invalid,
-                     // which might be a valid reading. A more robust check might involve
-                     // checking if adc_chars itself is valid if init failed partially.
-                     // For now, assume init succeeded if we reach here.
-                     voltage_sum += voltage_buffer[i];
-                     valid_samples++;
-                 } else { // Handle unexpected channel data
-                     // Serial.printf("W (%s): Data received from unexpected channel %d\n", TAG, p->type2.channel);
-                     voltage_buffer[i] = UINT32_MAX; // Mark as invalid
-                 }
+            if (stall.attempts > 0) {
+                stall.recoveries++;
+                LOG_I(TAG, "ADC frames back after %lu restart attempt(s) (%lu recoveries since boot)", stall.attempts, stall.recoveries);
             }
-            // Calculate dynamic mean using mV values
-            // double dynamic_mean_level_mv = (valid_samples > 0) ? (voltage_sum / valid_samples) : 0.0; // Removed unused variable
-                    // Serial.printf("D (%s): Buffer Valid Samples: %d, Dynamic Mean: %.2f mV\n", TAG, valid_samples, dynamic_mean_level_mv); // Already commented
-            if (valid_samples == 0) {
-                // Log this specific issue and invalidate the batch
-                Serial.printf("W (%s): Zero valid samples in buffer, invalidating current batch.\n", TAG);
-                batch_valid = false;
+            stall_recovery_reset(&stall);
+            if (++total_successful_reads == 1) {
+                boot_milestone(BOOT_FIRST_FRAME);
             }
-            // --- Process Samples using converted voltages and dynamic mean voltage ---
-            for (int i = 0; i < samples_in_buffer; i++) {
-                // adc_digi_output_data_t *p = (adc_digi_output_data_t *)&raw_result_buffer[i * SOC_ADC_DIGI_RESULT_BYTES]; // No longer needed inside loop
-                // Check if data is from the expected channel using type2 members
-                // Ensure we only process valid, converted samples
-                if (voltage_buffer[i] != UINT32_MAX) {
-                    uint32_t current_mv = voltage_buffer[i]; // Use pre-converted voltage
-                    samples_in_current_batch++; // Increment batch sample counter
-
-
-                    // --- Process Sample ---
-                    double current_mv_double = (double)current_mv;
-
-                    // Also update batch-level accumulators
-                    sum_mv_current_batch += current_mv_double;
-                    sum_sq_current_batch += current_mv_double * current_mv_double;
-                    valid_samples_in_current_batch++;
-                    
-                    // --- Debug Print Voltage (approx once per second) ---
-                    unsigned long currentTime = millis(); // Declare currentTime here
-                    if (currentTime - lastPrintTime >= 1000) {
-                        Serial.printf("D (%s): Sample mV: %lu\n", TAG, current_mv);
-                        lastPrintTime = currentTime;
-                    }
-                    // --- End Debug Print ---
-
-
-                    } // Moved brace from line 248 to here to fix current_mv scope
-                // } // Removed extra brace
-            } // End second for loop (processing samples)
-
-            // --- NEW BATCH COMPLETION CHECK (Based primarily on sample count) ---
-            if (samples_in_current_batch >= MAX_SAMPLES_PER_BATCH) {
-                Serial.printf("D (%s): Batch ended: Sample limit (%lu) reached.\n", TAG, samples_in_current_batch);
-
-                // --- Averaging / Calculation (Conditional on batch validity) ---
-                // DEBUG: Log batch state before averaging
-                // Serial.printf("D (%s): Batch End Check: Valid=%d, CycleCount=%d, ValidSamplesInBatch=%lu\n", TAG, batch_valid, cycle_count, valid_samples_in_current_batch);
-                if (batch_valid) {
-                    if (valid_samples_in_current_batch > 0) {
-                        double batch_mean_mv = sum_mv_current_batch / valid_samples_in_current_batch;
-                        double batch_mean_sq = batch_mean_mv * batch_mean_mv;
-                        double batch_sum_sq_over_n = sum_sq_current_batch / valid_samples_in_current_batch;
-                        float batch_rms_mv = 0.0f;
-                        if (batch_sum_sq_over_n >= batch_mean_sq) {
-                            batch_rms_mv = sqrt(batch_sum_sq_over_n - batch_mean_sq);
+            // Frames the driver dropped while the pool was full: somewhere before this one
+            uint32_t overflow_frames = pool_overflow_frames;
+            if (overflow_frames != overflow_frames_seen) {
+                block_dropped_frames += overflow_frames - overflow_frames_seen;
+                overflow_frames_seen = overflow_frames;
+                break_continuity(&zc, &cic, &iir);
+                have_last_read = false; // The read gap spans the lost frames
+            }
+            // Periodic health report (~every 20 s at one frame per 20 ms)
+            if (total_successful_reads % 1000 == 0) {
+                LOG_I(TAG, "ADC Task health: %lu successful reads, %lu frames lost to DMA pool overflow, %lu driver restarts, %lu time syncs",
+                      total_successful_reads, overflow_frames_seen, stall.recoveries, time_sync_get_status().syncs);
+            }
+            if constexpr (AdcPipeline::HAS_STREAM) {
+                stream_push_frame(raw_result_buffer, samples_in_buffer); // Raw codes to the S3, before any processing
+            }
+            // --- Single pass: decode + filter by channel + accumulate, straight from the DMA bytes ---
+            // The frame is split at every block boundary it contains (a block can be shorter than
+            // a frame at high output rates), so each sample lands in exactly one block.
+            uint32_t frame_offset = 0;
+            uint32_t scope_frame_start_pos = scope_writer.pos;
+            FrameStats frame; // Stats across all chunks, for the scope triggers and the overcurrent check
+            frame_stats_reset(&frame);
+            bool overcurrent_checked = false; // The legacy branch checks the whole frame before its wait
+            uint32_t valid_samples = 0;
+            uint32_t frame_kernel_cycles = 0;
+            while (frame_offset < (uint32_t)samples_in_buffer) {
+                uint32_t chunk_samples = min((uint32_t)samples_in_buffer - frame_offset, block_slots_remaining);
+                if (!block_timed) {
+                    block_first_us = slot_time_us(frame_end, frame_offset, samples_in_buffer, conversion_freq_hz);
+                    block_timed = true;
+                }
+                uint32_t kernel_start_cycles = profiler_cycles();
+                valid_samples += accumulate_frame<AdcPipeline>(raw_result_buffer + frame_offset * SOC_ADC_DIGI_RESULT_BYTES, chunk_samples, &batch, &zc, &cic, &iir);
+                frame_stats_merge(&frame, &batch);
+                frame_kernel_cycles += profiler_cycles() - kernel_start_cycles;
+                frame_offset += chunk_samples;
+                block_slots_remaining -= chunk_samples;
+                if (block_slots_remaining > 0) {
+                    break; // Frame fully consumed inside the current block
+                }
+
+                // --- BLOCK COMPLETION (block length reached, counted in conversion slots) ---
+                uint32_t window_start_cycles = profiler_cycles();
+                block_slots_remaining = block_slots;
+                BlockPartial block;
+                block_close(&batch, &zc, window_flags, batch_valid, &block);
+                block.dropped_frames = block_dropped_frames;
+                block_dropped_frames = 0;
+                block.first_sample_us = block_first_us;
+                block.last_sample_us = slot_time_us(frame_end, frame_offset - 1, samples_in_buffer, conversion_freq_hz);
+                block_timed = false;
+                charge_after_block(&block, active.sample_freq_hz);
+                window_push(&window, &block);
+                bool closed_warmup = warmup_block;
+                warmup_block = false;
+                uint16_t state = RESULT_STATE_WARMING_UP;
+                if (!closed_warmup) {
+                    ++full_blocks;
+                    state = (full_blocks < window.capacity) ? RESULT_STATE_PROVISIONAL : RESULT_STATE_STEADY;
+                }
+                bool report = (++blocks_since_report >= report_every_blocks);
+                if (report) {
+                    blocks_since_report = 0;
+                }
+
+                // --- Window Calculation (over the last window.filled blocks) ---
+                MeasurementResult result = {};
+                result.sequence = ++window_sequence;
+                result.timestamp_ms = millis();
+                result.flags = (gapless ? 0 : RESULT_FLAG_LEGACY_MODE) | state |
+                               (overcurrent_latched() ? RESULT_FLAG_OVERCURRENT : 0);
+                result.config_version = config_version;
+                float window_rms_mv = 0.0f;
+                WindowOutcome outcome = window_compute_result(&window, &result, &window_rms_mv);
+                if (outcome == WindowOutcome::VALID) {
+                    if (report) {
+                        uint32_t rms_cmv = (uint32_t)lroundf(window_rms_mv * 100.0f);
+                        LOG_I(TAG, "Window #%lu: RMS=%lu.%02lumV over %lu samples in %lu blocks (%lu us first to last sample)",
+                              result.sequence, rms_cmv / 100, rms_cmv % 100, window.samples, window.filled,
+                              (uint32_t)(result.window_end_us - result.window_start_us));
+                        LOG_I(TAG, "Window #%lu: Freq=%u.%uHz over %lu cycles (%lu rejected)",
+                              result.sequence, result.freq_dhz / 10, result.freq_dhz % 10, window.cycles, window.rejected_cycles);
+                        LOG_I(TAG, "Window #%lu: Mean=%umV, Min=%umV, Max=%umV, Peak=%umV, Crest=%u.%02u",
+                              result.sequence, result.mean_mv, result.min_mv, result.max_mv, result.peak_mv,
+                              result.crest_x100 / 100, result.crest_x100 % 100);
+                        for (int slot = 1; slot < ADC_PATTERN_LEN; ++slot) {
+                            LOG_I(TAG, "Window #%lu: Channel %d: RMS=%umV, Mean=%umV",
+                                  result.sequence, ADC_PATTERN[slot].channel, result.channel_rms_mv[slot], result.channel_mean_mv[slot]);
                         }
-                        latest_rms_millivolts = (uint16_t)round(batch_rms_mv);
-                        Serial.printf("I (%s): Batch ended: Batch RMS=%.2fmV (%u) over %lu samples\n", TAG,
-                                 batch_rms_mv, latest_rms_millivolts, valid_samples_in_current_batch);
-                    } else {
-                        Serial.printf("W (%s): Batch ended with 0 valid samples. Resetting results.\n", TAG);
-                        latest_rms_millivolts = 0;
+                        if constexpr (AdcPipeline::HAS_POWER) {
+                            LOG_I(TAG, "Window #%lu: Battery=%umV, Power=%ldmW",
+                                  result.sequence, result.battery_mv, result.power_mw);
+                        }
+                    }
+                    // The window mean becomes the crossing reference for the next block
+                    zc.reference_mv = (int32_t)result.mean_mv;
+                } else if (outcome == WindowOutcome::NO_SAMPLES) {
+                    if (report) {
+                        LOG_W(TAG, "Window ended with 0 valid samples. Resetting results.");
                     }
-                } else {
-                    // Log that the average calculation is being skipped due to invalid batch
-                    Serial.printf("W (%s): Batch invalidated during collection, skipping calculation.\n", TAG);
-                    latest_rms_millivolts = 0;
+                } else if (report) {
+                    // Log that the calculation is being skipped due to an invalid block in the window
+                    LOG_W(TAG, "Window contains an invalidated block, skipping calculation.");
+                }
+                if (report && result.dropped_frames > 0) {
+                    LOG_W(TAG, "Window #%lu: %u DMA frames (%lu samples) lost to pool overflow, processing fell behind",
+                          result.sequence, result.dropped_frames, result.dropped_samples);
+                }
+                // On the master's clock once it has written one (time_sync.h)
+                if (time_sync_to_master(&result.window_start_us) && time_sync_to_master(&result.window_end_us)) {
+                    result.flags |= RESULT_FLAG_TIME_SYNCED;
+                }
+                // Invalid windows are still published (zeroed, without RESULT_FLAG_VALID) so the
+                // master sees the sequence advance and can tell a bad window from a stale one.
+                latest_result.publish(result);
+                i2c_stage_result(result); // Encoded once here, not while the master waits
+                if (result.sequence == 1) {
+                    boot_milestone(BOOT_FIRST_RESULT);
+                    LOG_I(TAG, "First result (%s): %lu samples, RMS=%umV", closed_warmup ? "warm-up block" : "one block",
+                          result.sample_count, result.rms_mv);
+                }
+                static bool boot_reported = false;
+                if (state == RESULT_STATE_STEADY && !boot_reported) {
+                    boot_reported = true;
+                    boot_milestone(BOOT_STEADY);
+                    log_boot_milestones();
                 }
 
-                // --- Report ADC Read Timing and Sample Stats ---
-                if (batch_read_count > 0) {
-                    float avg_read_time_us = (float)batch_read_time_sum_us / batch_read_count;
-                    float avg_batch_samples = (float)total_batch_samples_read / batch_read_count;
-                    Serial.printf("I (%s): ADC Main Read Stats (Batch): Count=%lu, TotalSamples=%llu, MinSamples=%lu, MaxSamples=%lu, AvgSamples=%.2f | MinTime=%lu us, MaxTime=%lu us, AvgTime=%.2f us\n", TAG,
-                                  batch_read_count, total_batch_samples_read, batch_samples_min, batch_samples_max, avg_batch_samples,
-                                  batch_read_time_min_us, batch_read_time_max_us, avg_read_time_us);
- 
-                    // --- Report Processing Time Stats ---
-                    if (processing_read_count > 0) {
-                         float avg_processing_time_us = (float)processing_time_sum_us / processing_read_count;
-                         Serial.printf("I (%s): Processing Time Stats (Batch): Count=%lu, Min=%lu us, Max=%lu us, Avg=%.2f us\n", TAG,
-                                       processing_read_count, processing_time_min_us, processing_time_max_us, avg_processing_time_us);
+                // --- Report Timing Probes (once per report interval) ---
+                if (report) {
+                    ProfileSummary probes[PROBE_COUNT];
+                    profiler_log_interval(probes);
+                    const ProfileSummary *kernel = &probes[PROBE_KERNEL];
+                    if (probes[PROBE_ADC_READ].count == 0 && PROFILER_ENABLED) {
+                        LOG_W(TAG, "ADC Read Timing: No successful reads in this interval.");
+                    }
+                    // --- Report Kernel CPU Load (decode + decimate + accumulate vs. frame period) ---
+                    if (kernel->count > 0) {
+                        LOG_I(TAG, "Kernel Load: Frames=%lu, Avg=%lu us, p99=%lu us per %lu us frame -> %lu%% load, %ld%% headroom (p99 frame)",
+                              kernel->count, kernel->avg_us, kernel->p99_us, frame_period_us, kernel->avg_us * 100 / frame_period_us,
+                              100 - (int32_t)(kernel->p99_us * 100 / frame_period_us));
+                    }
+                    uint16_t idle = cpu_idle_update();
+                    if (idle != CPU_IDLE_UNKNOWN) {
+                        LOG_I(TAG, "CPU Idle: %u.%u%%", idle / 10, idle % 10);
+                    }
+                    memory_report_update();
+                    if constexpr (AdcPipeline::HAS_STREAM) {
+                        uint32_t stream_sent, stream_dropped;
+                        stream_get_counters(&stream_sent, &stream_dropped);
+                        LOG_I(TAG, "Stream: %lu frames sent, %lu dropped", stream_sent, stream_dropped);
+                    }
+                }
+                // --- Reset state for the next block ---
+                batch_valid = true; // Assume next block is valid until proven otherwise
+                window_flags = 0;   // (the batch sums were reset by block_close)
+                profiler_record(PROBE_WINDOW, profiler_cycles() - window_start_cycles);
+
+                // --- Runtime Reconfiguration (acq_config.h), only between two blocks ---
+                // The block just published was measured entirely with the old settings; the
+                // window restarts empty, so no result mixes the two configurations.
+                AcquisitionConfig next;
+                uint32_t request;
+                if (acq_config_take_pending(&next, &request)) {
+                    bool recalibrate = next.atten != active.atten;
+                    bool restart = recalibrate || next.sample_freq_hz != active.sample_freq_hz;
+                    esp_err_t cfg_ret = restart ? restart_continuous(next, recalibrate) : ESP_OK;
+                    ConfigStatus status = {};
+                    status.applied_request = request;
+                    if (cfg_ret == ESP_OK) {
+                        active = next;
+                        config_version++;
+                        LOG_I(TAG, "Config #%u applied: %lu Hz, window %u ms, %u Hz output, atten %u, filter 0x%02X (%s)",
+                              config_version, active.sample_freq_hz, active.window_length_ms, active.output_rate_hz,
+                              active.atten, active.filter_sections, restart ? "ADC restarted" : "window only");
                     } else {
-                         Serial.printf("D (%s): Processing Time Stats (Batch): Not enough reads yet.\n", TAG);
+                        LOG_E(TAG, "ADC driver refused config request %lu: %s. Restoring the previous one.",
+                              request, esp_err_to_name(cfg_ret));
+                        status.failed = true;
+                        if (restart_continuous(active, recalibrate) != ESP_OK) {
+                            LOG_E(TAG, "Failed to restore the previous ADC configuration!");
+                        }
+                    }
+                    status.active = active;
+                    status.version = config_version;
+                    config_status.publish(status);
+
+                    uint32_t processing_freq_hz = active.sample_freq_hz / ADC_DECIMATION_FACTOR;
+                    block_slots = acq_config_block_slots(active);
+                    block_slots_remaining = acq_config_warmup_slots(active);
+                    warmup_block = block_slots_remaining < block_slots;
+                    full_blocks = 0;
+                    window_reset(&window, acq_config_window_blocks(active), processing_freq_hz);
+                    design_filter(&iir, active); // Coefficients follow the rate; the state restarts with the window
+                    report_every_blocks = gapless ? max(1, active.output_rate_hz * TARGET_BATCH_INTERVAL_MS / 1000) : 1;
+                    blocks_since_report = 0;
+                    frame_period_us = frame_period_us_at(active);
+                    frame_wait_ticks = pdMS_TO_TICKS(frame_period_us / 1000 * 4 + 10);
+                    if (restart) {
+                        // The driver was stopped and the rest of this frame is dropped: a gap
+                        zc_set_rate(&zc, processing_freq_hz);
+                        cic_reset(&cic);
+                        spectrum_capture_reset(&spectrum_capture);
+                        scope_set_sample_rate(active.sample_freq_hz);
+                        stream_mark_gap();
+                        have_last_read = false;
+                        actual_batch_start_time = millis();
+                        break;
                     }
-                } else {
-                    Serial.printf("W (%s): ADC Read Timing (Batch): No successful reads in this batch.\n", TAG);
                 }
+
+                if (!gapless) {
+                    // --- Legacy: the rest of this frame is dropped, the next batch starts on a fresh frame ---
+                    // Its samples still reach the overcurrent check (with the accumulated part, as one frame)
+                    // and the charge counter, like the discarded frames below
+                    FrameStats tail;
+                    frame_scan_primary(raw_result_buffer + frame_offset * SOC_ADC_DIGI_RESULT_BYTES,
+                                       samples_in_buffer - frame_offset, &tail, &batch.voltage_mv);
+                    frame_stats_merge_raw(&frame, &tail);
+                    overcurrent_after_frame(&frame);
+                    overcurrent_checked = true;
+                    charge_after_discarded_frame(&tail, active.sample_freq_hz,
+                                                 slot_time_us(frame_end, samples_in_buffer - 1, samples_in_buffer, conversion_freq_hz));
+                }
+                if (!gapless && closed_warmup) {
+                    actual_batch_start_time = millis(); // Straight on into the first full batch, no pacing gap
+                } else if (!gapless) {
+                    // --- Legacy: replace Delay with Discard Reads ---
+                    uint32_t batch_end_time = millis();
+                    uint32_t total_batch_duration_ms = batch_end_time - actual_batch_start_time;
+                    int32_t delay_ms = TARGET_BATCH_INTERVAL_MS - total_batch_duration_ms;
  
-                // Reset timing stats for next batch
-                batch_read_time_sum_us = 0;
-                batch_read_time_min_us = UINT32_MAX;
-                batch_read_time_max_us = 0;
-                batch_read_count = 0;
-                total_batch_samples_read = 0; // Reset sample accumulator
-                batch_samples_min = UINT32_MAX; // Reset min samples per call
-                batch_samples_max = 0;          // Reset max samples per call
- 
-                // Reset processing time stats for next batch
-                processing_time_sum_us = 0;
-                processing_time_min_us = UINT32_MAX;
-                processing_time_max_us = 0;
-                processing_read_count = 0;
-                last_read_complete_time_us = 0; // Reset to prevent calculation across batch boundary
-                // --- Reset state for the next batch ---
-                batch_valid = true; // Assume next batch is valid until proven otherwise
-                samples_in_current_batch = 0; // Reset batch sample counter
-                sum_mv_current_batch = 0.0;     // Reset batch accumulators
-                sum_sq_current_batch = 0.0;
-                valid_samples_in_current_batch = 0;
-
-                // --- Replace Delay with Discard Reads ---
-                uint32_t batch_end_time = millis();
-                uint32_t total_batch_duration_ms = batch_end_time - actual_batch_start_time;
-                int32_t delay_ms = TARGET_BATCH_INTERVAL_MS - total_batch_duration_ms;
- 
-                if (delay_ms > 0) {
-                    Serial.printf("D (%s): Total Batch Duration: %lu ms, Entering discard-read loop for %ld ms\n", TAG, total_batch_duration_ms, delay_ms);
-                    uint32_t discard_loop_end_time = millis() + delay_ms;
-                    // Use a static buffer to avoid stack allocation in the loop if preferred,
-                    // but local should be fine given the size and context.
-                    uint8_t discard_buffer[ADC_CONV_FRAME_SIZE]; // Temporary buffer for discarded reads
-                    uint32_t discard_bytes_read = 0;
-                    while (millis() < discard_loop_end_time) {
-                        uint32_t discard_read_start_us = micros(); // Start timing discard read
-                        // Read with minimal timeout (0) to keep ADC active and drain DMA buffer quickly
-                        // We don't strictly need the return value here, but capture it in case of future debugging needs
-                        /* esp_err_t discard_ret = */ adc_continuous_read(adcHandle, discard_buffer, ADC_CONV_FRAME_SIZE, &discard_bytes_read, 30); // Removed unused variable discard_ret
-                        uint32_t discard_read_end_us = micros(); // End timing discard read
+                    if (delay_ms > 0) {
+                        LOG_D(TAG, "Total Batch Duration: %lu ms, Entering discard-read loop for %ld ms", total_batch_duration_ms, delay_ms);
+                        uint32_t discard_loop_end_time = millis() + delay_ms;
+                        // The rest of the current frame is dropped anyway, so its buffer takes the discarded reads
+                        uint8_t *discard_buffer = raw_result_buffer;
+                        uint32_t discard_bytes_read = 0;
+                        while (millis() < discard_loop_end_time) {
+                            uint32_t discard_read_start_cycles = profiler_cycles();
+                            // Read with zero timeout to keep the ADC active and drain the DMA pool quickly
+                            esp_err_t discard_ret = read_pool_frame(discard_buffer, &discard_bytes_read);
+                            uint32_t discard_read_end_cycles = profiler_cycles();
+                            if (discard_ret != ESP_OK) {
+                                // Pool drained: sleep until the conv-done callback reports the next frame
+                                ulTaskNotifyTake(pdTRUE, frame_wait_ticks);
+                                continue;
+                            }
  
-                        // Update discard timing stats
-                        uint32_t discard_duration_us = discard_read_end_us - discard_read_start_us;
-                        discard_read_time_sum_us += discard_duration_us;
-                        discard_read_time_min_us = min(discard_read_time_min_us, discard_duration_us);
-                        discard_read_time_max_us = max(discard_read_time_max_us, discard_duration_us);
-                        discard_read_count++;
-
-                        // Calculate samples and update sample stats for the discard read
-                        int discard_samples_read = discard_bytes_read / SOC_ADC_DIGI_RESULT_BYTES;
-                        total_discard_samples_read += discard_samples_read;
-                        discard_samples_min = min(discard_samples_min, (uint32_t)discard_samples_read);
-                        discard_samples_max = max(discard_samples_max, (uint32_t)discard_samples_read);
-                        vTaskDelay(pdMS_TO_TICKS(theoretical_acquisition_time_ms-SAFETY_MARGIN_MS+2));
-                        // No delay needed here, adc_continuous_read with 0 timeout should return quickly
-                    }
-                    Serial.printf("D (%s): Discard-read loop finished.\n", TAG);
- 
-                    // --- Report Discard Read Timing and Sample Stats ---
-                    if (discard_read_count > 0) {
-                        float avg_discard_read_time_us = (float)discard_read_time_sum_us / discard_read_count;
-                        float avg_discard_samples_read = (float)total_discard_samples_read / discard_read_count;
-                        // Changed Bytes to Samples
-                        Serial.printf("I (%s): ADC Discard Read Stats: Count=%lu, TotalSamples=%llu, MinSamples=%lu, MaxSamples=%lu, AvgSamples=%.2f | MinTime=%lu us, MaxTime=%lu us, AvgTime=%.2f us\n", TAG,
-                                      discard_read_count, total_discard_samples_read, discard_samples_min, discard_samples_max, avg_discard_samples_read,
-                                      discard_read_time_min_us, discard_read_time_max_us, avg_discard_read_time_us);
+                            profiler_record(PROBE_DISCARD_READ, discard_read_end_cycles - discard_read_start_cycles);
+                            // Dropped frames still reach the overcurrent check and the charge counter (decode only, no pipeline state)
+                            FrameStats discarded;
+                            frame_scan_primary(discard_buffer, discard_bytes_read / SOC_ADC_DIGI_RESULT_BYTES, &discarded, &batch.voltage_mv);
+                            overcurrent_after_frame(&discarded);
+                            charge_after_discarded_frame(&discarded, active.sample_freq_hz, frame_end_us(frame_period_us));
+                        }
+                        LOG_D(TAG, "Discard-read loop finished.");
+                        break_continuity(&zc, &cic, &iir); // Dropped frames break cycle timing continuity
+                        overflow_frames_seen = pool_overflow_frames; // The loop drained the pool on purpose
+                        have_last_read = false; // The discard loop is not a read gap
                     } else {
-                         Serial.printf("D (%s): ADC Discard Read Timing: No discard reads performed in this loop.\n", TAG);
+                         LOG_W(TAG, "Batch processing (%lu ms) exceeded target interval (%d ms). No discard loop needed.",
+                               total_batch_duration_ms, TARGET_BATCH_INTERVAL_MS);
+                         // Yield briefly even if overrun to allow other tasks
+                         vTaskDelay(pdMS_TO_TICKS(10));
                     }
-                    // Reset discard timing stats for next potential loop
-                    discard_read_time_sum_us = 0;
-                    discard_read_time_min_us = UINT32_MAX;
-                    discard_read_time_max_us = 0;
-                    discard_read_count = 0;
-                    total_discard_samples_read = 0; // Reset total sample accumulator
-                    discard_samples_min = UINT32_MAX; // Reset min samples per call
-                    discard_samples_max = 0;          // Reset max samples per call
- 
-                } else {
-                     Serial.printf("W (%s): Batch processing (%lu ms) exceeded target interval (%d ms). No discard loop needed.\n",
-                                  TAG, total_batch_duration_ms, TARGET_BATCH_INTERVAL_MS);
-                     // Yield briefly even if overrun to allow other tasks
-                     vTaskDelay(pdMS_TO_TICKS(10));
+                    actual_batch_start_time = millis(); // Update start time for the *next* batch interval
+                    break;
+                }
+            } // --- End of block split loop ---
+            if constexpr (AdcPipeline::HAS_SCOPE) {
+                scope_after_frame(scope_frame_start_pos, frame.min_mv, frame.max_mv,
+                                  frame.samples > 0 ? frame.sum_mv / frame.samples : 0, frame.samples);
+            }
+            if (!overcurrent_checked) {
+                overcurrent_after_frame(&frame);
+            }
+            profiler_record(PROBE_KERNEL, frame_kernel_cycles);
+            if (valid_samples == 0) {
+                // Log this specific issue and invalidate the block
+                LOG_W(TAG, "Zero valid samples in buffer, invalidating current block.");
+                batch_valid = false;
+                window_flags |= RESULT_FLAG_NO_SAMPLES;
+            } else {
+                // --- Debug Print Voltage (approx once per second, checked once per frame) ---
+                unsigned long currentTime = millis();
+                if (currentTime - lastPrintTime >= 1000) {
+                    LOG_D(TAG, "Sample mV: %lu", batch.last_mv);
+                    lastPrintTime = currentTime;
                 }
-                actual_batch_start_time = millis(); // Update start time for the *next* batch interval
-            } // --- End of NEW batch completion block ---
+            }
         }
         else if (ret == ESP_ERR_TIMEOUT) { // Start else if block correctly
              consecutive_timeouts++;
+             stall.failures++;
              batch_valid = false; // Invalidate batch on timeout
+             break_continuity(&zc, &cic, &iir);
+             window_flags |= RESULT_FLAG_READ_TIMEOUT;
              // Only log every few timeouts to avoid flooding the Serial console
              if (consecutive_timeouts == 1 || consecutive_timeouts % 5 == 0) {
-                 Serial.printf("W (%s): ADC Read Timeout #%u! ADC might not be sampling at expected rate.\n",
-                              TAG, consecutive_timeouts);
-                 Serial.printf("D (%s): DMA buffer state - Samples in batch: %lu\n", TAG, samples_in_current_batch);
-             }
-             // Short fixed delay on timeout, interval timing is handled after a *successful* batch completion
-             // vTaskDelay(pdMS_TO_TICKS(50)); // Commented out: Let main loop yield handle it
-             // If we have too many consecutive timeouts, log a warning about potential hardware issues
-             if (consecutive_timeouts == 20) {
-                 Serial.printf("E (%s): 20 consecutive ADC timeouts! Hardware may need attention.\n", TAG);
+                 LOG_W(TAG, "ADC Read Timeout #%u! ADC might not be sampling at expected rate.", consecutive_timeouts);
+                 LOG_D(TAG, "DMA buffer state - Samples in batch: %lu", batch.samples);
              }
         } else { // Handle other errors
-             Serial.printf("E (%s): ADC Read Error: %s. Invalidating current batch.\n", TAG, esp_err_to_name(ret));
+             LOG_E(TAG, "ADC Read Error: %s. Invalidating current batch.", esp_err_to_name(ret));
+             stall.failures++;
              batch_valid = false; // Invalidate batch on other read errors
-             // Consider error handling: re-init ADC?
-             // Short fixed delay on error, interval timing is handled after a *successful* batch completion
-             // vTaskDelay(pdMS_TO_TICKS(50)); // Commented out: Let main loop yield handle it
+             break_continuity(&zc, &cic, &iir);
+             window_flags |= RESULT_FLAG_READ_ERROR;
+             // Wait for the next frame rather than spinning on a persistent error
+             ulTaskNotifyTake(pdTRUE, frame_wait_ticks);
+        }
+        // No frames for ADC_STALL_FAILURES waits: restart the driver (bounded backoff between attempts)
+        if (ret != ESP_OK && stall_recovery_due(&stall, millis()) && stall_recover(&stall, active) == ESP_OK) {
+            window_flags |= RESULT_FLAG_ADC_RESTARTED;
+            have_last_read = false;
         }
-
-        // Removed fixed delay - now handled by calculated delay after batch completion
-        vTaskDelay(pdMS_TO_TICKS(12)); // <-- MOVED INSIDE: Yield control briefly every loop iteration
     } // End while(1)
 } // <-- ADDED: Closing brace for adcProcessingTask function
 
@@ -7,10 +7,12 @@
 
 /**
  * @brief Initializes the ADC in continuous mode with DMA and performs ESP-IDF calibration.
- * Configures the specified channel, attenuation, bitwidth, and sample rate.
+ * Configures every `ADC_PATTERN` channel with the attenuation, bitwidth, and sample rate.
  * Checks for eFuse Two Point calibration data and characterizes the ADC.
- * Stores calibration characteristics in the global `adc_chars`.
- * Starts the ADC conversion process.
+ * Stores calibration characteristics in the global `adc_chars` and builds the
+ * raw code -> mV lookup table used by the processing task.
+ * Registers the `on_conv_done` callback that wakes `adcProcessingTaskHandle` once per
+ * completed DMA frame, then starts the ADC conversion process.
  * @return true if initialization, calibration, and start were successful, false otherwise.
  */
 bool init_adc();
@@ -18,14 +20,58 @@ bool init_adc();
 /**
  * @brief Task function for reading ADC data from the DMA buffer
  * and processing it to calculate frequency and RMS voltage.
- * Reads samples, calculates dynamic mean level (raw ADC), converts samples to mV
- * using ESP-IDF calibration (`esp_adc_cal_raw_to_voltage`), detects zero-crossings,
- * calculates frequency and RMS voltage per cycle, averages results over N cycles,
- * and updates the shared global variables (`latest_freq_hz`, `latest_rms_millivolts`).
+ * The task blocks on its notification until the DMA driver reports a completed
+ * frame, then drains every available frame with non-blocking reads.
+ * Each DMA frame is decoded and accumulated in a single pass: the interleaved
+ * `ADC_PATTERN` stream is demultiplexed by channel (secondary channels into their own
+ * sums, plus V*I power when a battery channel is present), converted to mV using the calibrated lookup table built by `init_adc()`
+ * and folded into the batch sums without an intermediate buffer. With `ADC_HIGH_RATE_MODE`
+ * the ADC runs at `ADC_HIGH_RATE_SAMPLE_FREQ_HZ` and samples pass through a CIC decimator
+ * first, so all processing runs at `PROCESSING_SAMPLE_FREQ_HZ`. With `FILTER_STAGE_ENABLED`
+ * the primary samples then pass through the IIR chain (iir_filter.h: DC blocker and the
+ * `FILTER_BIQUADS` sections the configuration selects) before any sum. The same pass runs a
+ * streaming rising-edge detector against the previous window's mean (with
+ * `ZC_HYSTERESIS_MV` hysteresis and interpolated crossing instants), storing per-cycle
+ * frequency and RMS in the circular buffers from globals.h. Samples are collected in
+ * blocks of one output period; at the end of each block a `MeasurementResult` (RMS from
+ * the window sums, average frequency of the cycles seen or 0 if none, sequence number and
+ * timestamp, mean, min/max, peak and crest factor) is published through `latest_result`. In `MeasurementMode::GAPLESS` every
+ * sample belongs to exactly one block and each result covers the last `WINDOW_BLOCKS`
+ * blocks (`OUTPUT_RATE_HZ` results per second, window sums updated incrementally); in
+ * `MeasurementMode::LEGACY_DISCARD` frames are dropped between batches to pace output.
+ * Read, read-gap, kernel and window times are recorded by the profiler probes (profiler.h)
+ * and reported once per interval, with kernel time against the frame period as CPU load / headroom.
+ * With `SPECTRUM_MODE_ENABLED` the processed samples are also captured for the
+ * spectrum task (spectrum.h); the hand-off never blocks this task.
+ * With `SCOPE_MODE_ENABLED` every raw primary code is also stored in the scope ring
+ * (scope.h), and its level/slope/command triggers are checked once per frame.
+ * A runtime configuration written by the master (acq_config.h) is swapped in between two
+ * blocks: rate and attenuation changes restart the driver (stop / config / start, with a
+ * recalibrated mV table for a new attenuation), and the window restarts empty either way.
+ * After boot and after every reconfiguration the first block is a short warm-up block
+ * (`WARMUP_BLOCK_MS`), and results carry a RESULT_STATE_* warm-up state until the window
+ * is full again; the boot milestones below are logged once the first steady result is out.
  * @param pvParameters Task parameters (unused).
  */
 void adcProcessingTask(void *pvParameters);
 
+// --- Boot Milestones ---
+// Time since reset (micros) at each startup stage, to keep the restart-to-data gap visible.
+enum BootMilestone : uint8_t {
+    BOOT_SETUP = 0,     // setup() entered (after the bootloader and the Arduino core start)
+    BOOT_I2C_READY,     // Slave answering on the bus
+    BOOT_ADC_STARTED,   // Conversions running (init_adc returned)
+    BOOT_FIRST_FRAME,   // First DMA frame read by the ADC task
+    BOOT_FIRST_RESULT,  // First (warm-up) result published
+    BOOT_STEADY,        // First result over a full window
+    BOOT_MILESTONE_COUNT
+};
+
+/**
+ * @brief Records the time of a milestone; only the first call per milestone counts.
+ */
+void boot_milestone(BootMilestone milestone);
+
 // Removed function declarations no longer needed:
 // int32_t read_current_adc_value(); // Mean level is now dynamic
 // float convert_adc_to_mv(int32_t raw_adc); // Using esp_adc_cal_raw_to_voltage directly
@@ -0,0 +1,501 @@
+#include "adc_kernel.h"
+#include "spectrum.h"
+#include "scope.h"
+#include <cmath> // For sqrt
+#include <string.h> // For memset
+
+// --- Define Global Variables (declared extern in globals.h / adc_kernel.h) ---
+float cycle_frequencies[NUM_CYCLES_AVERAGE] = {0};
+float cycle_rms_values[NUM_CYCLES_AVERAGE] = {0};
+int cycle_buffer_index = 0;
+int cycle_count = 0;
+uint16_t adc_raw_to_mv_lut[ADC_RAW_CODE_COUNT];
+uint8_t adc_channel_slot[ADC_MAX_CHANNEL_ID];
+
+void kernel_build_channel_map() {
+    memset(adc_channel_slot, 0xFF, sizeof(adc_channel_slot));
+    for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+        adc_channel_slot[ADC_PATTERN[slot].channel] = (uint8_t)slot;
+    }
+}
+
+void batch_reset(BatchAccumulator *acc) {
+    acc->samples = 0;
+    acc->sum_mv = 0;
+    acc->sum_sq_mv = 0;
+    acc->min_mv = UINT32_MAX;
+    acc->max_mv = 0;
+    memset(acc->channel, 0, sizeof(acc->channel));
+    acc->power_sum = 0;
+    acc->power_samples = 0;
+    acc->raw_sum_mv = 0;
+    acc->raw_samples = 0;
+}
+
+void zc_init(CycleDetector *zc, uint32_t sample_freq_hz) {
+    memset(zc, 0, sizeof(*zc));
+    zc->reference_mv = -(1 << 20); // Disabled until the first window mean is known
+    zc_set_rate(zc, sample_freq_hz);
+}
+
+void zc_set_rate(CycleDetector *zc, uint32_t sample_freq_hz) {
+    // Valid cycle lengths in Q24.8 samples, from the expected frequency range
+    zc->sample_freq_hz = sample_freq_hz;
+    zc->min_period_q8 = (sample_freq_hz << 8) / MAX_EXPECTED_FREQ_HZ;
+    zc->max_period_q8 = (sample_freq_hz << 8) / MIN_EXPECTED_FREQ_HZ;
+    zc->max_cycle_samples = zc->max_period_q8 >> 8;
+    zc_reset_edges(zc);
+}
+
+void window_reset(WindowRing *w, uint32_t capacity, uint32_t sample_freq_hz) {
+    memset(w, 0, sizeof(*w));
+    w->capacity = capacity;
+    w->sample_freq_hz = sample_freq_hz;
+}
+
+void window_push(WindowRing *w, const BlockPartial *block) {
+    if (w->filled == w->capacity) {
+        const BlockPartial *old = &w->blocks[w->head];
+        w->samples -= old->samples;
+        w->sum_mv -= old->sum_mv;
+        w->sum_sq_mv -= old->sum_sq_mv;
+        w->cycles -= old->cycles;
+        w->period_sum_q8 -= old->period_sum_q8;
+        w->rejected_cycles -= old->rejected_cycles;
+        for (int slot = 1; slot < ADC_PATTERN_LEN; ++slot) {
+            w->channel[slot].samples -= old->channel[slot].samples;
+            w->channel[slot].sum_mv -= old->channel[slot].sum_mv;
+            w->channel[slot].sum_sq_mv -= old->channel[slot].sum_sq_mv;
+        }
+        w->power_sum -= old->power_sum;
+        w->power_samples -= old->power_samples;
+        w->dropped_frames -= old->dropped_frames;
+    } else {
+        w->filled++;
+    }
+    w->blocks[w->head] = *block;
+    w->head = (w->head + 1) % w->capacity;
+    w->samples += block->samples;
+    w->sum_mv += block->sum_mv;
+    w->sum_sq_mv += block->sum_sq_mv;
+    w->cycles += block->cycles;
+    w->period_sum_q8 += block->period_sum_q8;
+    w->rejected_cycles += block->rejected_cycles;
+    w->dropped_frames += block->dropped_frames;
+    for (int slot = 1; slot < ADC_PATTERN_LEN; ++slot) {
+        w->channel[slot].samples += block->channel[slot].samples;
+        w->channel[slot].sum_mv += block->channel[slot].sum_mv;
+        w->channel[slot].sum_sq_mv += block->channel[slot].sum_sq_mv;
+    }
+    w->power_sum += block->power_sum;
+    w->power_samples += block->power_samples;
+}
+
+// sqrt(n*sum(x^2) - sum(x)^2) / n
+float ac_rms_mv(uint32_t samples, uint64_t sum_mv, uint64_t sum_sq_mv) {
+    if (samples == 0) {
+        return 0.0f;
+    }
+    uint64_t n = samples;
+    uint64_t n_sum_sq = n * sum_sq_mv;
+    uint64_t sum_sq_of_mean = sum_mv * sum_mv;
+    return (n_sum_sq > sum_sq_of_mean) ? (float)(sqrt((double)(n_sum_sq - sum_sq_of_mean)) / (double)n) : 0.0f;
+}
+
+// --- Cycle Completion (runs once per cycle, not per sample) ---
+// Validates the period against the expected range, then stores the cycle's
+// frequency and AC RMS in the circular buffers declared in globals.h.
+static void zc_complete_cycle(CycleDetector *zc, uint32_t period_q8) {
+    if (period_q8 < zc->min_period_q8 || period_q8 > zc->max_period_q8 || zc->cycle_samples < 2) {
+        zc->window_rejected_cycles++;
+        return;
+    }
+    uint64_t n = zc->cycle_samples;
+    uint64_t n_sum_sq = n * zc->cycle_sum_sq_mv;
+    uint64_t sum_sq_of_mean = (uint64_t)zc->cycle_sum_mv * zc->cycle_sum_mv;
+    float rms_mv = (n_sum_sq > sum_sq_of_mean) ? (float)(sqrt((double)(n_sum_sq - sum_sq_of_mean)) / (double)n) : 0.0f;
+
+    cycle_frequencies[cycle_buffer_index] = ((float)zc->sample_freq_hz * 256.0f) / (float)period_q8;
+    cycle_rms_values[cycle_buffer_index] = rms_mv;
+    cycle_buffer_index = (cycle_buffer_index + 1) % NUM_CYCLES_AVERAGE;
+    cycle_count++;
+    zc->window_cycles++;
+    zc->window_period_sum_q8 += period_q8;
+}
+
+// --- Per-Sample Cycle Detector Step ---
+static inline void zc_step(CycleDetector *zc, int32_t mv) {
+    zc->cycle_samples++;
+    zc->cycle_sum_mv += mv;
+    zc->cycle_sum_sq_mv += (uint32_t)(mv * mv);
+
+    if (mv < zc->reference_mv - ZC_HYSTERESIS_MV) {
+        zc->armed = true;            // Well below the mean: ready for the next rising edge
+        zc->has_candidate = false;
+    } else if (zc->armed) {
+        int32_t ref = zc->reference_mv;
+        if (zc->prev_mv < ref && mv >= ref) {
+            // Upward crossing of the mean: interpolate the fractional instant (one divide per crossing)
+            uint32_t frac_q8 = ((uint32_t)(ref - zc->prev_mv) << 8) / (uint32_t)(mv - zc->prev_mv);
+            zc->candidate_q8 = ((zc->sample_index - 1) << 8) + frac_q8;
+            zc->has_candidate = true;
+        }
+        if (zc->has_candidate && mv >= ref + ZC_HYSTERESIS_MV) {
+            // Edge confirmed by clearing the upper band
+            if (zc->has_last_edge) {
+                zc_complete_cycle(zc, zc->candidate_q8 - zc->last_edge_q8);
+            }
+            zc->last_edge_q8 = zc->candidate_q8;
+            zc->has_last_edge = true;
+            zc->armed = false;
+            zc->has_candidate = false;
+            zc->cycle_samples = 0;
+            zc->cycle_sum_mv = 0;
+            zc->cycle_sum_sq_mv = 0;
+        }
+    }
+    if (zc->cycle_samples > zc->max_cycle_samples) {
+        // No edge for longer than the slowest expected cycle (DC input): restart cleanly
+        zc->has_last_edge = false;
+        zc->cycle_samples = 0;
+        zc->cycle_sum_mv = 0;
+        zc->cycle_sum_sq_mv = 0;
+    }
+    zc->prev_mv = mv;
+    zc->sample_index++;
+}
+
+void zc_reset_edges(CycleDetector *zc) {
+    zc->armed = false;
+    zc->has_candidate = false;
+    zc->has_last_edge = false;
+    zc->cycle_samples = 0;
+    zc->cycle_sum_mv = 0;
+    zc->cycle_sum_sq_mv = 0;
+}
+
+// --- Fused Decode + Accumulate Kernel ---
+// Reads the TYPE2 results in place: no intermediate buffer, one LUT load per sample.
+// Instantiated for the build's PipelineConfig: disabled stages are discarded at compile
+// time, and with several channels each pattern-aligned group is handled with the slot of
+// every sample known at compile time (one channel-id check per group, no per-sample dispatch).
+
+// Per-call partials, merged into the batch once per call (kept in registers once inlined)
+struct FramePartials {
+    uint32_t count;   // Channel samples seen
+    uint32_t outputs; // Samples accumulated (== count without decimation)
+    uint32_t sum;     // 512 * 4095 fits easily in 32 bits
+    uint64_t sum_sq;
+    uint32_t lo;      // Per-call extremes
+    uint32_t hi;
+    uint32_t mv;      // Latest primary sample
+    uint32_t voltage_mv;
+    int64_t power_sum;
+    uint32_t raw_sum; // Primary mV before decimation and filter (charge counter)
+    // Also before decimation and filter (overcurrent check); only kept when they differ from the above
+    uint64_t raw_sum_sq;
+    uint32_t raw_lo;
+    uint32_t raw_hi;
+};
+
+// The processed samples are the raw ones unless the build decimates or filters
+template <typename Cfg>
+static constexpr bool KEEPS_RAW_STATS = Cfg::HAS_DECIMATOR || Cfg::HAS_FILTER;
+
+template <typename Cfg>
+static inline __attribute__((always_inline)) void kernel_primary(FramePartials *f, uint32_t raw, CycleDetector *zc, CicDecimator *cic, IirChain *iir) {
+    uint32_t mv = adc_raw_to_mv_lut[raw]; // 12-bit field, always < ADC_RAW_CODE_COUNT
+    f->mv = mv;
+    f->count++;
+    f->raw_sum += mv;
+    if constexpr (KEEPS_RAW_STATS<Cfg>) {
+        f->raw_sum_sq += mv * mv;
+        f->raw_lo = min(f->raw_lo, mv);
+        f->raw_hi = max(f->raw_hi, mv);
+    }
+    if constexpr (Cfg::HAS_SCOPE) {
+        scope_push(&scope_writer, raw); // Raw code, one store per sample
+    }
+    if constexpr (Cfg::HAS_POWER) {
+        // Instantaneous V*I at the full sample rate: < 2^24 per sample, summed in 64 bits
+        f->power_sum += ((int32_t)mv - CURRENT_SENSOR_ZERO_MV) * (int32_t)f->voltage_mv;
+    }
+    if constexpr (Cfg::HAS_DECIMATOR) {
+        if (!cic_push(cic, mv, &mv)) {
+            return;
+        }
+        f->mv = mv;
+    }
+    if constexpr (Cfg::HAS_FILTER) {
+        mv = iir_push(iir, mv);
+        f->mv = mv;
+    }
+    f->sum += mv;
+    f->sum_sq += mv * mv; // < 2^26 per sample (IIR_OUTPUT_MAX_MV), no overflow in 32 bits
+    f->lo = min(f->lo, mv);
+    f->hi = max(f->hi, mv);
+    f->outputs++;
+    zc_step(zc, (int32_t)mv);
+    if constexpr (Cfg::HAS_SPECTRUM) {
+        spectrum_capture_push(&spectrum_capture, mv);
+    }
+}
+
+template <typename Cfg>
+static inline __attribute__((always_inline)) void kernel_secondary(FramePartials *f, uint32_t slot, uint32_t raw, BatchAccumulator *acc) {
+    uint32_t aux_mv = adc_raw_to_mv_lut[raw];
+    ChannelSums *c = &acc->channel[slot];
+    c->samples++;
+    c->sum_mv += aux_mv;
+    c->sum_sq_mv += aux_mv * aux_mv;
+    if (Cfg::HAS_POWER && (int)slot == Cfg::BATTERY_SLOT) {
+        f->voltage_mv = aux_mv;
+    }
+}
+
+template <typename Cfg>
+uint32_t accumulate_frame(const uint8_t *frame, uint32_t samples, BatchAccumulator *acc, CycleDetector *zc, CicDecimator *cic, IirChain *iir) {
+    static_assert(Cfg::CHANNELS <= ADC_PATTERN_LEN, "Pipeline configuration has more channels than ADC_PATTERN");
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)frame;
+    const adc_digi_output_data_t *end = p + samples;
+    FramePartials f = {};
+    f.lo = UINT32_MAX;
+    f.raw_lo = UINT32_MAX;
+    f.mv = acc->last_mv;
+    f.voltage_mv = acc->voltage_mv;
+
+    if constexpr (!Cfg::HAS_AUX_CHANNELS) {
+        for (; p < end; ++p) {
+            if (adc_channel_slot[p->type2.channel] == 0) { // Drops stray channel ids
+                kernel_primary<Cfg>(&f, p->type2.data, zc, cic, iir);
+            }
+        }
+    } else {
+        while (p < end) {
+            // The driver emits the pattern in order, so groups normally line up after the
+            // first slot-0 sample. A frame that starts mid-pattern (or a skipped conversion)
+            // fails the id check and is walked one sample at a time until back in step.
+            uint32_t mismatch = 1;
+            if (end - p >= Cfg::CHANNELS) {
+                mismatch = 0;
+                for (int slot = 0; slot < Cfg::CHANNELS; ++slot) { // Unrolled: constant bound
+                    mismatch |= p[slot].type2.channel ^ (uint32_t)ADC_PATTERN[slot].channel;
+                }
+            }
+            if (mismatch == 0) {
+                kernel_primary<Cfg>(&f, p[0].type2.data, zc, cic, iir);
+                for (int slot = 1; slot < Cfg::CHANNELS; ++slot) {
+                    kernel_secondary<Cfg>(&f, slot, p[slot].type2.data, acc);
+                }
+                p += Cfg::CHANNELS;
+                continue;
+            }
+            uint32_t slot = adc_channel_slot[p->type2.channel];
+            if (slot == 0) {
+                kernel_primary<Cfg>(&f, p->type2.data, zc, cic, iir);
+            } else if (slot < (uint32_t)Cfg::CHANNELS) {
+                kernel_secondary<Cfg>(&f, slot, p->type2.data, acc);
+            }
+            ++p;
+        }
+    }
+    acc->samples += f.outputs;
+    acc->sum_mv += f.sum;
+    acc->sum_sq_mv += f.sum_sq;
+    acc->min_mv = min(acc->min_mv, f.lo);
+    acc->max_mv = max(acc->max_mv, f.hi);
+    acc->frame_min_mv = f.lo;
+    acc->frame_max_mv = f.hi;
+    acc->frame_sum_mv = f.sum;
+    acc->frame_sum_sq_mv = f.sum_sq;
+    acc->frame_samples = f.outputs;
+    acc->frame_raw_sum_mv = f.raw_sum;
+    acc->frame_raw_samples = f.count;
+    acc->frame_power_sum = f.power_sum;
+    if constexpr (KEEPS_RAW_STATS<Cfg>) {
+        acc->frame_raw_min_mv = f.raw_lo;
+        acc->frame_raw_max_mv = f.raw_hi;
+        acc->frame_raw_sum_sq_mv = f.raw_sum_sq;
+    } else {
+        acc->frame_raw_min_mv = f.lo;
+        acc->frame_raw_max_mv = f.hi;
+        acc->frame_raw_sum_sq_mv = f.sum_sq;
+    }
+    acc->last_mv = f.mv;
+    acc->raw_sum_mv += f.raw_sum;
+    acc->raw_samples += f.count;
+    if constexpr (Cfg::HAS_POWER) {
+        acc->voltage_mv = f.voltage_mv;
+        acc->power_sum += f.power_sum;
+        acc->power_samples += f.count;
+    }
+    return f.count;
+}
+
+// The build's specialization
+template uint32_t accumulate_frame<AdcPipeline>(const uint8_t *, uint32_t, BatchAccumulator *, CycleDetector *, CicDecimator *, IirChain *);
+
+void frame_stats_reset(FrameStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->min_mv = UINT32_MAX;
+    stats->raw_min_mv = UINT32_MAX;
+}
+
+void frame_stats_merge(FrameStats *stats, const BatchAccumulator *acc) {
+    stats->samples += acc->frame_samples;
+    stats->min_mv = min(stats->min_mv, acc->frame_min_mv);
+    stats->max_mv = max(stats->max_mv, acc->frame_max_mv);
+    stats->sum_mv += acc->frame_sum_mv;
+    stats->sum_sq_mv += acc->frame_sum_sq_mv;
+    stats->raw_samples += acc->frame_raw_samples;
+    stats->raw_min_mv = min(stats->raw_min_mv, acc->frame_raw_min_mv);
+    stats->raw_max_mv = max(stats->raw_max_mv, acc->frame_raw_max_mv);
+    stats->raw_sum_mv += acc->frame_raw_sum_mv;
+    stats->raw_sum_sq_mv += acc->frame_raw_sum_sq_mv;
+    stats->power_sum += acc->frame_power_sum;
+}
+
+void frame_stats_merge_raw(FrameStats *stats, const FrameStats *other) {
+    stats->raw_samples += other->raw_samples;
+    stats->raw_min_mv = min(stats->raw_min_mv, other->raw_min_mv);
+    stats->raw_max_mv = max(stats->raw_max_mv, other->raw_max_mv);
+    stats->raw_sum_mv += other->raw_sum_mv;
+    stats->raw_sum_sq_mv += other->raw_sum_sq_mv;
+    stats->power_sum += other->power_sum;
+}
+
+void frame_scan_primary(const uint8_t *frame, uint32_t samples, FrameStats *stats, uint32_t *voltage_mv) {
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)frame;
+    frame_stats_reset(stats);
+    uint32_t battery_mv = *voltage_mv;
+    for (uint32_t i = 0; i < samples; ++i) {
+        uint32_t slot = adc_channel_slot[p[i].type2.channel];
+        uint32_t mv = adc_raw_to_mv_lut[p[i].type2.data];
+        if (slot != 0) {
+            if (AdcPipeline::HAS_POWER && (int)slot == AdcPipeline::BATTERY_SLOT) {
+                battery_mv = mv;
+            }
+            continue;
+        }
+        stats->samples++;
+        stats->min_mv = min(stats->min_mv, mv);
+        stats->max_mv = max(stats->max_mv, mv);
+        stats->sum_mv += mv;
+        stats->sum_sq_mv += mv * mv;
+        if constexpr (AdcPipeline::HAS_POWER) {
+            stats->power_sum += ((int32_t)mv - CURRENT_SENSOR_ZERO_MV) * (int32_t)battery_mv;
+        }
+    }
+    *voltage_mv = battery_mv;
+    // Nothing is decimated or filtered here: the raw stats are the same samples
+    stats->raw_samples = stats->samples;
+    stats->raw_min_mv = stats->min_mv;
+    stats->raw_max_mv = stats->max_mv;
+    stats->raw_sum_mv = stats->sum_mv;
+    stats->raw_sum_sq_mv = stats->sum_sq_mv;
+}
+
+void block_close(BatchAccumulator *acc, CycleDetector *zc, uint16_t flags, bool valid, BlockPartial *out) {
+    memset(out, 0, sizeof(*out));
+    out->samples = acc->samples;
+    out->sum_mv = acc->sum_mv;
+    out->sum_sq_mv = acc->sum_sq_mv;
+    out->min_mv = acc->min_mv;
+    out->max_mv = acc->max_mv;
+    out->cycles = zc->window_cycles;
+    out->period_sum_q8 = zc->window_period_sum_q8;
+    out->rejected_cycles = zc->window_rejected_cycles;
+    out->flags = flags;
+    out->valid = valid;
+    memcpy(out->channel, acc->channel, sizeof(out->channel));
+    out->power_sum = acc->power_sum;
+    out->power_samples = acc->power_samples;
+    out->raw_sum_mv = acc->raw_sum_mv;
+    out->raw_samples = acc->raw_samples;
+    batch_reset(acc);
+    zc->window_cycles = 0;
+    zc->window_period_sum_q8 = 0;
+    zc->window_rejected_cycles = 0;
+    cycle_count = 0;
+}
+
+// --- Window Calculation (over the last w->filled blocks) ---
+// Min/max and flags are combined per block (O(blocks), once per output);
+// the sums come from the incremental window totals.
+WindowOutcome window_compute_result(const WindowRing *w, MeasurementResult *result, float *rms_mv) {
+    uint32_t window_min_mv = UINT32_MAX;
+    uint32_t window_max_mv = 0;
+    uint16_t flags = 0;
+    bool window_valid = true;
+    for (uint32_t i = 0; i < w->filled; ++i) {
+        const BlockPartial *b = &w->blocks[i];
+        window_min_mv = min(window_min_mv, b->min_mv);
+        window_max_mv = max(window_max_mv, b->max_mv);
+        flags |= b->flags;
+        window_valid = window_valid && b->valid;
+    }
+    result->sample_count = w->samples;
+    result->flags |= flags;
+    if (w->filled > 0) {
+        // The oldest block is the one the next push evicts (slot 0 until the window is full)
+        result->window_start_us = w->blocks[w->filled == w->capacity ? w->head : 0].first_sample_us;
+        result->window_end_us = w->blocks[(w->head + w->capacity - 1) % w->capacity].last_sample_us;
+    }
+    if (w->dropped_frames > 0) {
+        // Reported even for an invalid window: the master needs to see the overload
+        result->dropped_frames = (uint16_t)min(w->dropped_frames, (uint32_t)UINT16_MAX);
+        result->dropped_samples = w->dropped_frames * ADC_READ_LEN;
+        result->flags |= RESULT_FLAG_SAMPLES_DROPPED;
+    }
+    if (!window_valid) {
+        return WindowOutcome::INVALID_BLOCK;
+    }
+    if (w->samples == 0) {
+        result->flags |= RESULT_FLAG_NO_SAMPLES;
+        return WindowOutcome::NO_SAMPLES;
+    }
+    // Variance scaled by n^2, computed exactly in integers:
+    // n*sum(x^2) - sum(x)^2 (both terms < 2^63 for a window of 12-bit mV samples).
+    // The only float work is the single sqrt per output.
+    float window_rms_mv = ac_rms_mv(w->samples, w->sum_mv, w->sum_sq_mv);
+    if (rms_mv) {
+        *rms_mv = window_rms_mv;
+    }
+    result->rms_mv = (uint16_t)round(window_rms_mv);
+    uint32_t mean_mv = (uint32_t)((w->sum_mv + w->samples / 2) / w->samples);
+    result->mean_mv = (uint16_t)mean_mv;
+    result->peak_mv = (uint16_t)max(window_max_mv - mean_mv, mean_mv - window_min_mv);
+    result->min_mv = (uint16_t)window_min_mv;
+    result->max_mv = (uint16_t)window_max_mv;
+    // Crest factor of the AC component: peak deviation over AC RMS
+    if (window_rms_mv > 0.0f) {
+        float crest_x100 = roundf(result->peak_mv * 100.0f / window_rms_mv);
+        result->crest_x100 = (crest_x100 < 65535.0f) ? (uint16_t)crest_x100 : 65535;
+    }
+    // Per-channel stats: slot 0 is the primary, the others come from their window sums
+    result->channel_count = ADC_PATTERN_LEN;
+    result->channel_rms_mv[0] = result->rms_mv;
+    result->channel_mean_mv[0] = result->mean_mv;
+    for (int slot = 1; slot < ADC_PATTERN_LEN; ++slot) {
+        const ChannelSums *c = &w->channel[slot];
+        result->channel_rms_mv[slot] = (uint16_t)round(ac_rms_mv(c->samples, c->sum_mv, c->sum_sq_mv));
+        result->channel_mean_mv[slot] = (c->samples > 0) ? (uint16_t)((c->sum_mv + c->samples / 2) / c->samples) : 0;
+    }
+    if constexpr (AdcPipeline::HAS_POWER) {
+        result->battery_mv = (uint16_t)min((uint32_t)result->channel_mean_mv[AdcPipeline::BATTERY_SLOT] * BATTERY_DIVIDER_RATIO_X1000 / 1000, (uint32_t)UINT16_MAX);
+        if (w->power_samples > 0) {
+            // mean((mV - zero) * pin mV) -> mA * battery mV / 1000 = mW
+            double mean_product = (double)w->power_sum / w->power_samples;
+            result->power_mw = (int32_t)lround(mean_product * CURRENT_SENSOR_MA_PER_MV * BATTERY_DIVIDER_RATIO_X1000 / 1e6);
+        }
+    }
+    // Average frequency over the window = cycles / total time spanned by them.
+    // Frequency 0 means no valid cycles (e.g. DC input).
+    float freq_hz = 0.0f;
+    if (w->cycles > 0) {
+        freq_hz = (float)((double)w->cycles * w->sample_freq_hz * 256.0 / (double)w->period_sum_q8);
+    }
+    result->freq_dhz = (uint16_t)round(freq_hz * 10.0f);
+    result->flags |= RESULT_FLAG_VALID | (w->cycles == 0 ? RESULT_FLAG_NO_CYCLES : 0);
+    return WindowOutcome::VALID;
+}
@@ -0,0 +1,256 @@
+#ifndef ADC_KERNEL_H
+#define ADC_KERNEL_H
+
+#include "globals.h"
+#include "decimator.h"
+#include "iir_filter.h"
+
+// --- ADC Processing Kernel ---
+// Per-frame processing of the TYPE2 DMA stream: decode, demultiplex, calibrate, CIC,
+// IIR filter chain, batch sums, zero-crossing detection, block ring and window results. Nothing here
+// calls FreeRTOS, ESP-IDF drivers or Arduino runtime functions, so the same code runs
+// in adcProcessingTask and in the host benchmark (arduino/bench).
+
+// Calibrated raw code -> mV table. Built once from adc_chars by init_adc() (or from a
+// synthetic calibration on the host). Replaces a per-sample esp_adc_cal_raw_to_voltage()
+// call (no FPU on the C3).
+extern uint16_t adc_raw_to_mv_lut[ADC_RAW_CODE_COUNT];
+// ADC channel id -> ADC_PATTERN slot, 0xFF for channels not in the pattern.
+extern uint8_t adc_channel_slot[ADC_MAX_CHANNEL_ID];
+
+// --- Secondary channel sums (pattern slots 1..N-1, full rate, no decimation) ---
+struct ChannelSums {
+    uint32_t samples;
+    uint64_t sum_mv;
+    uint64_t sum_sq_mv;
+};
+
+// --- Batch accumulator state ---
+// Exact integer accumulators (no FPU on the C3). Worst case per batch:
+// 25000 samples * 4095 mV^2 ~= 4.2e11, far below the uint64_t range.
+struct BatchAccumulator {
+    uint32_t samples;   // Valid samples (from the primary channel, after decimation) in the batch
+    uint64_t sum_mv;    // Sum of mV
+    uint64_t sum_sq_mv; // Sum of mV^2
+    uint32_t min_mv;    // Smallest sample in the batch
+    uint32_t max_mv;    // Largest sample in the batch
+    uint32_t last_mv;   // Most recent sample, for debug output
+    // Stats of the most recent accumulate_frame() call only (per-frame triggers)
+    uint32_t frame_min_mv;
+    uint32_t frame_max_mv;
+    uint32_t frame_sum_mv;
+    uint64_t frame_sum_sq_mv;
+    uint32_t frame_samples;
+    // The same before decimation and filter (overcurrent check)
+    uint32_t frame_raw_min_mv;
+    uint32_t frame_raw_max_mv;
+    uint32_t frame_raw_sum_mv;
+    uint64_t frame_raw_sum_sq_mv;
+    uint32_t frame_raw_samples;
+    int64_t frame_power_sum;
+    ChannelSums channel[RESULT_MAX_CHANNELS]; // Secondary pattern entries (slot 0 unused)
+    uint32_t voltage_mv;    // Latest battery-divider sample (pin mV), paired with each current sample
+    int64_t power_sum;      // Sum of (current mV - zero) * voltage pin mV over primary samples
+    uint32_t power_samples;
+    // Every primary sample at the conversion rate, before decimation and filter (charge counter)
+    uint64_t raw_sum_mv;
+    uint32_t raw_samples;
+};
+
+// --- Per-Frame Primary Stats (the per-frame checks: scope triggers, overcurrent) ---
+// A whole DMA frame, merged from the accumulate_frame() calls it was split into. The plain
+// fields are the processed samples the scope triggers on; the raw_* fields are every sample
+// before decimation and filter, so the overcurrent check does not depend on the filter setting.
+struct FrameStats {
+    uint32_t samples;
+    uint32_t min_mv;
+    uint32_t max_mv;
+    uint32_t sum_mv;
+    uint64_t sum_sq_mv;
+    uint32_t raw_samples;
+    uint32_t raw_min_mv;
+    uint32_t raw_max_mv;
+    uint32_t raw_sum_mv;
+    uint64_t raw_sum_sq_mv;
+    int64_t power_sum; // Sum of (current mV - zero) * battery pin mV over the raw samples (HAS_POWER builds)
+};
+
+// --- Zero-Crossing Cycle Detector State ---
+// Streaming rising-edge detector against the previous window's mean. An edge only
+// counts after the signal has been below (reference - ZC_HYSTERESIS_MV) and then
+// rises above (reference + ZC_HYSTERESIS_MV), which rejects noise around the mean.
+// The crossing instant is linearly interpolated between the two samples that
+// straddle the reference and kept in Q24.8 sample units.
+struct CycleDetector {
+    int32_t reference_mv;     // Crossing level; negative (disabled) until the first window mean is known
+    bool armed;               // Signal went below the hysteresis band since the last edge
+    bool has_candidate;       // An upward crossing of the reference was seen while armed
+    bool has_last_edge;       // last_edge_q8 holds a confirmed edge
+    int32_t prev_mv;
+    uint32_t sample_index;    // Detector sample clock (wraps; only differences are used)
+    uint32_t candidate_q8;    // Interpolated instant of the latest upward crossing
+    uint32_t last_edge_q8;    // Interpolated instant of the previous confirmed edge
+    // Per-cycle accumulators (reset at each confirmed edge)
+    uint32_t cycle_samples;
+    uint32_t cycle_sum_mv;    // <= 1250 samples * 4095 mV, fits in 32 bits
+    uint64_t cycle_sum_sq_mv;
+    // Per-block totals, moved into the window ring when the block closes
+    uint32_t window_cycles;
+    uint64_t window_period_sum_q8;
+    uint32_t window_rejected_cycles;
+    // Valid cycle lengths for the processing rate (zc_set_rate)
+    uint32_t sample_freq_hz;
+    uint32_t min_period_q8;
+    uint32_t max_period_q8;
+    uint32_t max_cycle_samples;
+};
+
+// --- Sliding Window Block Ring ---
+// A window is the last `capacity` blocks of BLOCK_SAMPLES conversion slots. Each
+// closed block stores its partial sums; the window totals are kept incrementally
+// (add the newest block, subtract the one it evicts), so the cost per output does
+// not grow with the overlap. Integer sums make the subtraction exact.
+struct BlockPartial {
+    uint32_t samples;
+    uint64_t sum_mv;
+    uint64_t sum_sq_mv;
+    uint32_t min_mv;
+    uint32_t max_mv;
+    uint32_t cycles;          // Valid cycles that completed in this block
+    uint64_t period_sum_q8;   // Sum of their periods (Q24.8 samples)
+    uint32_t rejected_cycles;
+    uint16_t flags;           // RESULT_FLAG_* error bits seen while the block was collected
+    bool valid;               // No read timeout/error during the block
+    uint32_t dropped_frames;  // DMA frames lost to pool overflows while the block was collected
+    int64_t first_sample_us;  // esp_timer time of the block's first and last conversion slot
+    int64_t last_sample_us;
+    ChannelSums channel[RESULT_MAX_CHANNELS]; // Secondary pattern entries
+    int64_t power_sum;
+    uint32_t power_samples;
+    uint64_t raw_sum_mv;      // Primary samples before decimation and filter (charge counter)
+    uint32_t raw_samples;
+};
+
+struct WindowRing {
+    BlockPartial blocks[MAX_WINDOW_BLOCKS];
+    uint32_t capacity;        // Blocks per window (1 = tumbling windows)
+    uint32_t sample_freq_hz;  // Processing rate of the blocks, for the window frequency
+    uint32_t head;            // Slot the next closed block is written to
+    uint32_t filled;          // Blocks currently in the window (< capacity until the first window is full)
+    // Running totals over the filled blocks
+    uint32_t samples;
+    uint64_t sum_mv;
+    uint64_t sum_sq_mv;
+    uint32_t cycles;
+    uint64_t period_sum_q8;
+    uint32_t rejected_cycles;
+    ChannelSums channel[RESULT_MAX_CHANNELS];
+    int64_t power_sum;
+    uint32_t power_samples;
+    uint32_t dropped_frames;
+};
+
+enum class WindowOutcome : uint8_t {
+    VALID,         // Result computed (RESULT_FLAG_VALID set)
+    NO_SAMPLES,    // Every block was valid but held no samples (RESULT_FLAG_NO_SAMPLES set)
+    INVALID_BLOCK, // A block in the window saw a read timeout/error: result left zeroed
+};
+
+/**
+ * @brief Fills adc_channel_slot from ADC_PATTERN.
+ */
+void kernel_build_channel_map();
+
+/**
+ * @brief Clears the per-block sums of a batch (keeps the latest sample/voltage).
+ */
+void batch_reset(BatchAccumulator *acc);
+
+/**
+ * @brief Clears a cycle detector for `sample_freq_hz` processed samples per second;
+ * crossings stay disabled until a reference is set.
+ */
+void zc_init(CycleDetector *zc, uint32_t sample_freq_hz);
+
+/**
+ * @brief Switches the detector to a new processing rate (runtime reconfiguration).
+ * Keeps the crossing reference, drops cycle timing continuity.
+ */
+void zc_set_rate(CycleDetector *zc, uint32_t sample_freq_hz);
+
+/**
+ * @brief Drops cycle timing continuity after a gap in the sample stream.
+ */
+void zc_reset_edges(CycleDetector *zc);
+
+/**
+ * @brief Fused decode + accumulate kernel over `samples` TYPE2 results of one DMA frame,
+ * specialized for the pipeline configuration `Cfg` (instantiated for AdcPipeline).
+ * Demultiplexes the pattern, converts through the LUT and folds primary samples into the
+ * batch sums and the cycle detector (after the CIC decimator in high-rate mode, and through
+ * the IIR chain when `Cfg` has the filter stage). Secondary
+ * channels only update their ChannelSums; with a battery channel each primary sample is
+ * multiplied by the latest voltage sample for the power sum. Feeds the spectrum capture
+ * and the scope ring when `Cfg` enables those stages.
+ * @return Number of samples taken from the primary channel (before decimation).
+ */
+template <typename Cfg>
+uint32_t accumulate_frame(const uint8_t *frame, uint32_t samples, BatchAccumulator *acc, CycleDetector *zc, CicDecimator *cic, IirChain *iir);
+
+/**
+ * @brief Resets `stats` for a new frame.
+ */
+void frame_stats_reset(FrameStats *stats);
+
+/**
+ * @brief Adds the stats of the latest accumulate_frame() call to `stats`.
+ */
+void frame_stats_merge(FrameStats *stats, const BatchAccumulator *acc);
+
+/**
+ * @brief Adds the raw stats (and power sum) of a frame_scan_primary() result to `stats`, for
+ * the unaccumulated rest of a frame; the processed stats keep covering the accumulated part.
+ */
+void frame_stats_merge_raw(FrameStats *stats, const FrameStats *other);
+
+/**
+ * @brief Primary-channel stats of a frame that is not accumulated (decode and LUT only,
+ * no decimator, filter or detector state is touched), for frames the legacy discard loop drops.
+ * @param voltage_mv Latest battery sample, paired with each current sample like the kernel
+ * does; updated from the frame (HAS_POWER builds, else unused).
+ */
+void frame_scan_primary(const uint8_t *frame, uint32_t samples, FrameStats *stats, uint32_t *voltage_mv);
+
+/**
+ * @brief Closes the current block: moves the batch and cycle-detector block totals into
+ * `out` and resets them for the next block.
+ * @param flags RESULT_FLAG_* error bits seen while the block was collected.
+ * @param valid false if a read timeout/error occurred during the block.
+ */
+void block_close(BatchAccumulator *acc, CycleDetector *zc, uint16_t flags, bool valid, BlockPartial *out);
+
+/**
+ * @brief Empties the window and sets its length (blocks) and the processing rate of the blocks.
+ */
+void window_reset(WindowRing *w, uint32_t capacity, uint32_t sample_freq_hz);
+
+/**
+ * @brief Adds a closed block to the window, evicting the oldest one once the window is full.
+ */
+void window_push(WindowRing *w, const BlockPartial *block);
+
+/**
+ * @brief AC RMS (standard deviation) from exact integer sums.
+ */
+float ac_rms_mv(uint32_t samples, uint64_t sum_mv, uint64_t sum_sq_mv);
+
+/**
+ * @brief Computes the window statistics into `result` (sample count, RMS, frequency,
+ * mean, min/max, peak, crest factor, per-channel stats, battery voltage and power, the
+ * combined block flags, and the first/last sample times of the oldest/newest block).
+ * Sequence is left to the caller.
+ * @param rms_mv Unrounded primary RMS (mV), may be NULL.
+ */
+WindowOutcome window_compute_result(const WindowRing *w, MeasurementResult *result, float *rms_mv);
+
+#endif // ADC_KERNEL_H
@@ -0,0 +1,57 @@
+#include "arena.h"
+#include "logger.h"
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+
+static const char *TAG = "Memory";
+
+DMA_ATTR BufferArena buffer_arena;
+ResultSnapshot<MemoryReport> latest_memory;
+
+static TaskHandle_t loop_task_handle = NULL;
+
+static const char *const MEMORY_TASK_NAMES[MEMORY_TASK_COUNT] = { "ADC", "Spectrum", "Log", "LED", "Loop" };
+
+void init_memory_diagnostics() {
+    loop_task_handle = xTaskGetCurrentTaskHandle(); // setup() runs in the Arduino loop task
+    Serial.printf("I (%s): Buffer arena %u bytes (ADC frame %u, stream %u), task stacks ADC %lu / spectrum %lu / log %lu / LED %lu bytes\n",
+                  TAG, (unsigned)sizeof(BufferArena), (unsigned)sizeof(buffer_arena.adc_frame),
+                  (unsigned)(sizeof(buffer_arena.stream_frames) + sizeof(buffer_arena.stream_slot_codes)),
+                  ADC_TASK_STACK_BYTES, SPECTRUM_TASK_STACK_BYTES, LOG_TASK_STACK_BYTES, LED_TASK_STACK_BYTES);
+    Serial.printf("I (%s): Free heap %lu bytes (largest block %lu)\n", TAG,
+                  (unsigned long)esp_get_free_heap_size(), (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+static uint16_t stack_headroom(TaskHandle_t task) {
+    if (task == NULL) {
+        return STACK_HEADROOM_UNKNOWN;
+    }
+    UBaseType_t bytes = uxTaskGetStackHighWaterMark(task); // ESP-IDF: bytes, not words
+    return (uint16_t)min(bytes, (UBaseType_t)(STACK_HEADROOM_UNKNOWN - 1));
+}
+
+void memory_report_update() {
+    MemoryReport report = {};
+    report.free_heap = esp_get_free_heap_size();
+    report.min_free_heap = esp_get_minimum_free_heap_size();
+    report.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    const TaskHandle_t tasks[MEMORY_TASK_COUNT] = {
+        adcProcessingTaskHandle, spectrumTaskHandle, logTaskHandle, ledNormalFlashTaskHandle, loop_task_handle
+    };
+    for (int i = 0; i < MEMORY_TASK_COUNT; ++i) {
+        report.stack_headroom[i] = stack_headroom(tasks[i]);
+    }
+    latest_memory.publish(report);
+
+    LOG_I(TAG, "Heap: %lu free (min %lu, largest block %lu); stack headroom ADC %u, spectrum %u, log %u, LED %u, loop %u",
+          report.free_heap, report.min_free_heap, report.largest_free_block,
+          report.stack_headroom[MEMORY_TASK_ADC], report.stack_headroom[MEMORY_TASK_SPECTRUM],
+          report.stack_headroom[MEMORY_TASK_LOG], report.stack_headroom[MEMORY_TASK_LED],
+          report.stack_headroom[MEMORY_TASK_LOOP]);
+    for (int i = 0; i < MEMORY_TASK_COUNT; ++i) {
+        if (report.stack_headroom[i] < STACK_HEADROOM_WARN_BYTES) {
+            LOG_W(TAG, "%s task stack headroom down to %u bytes", MEMORY_TASK_NAMES[i], report.stack_headroom[i]);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "globals.h"
+#include "stream.h"
+
+// --- Static Buffer Arena ---
+// Every frame-sized work buffer of the acquisition path, in one statically allocated,
+// DMA-capable block (internal DRAM, word aligned) whose size is fixed at compile time by
+// globals.h. Each member has a single owner task, noted below.
+
+// Stream buffers only exist in STREAM_ENABLED builds
+const int ARENA_STREAM_FRAMES = STREAM_ENABLED ? STREAM_QUEUE_DEPTH : 0;
+const int ARENA_STREAM_SLOTS = (STREAM_ENABLED && STREAM_PACKED) ? ADC_PATTERN_LEN : 0;
+
+struct BufferArena {
+    // ADC task: adc_continuous_read() target, reused by the legacy discard reads
+    alignas(4) uint8_t adc_frame[ADC_CONV_FRAME_SIZE];
+    // ADC task -> SPI slave DMA: stream transaction buffers (stream.cpp)
+    alignas(4) uint8_t stream_frames[ARENA_STREAM_FRAMES][STREAM_FRAME_BYTES];
+    // ADC task: a frame's codes split by pattern slot before packing (stream.cpp)
+    alignas(4) uint16_t stream_slot_codes[ARENA_STREAM_SLOTS][ADC_READ_LEN];
+};
+static_assert(STREAM_FRAME_BYTES % 4 == 0 && ADC_CONV_FRAME_SIZE % 4 == 0, "Arena members must stay word aligned for DMA");
+
+extern BufferArena buffer_arena;
+
+// --- Memory Diagnostics ---
+// Minimum stack headroom per task since it started (uxTaskGetStackHighWaterMark, bytes)
+// and heap figures, refreshed by the ADC task once per report interval.
+
+enum MemoryTask : uint8_t {
+    MEMORY_TASK_ADC = 0,
+    MEMORY_TASK_SPECTRUM,
+    MEMORY_TASK_LOG,
+    MEMORY_TASK_LED,
+    MEMORY_TASK_LOOP, // Arduino loopTask (setup/loop, self-benchmark)
+    MEMORY_TASK_COUNT
+};
+
+const uint16_t STACK_HEADROOM_UNKNOWN = 0xFFFF; // Task not running
+
+struct MemoryReport {
+    uint32_t free_heap;         // Bytes
+    uint32_t min_free_heap;     // Lowest free heap since boot
+    uint32_t largest_free_block;
+    uint16_t stack_headroom[MEMORY_TASK_COUNT]; // Bytes, or STACK_HEADROOM_UNKNOWN
+};
+
+extern ResultSnapshot<MemoryReport> latest_memory;
+
+/**
+ * @brief Records the loop task handle and prints the static memory plan. Call from setup().
+ */
+void init_memory_diagnostics();
+
+/**
+ * @brief Measures heap and stack headroom, publishes `latest_memory` and logs it
+ * (warns about stacks below STACK_HEADROOM_WARN_BYTES). ADC task, once per report interval.
+ */
+void memory_report_update();
+
+#endif // ARENA_H
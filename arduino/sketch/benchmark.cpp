@@ -0,0 +1,307 @@
+#include "benchmark.h"
+#include "adc_kernel.h"
+#include "spectrum.h"
+#include "scope.h"
+#include <esp_cpu.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_freertos_hooks.h>
+#include <cmath>    // For sin
+#include <string.h> // For strcmp
+
+static const char *TAG = "Bench";
+
+// --- Define Global Variables (declared extern in benchmark.h) ---
+ResultSnapshot<BenchmarkReport> latest_benchmark;
+
+// --- Restart Request ---
+// Kept across a software restart (not a power cycle). The magic value and the reset
+// reason must both match, so whatever RTC RAM holds after power-on never starts a benchmark.
+static const uint32_t BENCH_REQUEST_MAGIC = 0x42454E43; // "BENC"
+static RTC_NOINIT_ATTR uint32_t bench_request_word;
+static volatile bool restart_pending = false; // Set by the I2C handler or a Serial command
+
+// --- Synthetic Input ---
+// Linear placeholder calibration (init_adc() installs the real table later) and a
+// 250 Hz, 600 mV sine around CURRENT_SENSOR_ZERO_MV on the primary channel: a few
+// cycles per frame, so the frequency detector sees real crossings.
+static const uint32_t BENCH_FULL_SCALE_MV = 3100;
+static const int BENCH_SINE_PERIOD_SAMPLES = 100;
+static const int BENCH_SINE_AMPLITUDE_MV = 600;
+static const int BENCH_FFT_PERIOD_SAMPLES = 25; // Fundamental well inside the FFT band
+static const int BENCH_CIC_DECIMATION = (ADC_DECIMATION_FACTOR > 1) ? ADC_DECIMATION_FACTOR : 4;
+
+// Heap-allocated for the duration of the benchmark only
+struct BenchBuffers {
+    adc_digi_output_data_t frame[ADC_READ_LEN];
+    uint16_t primary_mv[ADC_READ_LEN];
+    uint16_t cic_out[ADC_READ_LEN];
+    BatchAccumulator batch;
+    CycleDetector zc;
+    CicDecimator cic;
+    IirChain iir;
+    WindowRing window;
+};
+
+static uint16_t bench_code(int32_t mv) {
+    int32_t code = mv * (ADC_RAW_CODE_COUNT - 1) / (int32_t)BENCH_FULL_SCALE_MV;
+    return (uint16_t)min(max(code, (int32_t)0), (int32_t)(ADC_RAW_CODE_COUNT - 1));
+}
+
+static int32_t bench_sine_mv(uint32_t n, uint32_t period) {
+    return CURRENT_SENSOR_ZERO_MV + (int32_t)lround(BENCH_SINE_AMPLITUDE_MV * sin(2.0 * M_PI * n / period));
+}
+
+static void build_synthetic_frame(BenchBuffers *b) {
+    for (uint32_t raw = 0; raw < ADC_RAW_CODE_COUNT; ++raw) {
+        adc_raw_to_mv_lut[raw] = (uint16_t)(raw * BENCH_FULL_SCALE_MV / (ADC_RAW_CODE_COUNT - 1));
+    }
+    kernel_build_channel_map();
+    uint32_t n = 0;
+    for (int i = 0; i < ADC_READ_LEN; ++i) {
+        int slot = i % ADC_PATTERN_LEN;
+        adc_digi_output_data_t d = {};
+        d.type2.channel = ADC_PATTERN[slot].channel;
+        if (slot == 0) {
+            d.type2.data = bench_code(bench_sine_mv(n++, BENCH_SINE_PERIOD_SAMPLES));
+        } else {
+            d.type2.data = bench_code(ADC_PATTERN[slot].role == ChannelRole::BATTERY_VOLTAGE ? 1200 : CURRENT_SENSOR_ZERO_MV);
+        }
+        b->frame[i] = d;
+    }
+}
+
+// --- Stage Runners ---
+// Decode only: TYPE2 field extraction, slot lookup and LUT, into a plain mV buffer.
+static uint32_t __attribute__((noinline)) bench_decode(const adc_digi_output_data_t *frame, uint32_t slots, uint16_t *out) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < slots; ++i) {
+        if (adc_channel_slot[frame[i].type2.channel] == 0) {
+            out[n++] = adc_raw_to_mv_lut[frame[i].type2.data];
+        }
+    }
+    return n;
+}
+
+// The kernel feeds the spectrum capture: restarting it before every run keeps it from
+// completing (and counting as skipped) before the spectrum task exists
+static void restart_kernel_sinks(BatchAccumulator *batch) {
+    batch_reset(batch);
+    spectrum_capture_reset(&spectrum_capture);
+}
+
+// Fastest of BENCH_REPEATS runs of `run`; `setup` is not timed.
+template <typename Setup, typename Run>
+static uint32_t fastest_cycles(Setup setup, Run run) {
+    uint32_t best = UINT32_MAX;
+    for (int r = 0; r < BENCH_REPEATS; ++r) {
+        setup();
+        uint32_t start = esp_cpu_get_cycle_count();
+        run();
+        best = min(best, esp_cpu_get_cycle_count() - start);
+    }
+    return best;
+}
+
+// Cycles per unit in 0.1 cycle steps, saturated to the u16 report fields
+static uint16_t per_unit_dcps(uint32_t cycles, uint32_t units) {
+    return (uint16_t)min((uint64_t)cycles * 10 / max(units, (uint32_t)1), (uint64_t)UINT16_MAX);
+}
+
+void run_self_benchmark(bool fft_ready, bool requested) {
+    BenchBuffers *b = (BenchBuffers *)calloc(1, sizeof(BenchBuffers));
+    if (b == NULL) {
+        Serial.printf("E (%s): Not enough memory for the self-benchmark (%u bytes).\n", TAG, (unsigned)sizeof(BenchBuffers));
+        return;
+    }
+    build_synthetic_frame(b);
+    const uint8_t *frame = (const uint8_t *)b->frame;
+    const uint32_t slots = ADC_READ_LEN;
+    const uint32_t primary = bench_decode(b->frame, slots, b->primary_mv);
+    const uint32_t processed = primary / ADC_DECIMATION_FACTOR;
+
+    BenchmarkReport report = {};
+    report.cpu_mhz = (uint16_t)getCpuFrequencyMhz();
+    report.flags = BENCH_FLAG_VALID | (requested ? BENCH_FLAG_REQUESTED : 0);
+
+    uint32_t decode = fastest_cycles([] {}, [&] { bench_decode(b->frame, slots, b->primary_mv); });
+
+    // Fused kernel twice: detector disabled (no reference yet), then crossing live
+    cic_init(&b->cic, ADC_DECIMATION_FACTOR);
+    iir_design(&b->iir, FILTER_CHAIN_SPEC, FILTER_DEFAULT_SECTIONS, PROCESSING_SAMPLE_FREQ_HZ); // As at boot
+    zc_init(&b->zc, PROCESSING_SAMPLE_FREQ_HZ);
+    uint32_t accumulate = fastest_cycles([&] { restart_kernel_sinks(&b->batch); },
+                                         [&] { accumulate_frame<AdcPipeline>(frame, slots, &b->batch, &b->zc, &b->cic, &b->iir); });
+    b->zc.reference_mv = CURRENT_SENSOR_ZERO_MV;
+    uint32_t kernel = fastest_cycles([&] { restart_kernel_sinks(&b->batch); },
+                                     [&] { accumulate_frame<AdcPipeline>(frame, slots, &b->batch, &b->zc, &b->cic, &b->iir); });
+
+    CicDecimator cic;
+    cic_init(&cic, BENCH_CIC_DECIMATION);
+    uint32_t cic_cycles = fastest_cycles([] {}, [&] { cic_process_block(&cic, b->primary_mv, primary, b->cic_out); });
+
+    // Every section the build defines, whatever runs at boot
+    IirChain iir;
+    uint32_t iir_cycles = 0;
+    if (FILTER_AVAILABLE_SECTIONS != 0 && iir_design(&iir, FILTER_CHAIN_SPEC, FILTER_AVAILABLE_SECTIONS, PROCESSING_SAMPLE_FREQ_HZ)) {
+        iir_cycles = fastest_cycles([&] { iir_reset(&iir); }, [&] { iir_process_block(&iir, b->primary_mv, primary, b->cic_out); });
+    }
+
+    // Block close + window result, once per output period
+    window_reset(&b->window, WINDOW_BLOCKS, PROCESSING_SAMPLE_FREQ_HZ);
+    uint32_t window_cycles = fastest_cycles([&] {
+        restart_kernel_sinks(&b->batch);
+        accumulate_frame<AdcPipeline>(frame, slots, &b->batch, &b->zc, &b->cic, &b->iir);
+    }, [&] {
+        BlockPartial block;
+        MeasurementResult result = {};
+        block_close(&b->batch, &b->zc, 0, true, &block);
+        window_push(&b->window, &block);
+        window_compute_result(&b->window, &result, NULL);
+    });
+
+    if (fft_ready) {
+        // The spectrum task does not exist yet: borrow its first capture buffer
+        int16_t *capture = spectrum_capture.buffers[0];
+        for (int i = 0; i < SPECTRUM_FFT_SIZE; ++i) {
+            capture[i] = (int16_t)bench_sine_mv(i, BENCH_FFT_PERIOD_SAMPLES);
+        }
+        SpectrumResult spectrum;
+        report.fft_cycles = fastest_cycles([&] { spectrum = {}; }, [&] { spectrum_analyse(capture, &spectrum); });
+        report.flags |= BENCH_FLAG_FFT;
+    }
+    free(b);
+
+    report.decode_dcps = per_unit_dcps(decode, slots);
+    report.accumulate_dcps = per_unit_dcps(accumulate, slots);
+    report.detector_dcps = per_unit_dcps(kernel > accumulate ? kernel - accumulate : 0, processed);
+    report.cic_dcps = per_unit_dcps(cic_cycles, primary);
+    report.kernel_dcps = per_unit_dcps(kernel, slots);
+
+    // Cost of one conversion slot in the configured pipeline: kernel plus the per-slot
+    // share of the window step and, in spectrum builds, of one FFT per capture
+    const uint32_t window_slots = (uint32_t)BLOCK_SAMPLES * ADC_PATTERN_LEN;
+    const uint32_t capture_slots = (uint32_t)SPECTRUM_FFT_SIZE * SPECTRUM_DECIMATION * ADC_DECIMATION_FACTOR * ADC_PATTERN_LEN;
+    uint64_t slot_dcycles = (uint64_t)kernel * 10 / slots + (uint64_t)window_cycles * 10 / window_slots;
+    if (SPECTRUM_MODE_ENABLED) {
+        slot_dcycles += (uint64_t)report.fft_cycles * 10 / capture_slots;
+    }
+    uint64_t cpu_hz = (uint64_t)report.cpu_mhz * 1000000;
+    slot_dcycles = max(slot_dcycles, (uint64_t)1);
+    report.max_rate_hz = (uint32_t)min(cpu_hz * 10 / slot_dcycles, (uint64_t)UINT32_MAX);
+    report.load_dpct = (uint16_t)min((uint64_t)ADC_CONVERSION_FREQ_HZ * slot_dcycles * 100 / cpu_hz, (uint64_t)UINT16_MAX);
+    latest_benchmark.publish(report);
+
+    // The kernel also filled the scope ring with synthetic codes
+    scope_reset_history();
+
+    Serial.printf("I (%s): Self-benchmark (%s): %u MHz, %lu-slot synthetic frame (%d channel(s)), best of %d runs\n", TAG,
+                  requested ? "requested" : "boot", report.cpu_mhz, (unsigned long)slots, ADC_PATTERN_LEN, BENCH_REPEATS);
+    Serial.printf("I (%s):   decode      %5.1f cycles/slot\n", TAG, report.decode_dcps / 10.0f);
+    Serial.printf("I (%s):   accumulate  %5.1f cycles/slot (fused kernel, detector idle)\n", TAG, report.accumulate_dcps / 10.0f);
+    Serial.printf("I (%s):   detector    %5.1f cycles/sample\n", TAG, report.detector_dcps / 10.0f);
+    Serial.printf("I (%s):   cic (R=%d)  %5.1f cycles/input sample\n", TAG, BENCH_CIC_DECIMATION, report.cic_dcps / 10.0f);
+    if (iir_cycles > 0) {
+        Serial.printf("I (%s):   iir (%d+DC) %5.1f cycles/sample (all sections)\n", TAG, FILTER_BIQUAD_COUNT, per_unit_dcps(iir_cycles, primary) / 10.0f);
+    }
+    Serial.printf("I (%s):   kernel      %5.1f cycles/slot (as configured)\n", TAG, report.kernel_dcps / 10.0f);
+    Serial.printf("I (%s):   window      %lu cycles per output period\n", TAG, (unsigned long)window_cycles);
+    if (report.flags & BENCH_FLAG_FFT) {
+        Serial.printf("I (%s):   fft (%d)  %lu cycles per capture (%lu us)\n", TAG, SPECTRUM_FFT_SIZE,
+                      (unsigned long)report.fft_cycles, (unsigned long)(report.fft_cycles / report.cpu_mhz));
+    }
+    Serial.printf("I (%s): Max sustainable conversion rate %lu Hz; %d Hz needs %.1f%% CPU for processing\n", TAG,
+                  (unsigned long)report.max_rate_hz, ADC_CONVERSION_FREQ_HZ, report.load_dpct / 10.0f);
+}
+
+// --- Commands ---
+bool benchmark_boot_requested() {
+    bool requested = (bench_request_word == BENCH_REQUEST_MAGIC) && esp_reset_reason() == ESP_RST_SW;
+    bench_request_word = 0;
+    return requested;
+}
+
+void benchmark_request_restart() {
+    restart_pending = true;
+}
+
+void benchmark_poll_commands() {
+    static char line[16];
+    static size_t len = 0;
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c == '\r' || c == '\n') {
+            line[len] = '\0';
+            if (strcmp(line, "bench") == 0) {
+                restart_pending = true;
+            }
+            len = 0;
+        } else if (len < sizeof(line) - 1) {
+            line[len++] = (char)c;
+        }
+    }
+    if (restart_pending) {
+        bench_request_word = BENCH_REQUEST_MAGIC;
+        // Direct print: the log ring is not drained before the restart
+        Serial.printf("I (%s): Restarting into the self-benchmark...\n", TAG);
+        Serial.flush();
+        esp_restart();
+    }
+}
+
+// --- CPU Idle Monitor ---
+// Counters are 32-bit cycle counts that wrap; only differences are used. The hook runs
+// in the idle task, so a single aligned store per counter keeps readers consistent.
+static uint32_t idle_hook_last_cycles = 0;
+static uint32_t idle_cycles_total = 0;
+static uint32_t interval_start_cycles = 0;
+static uint32_t interval_start_idle = 0;
+static bool idle_monitor_running = false;
+static bool interval_open = false;
+static volatile uint16_t cpu_idle_last = CPU_IDLE_UNKNOWN;
+
+static bool cpu_idle_hook() {
+    uint32_t now = esp_cpu_get_cycle_count();
+    uint32_t gap = now - idle_hook_last_cycles;
+    idle_hook_last_cycles = now;
+    if (gap < CPU_IDLE_MAX_GAP_CYCLES) {
+        __atomic_store_n(&idle_cycles_total, idle_cycles_total + gap, __ATOMIC_RELAXED);
+    }
+    return false; // Call again right away instead of waiting for an interrupt (WFI)
+}
+
+bool init_cpu_idle_monitor() {
+    if (!CPU_IDLE_MONITOR_ENABLED) {
+        return false;
+    }
+    esp_err_t ret = esp_register_freertos_idle_hook_for_cpu(cpu_idle_hook, 0);
+    if (ret != ESP_OK) {
+        Serial.printf("E (%s): Failed to register the CPU idle hook: %s\n", TAG, esp_err_to_name(ret));
+        return false;
+    }
+    idle_monitor_running = true;
+    Serial.printf("I (%s): CPU idle monitor running (gaps < %lu cycles count as idle).\n", TAG,
+                  (unsigned long)CPU_IDLE_MAX_GAP_CYCLES);
+    return true;
+}
+
+uint16_t cpu_idle_update() {
+    if (!idle_monitor_running) {
+        return CPU_IDLE_UNKNOWN;
+    }
+    uint32_t now = esp_cpu_get_cycle_count();
+    uint32_t idle = __atomic_load_n(&idle_cycles_total, __ATOMIC_RELAXED);
+    uint32_t elapsed = now - interval_start_cycles;
+    if (interval_open && elapsed > 0) {
+        uint64_t dpct = (uint64_t)(idle - interval_start_idle) * 1000 / elapsed;
+        cpu_idle_last = (uint16_t)min(dpct, (uint64_t)1000);
+    }
+    interval_start_cycles = now;
+    interval_start_idle = idle;
+    interval_open = true;
+    return cpu_idle_last;
+}
+
+uint16_t cpu_idle_latest() {
+    return cpu_idle_last;
+}
@@ -0,0 +1,83 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "globals.h"
+
+// --- On-Device Self-Benchmark ---
+// Runs each processing stage over a fixed synthetic DMA frame (a sine on the primary
+// channel, constant levels on the others) and reports its cost in CPU cycles. Every
+// stage runs BENCH_REPEATS times and the fastest run counts, so an interrupt landing in
+// one run does not skew the figure. The benchmark runs in setup() before the ADC is
+// started or any task exists; it installs a linear placeholder in the mV lookup table,
+// which init_adc() then replaces with the calibrated one.
+//
+// The CPU idle monitor measures real headroom under live load: an idle hook adds up the
+// short gaps between its own consecutive calls (idle time); a longer gap means an ISR or
+// a task ran in between and counts as busy.
+
+const uint16_t BENCH_FLAG_VALID = 1 << 0;     // A benchmark ran at this boot
+const uint16_t BENCH_FLAG_FFT = 1 << 1;       // FFT stage measured (spectrum mode initialised)
+const uint16_t BENCH_FLAG_REQUESTED = 1 << 2; // Started by a command (otherwise SELF_BENCHMARK_AT_BOOT)
+
+const uint16_t CPU_IDLE_UNKNOWN = 0xFFFF;     // No idle interval measured yet (or monitor disabled)
+
+struct BenchmarkReport {
+    uint16_t cpu_mhz;
+    uint16_t decode_dcps;     // TYPE2 decode + demultiplex + LUT (0.1 cycles per conversion slot)
+    uint16_t accumulate_dcps; // Fused kernel with the frequency detector idle (0.1 cycles per slot)
+    uint16_t detector_dcps;   // Frequency detector on top of that (0.1 cycles per processed sample)
+    uint16_t cic_dcps;        // CIC decimator (0.1 cycles per input sample)
+    uint16_t kernel_dcps;     // Fused kernel as configured for this build (0.1 cycles per slot)
+    uint32_t fft_cycles;      // One spectrum analysis (cycles per capture, 0 if not measured)
+    uint32_t max_rate_hz;     // Conversion rate the configured kernel (+ FFT share) could sustain on a free CPU
+    uint16_t load_dpct;       // Projected kernel load at ADC_CONVERSION_FREQ_HZ (0.1 %)
+    uint16_t flags;           // BENCH_FLAG_*
+};
+
+extern ResultSnapshot<BenchmarkReport> latest_benchmark;
+
+/**
+ * @brief True if the previous run asked for a benchmark (benchmark_request_restart())
+ * and the C3 came back from that software restart. Clears the request.
+ */
+bool benchmark_boot_requested();
+
+/**
+ * @brief Runs the stage benchmark, prints the report on Serial and publishes it to
+ * `latest_benchmark`. Call from setup() before init_adc().
+ * @param fft_ready init_spectrum() succeeded, so the FFT stage can be timed.
+ * @param requested Started by a command (sets BENCH_FLAG_REQUESTED).
+ */
+void run_self_benchmark(bool fft_ready, bool requested);
+
+/**
+ * @brief Asks for a benchmark on the next boot; loop() restarts the C3 at its next pass.
+ * Safe from the I2C callbacks (only sets a flag).
+ */
+void benchmark_request_restart();
+
+/**
+ * @brief Polls Serial for a "bench" line and performs a pending restart request.
+ * Call from loop().
+ */
+void benchmark_poll_commands();
+
+/**
+ * @brief Registers the idle hook on core 0 (no-op with CPU_IDLE_MONITOR_ENABLED false).
+ * @return true if the monitor is running.
+ */
+bool init_cpu_idle_monitor();
+
+/**
+ * @brief Closes the current idle interval and starts the next one. Call from one task
+ * only, at least every 26 s (the 32-bit cycle counter wraps at 160 MHz).
+ * @return CPU idle over the interval in 0.1 %, or CPU_IDLE_UNKNOWN.
+ */
+uint16_t cpu_idle_update();
+
+/**
+ * @brief Idle figure of the last closed interval (0.1 %, or CPU_IDLE_UNKNOWN). Any context.
+ */
+uint16_t cpu_idle_latest();
+
+#endif // BENCHMARK_H
@@ -0,0 +1,121 @@
+#include "charge_counter.h"
+#include "pipeline_config.h"
+#include "logger.h"
+
+static const char *TAG = "Charge";
+
+// --- Integrator State (owned by the ADC task) ---
+static ChargeTotals live = {};
+static ChargeTotals held = {};
+static bool holding = false;
+static bool started = false; // A sample was integrated since the reset (first_us is set)
+static uint16_t resets = 0;
+static uint16_t snapshots = 0;
+// Fractions carried between blocks, in units of 1 / (their divisor) of the total's unit
+static int64_t charge_rem = 0;
+static int64_t energy_rem = 0;
+static int64_t covered_rem = 0;
+static uint32_t rem_freq_hz = 0; // Rate the remainders are scaled by
+
+// --- Master Commands (set by the I2C handler, consumed by the ADC task) ---
+static volatile bool snapshot_requested = false;
+static volatile bool reset_requested = false;
+static volatile bool live_requested = false;
+
+static ResultSnapshot<ChargeStatus> charge_status;
+
+// Adds num / den to *total; the remainder carries over, so no fraction is lost
+static void add_exact(int64_t *total, int64_t *rem, int64_t num, int64_t den) {
+    int64_t n = num + *rem;
+    *total += n / den;
+    *rem = n % den;
+}
+
+static void set_rate(uint32_t sample_freq_hz) {
+    if (sample_freq_hz != rem_freq_hz) {
+        // Fractions of the old rate (below 1 uC / 1 uJ / 1 us) are dropped with it
+        charge_rem = energy_rem = covered_rem = 0;
+        rem_freq_hz = sample_freq_hz;
+    }
+}
+
+static void add_samples(uint64_t sum_mv, uint32_t samples, int64_t power_sum, uint32_t sample_freq_hz, int64_t first_us, int64_t last_us) {
+    set_rate(sample_freq_hz);
+    // mV about the zero * mA per mV * 1000 = uA, per sample at sample_freq_hz
+    int64_t deviation_sum = (int64_t)sum_mv - (int64_t)samples * CURRENT_SENSOR_ZERO_MV;
+    add_exact(&live.charge_uc, &charge_rem, deviation_sum * CURRENT_SENSOR_MA_PER_MV * 1000, sample_freq_hz);
+    if constexpr (AdcPipeline::HAS_POWER) {
+        // Current mA * battery mV = uW (pin mV through the divider ratio), per sample
+        add_exact(&live.energy_uj, &energy_rem,
+                  power_sum * CURRENT_SENSOR_MA_PER_MV * BATTERY_DIVIDER_RATIO_X1000, (int64_t)sample_freq_hz * 1000);
+    }
+    add_exact(&live.covered_us, &covered_rem, (int64_t)samples * 1000000, sample_freq_hz);
+    if (!started) {
+        live.first_us = first_us;
+        started = true;
+    }
+    live.last_us = last_us;
+}
+
+static void publish_status() {
+    ChargeStatus status = {};
+    status.totals = holding ? held : live;
+    status.held = holding;
+    status.resets = resets;
+    status.snapshots = snapshots;
+    charge_status.publish(status);
+}
+
+void charge_after_block(const BlockPartial *block, uint32_t sample_freq_hz) {
+    if (block->raw_samples > 0) {
+        add_samples(block->raw_sum_mv, block->raw_samples, block->power_sum, sample_freq_hz, block->first_sample_us,
+                    block->last_sample_us);
+    }
+    if (snapshot_requested) {
+        snapshot_requested = false;
+        held = live;
+        holding = true;
+        snapshots++;
+        LOG_I(TAG, "Snapshot #%u: %ld mC, %ld J over %lu s", snapshots, (int32_t)(held.charge_uc / 1000),
+              (int32_t)(held.energy_uj / 1000000), (uint32_t)(held.covered_us / 1000000));
+    }
+    if (reset_requested) {
+        reset_requested = false;
+        live = {};
+        started = false;
+        charge_rem = energy_rem = covered_rem = 0;
+        resets++;
+        LOG_I(TAG, "Totals reset (#%u)", resets);
+    }
+    if (live_requested) {
+        live_requested = false;
+        holding = false;
+    }
+    publish_status();
+}
+
+void charge_after_discarded_frame(const FrameStats *frame, uint32_t sample_freq_hz, int64_t end_us) {
+    if (frame->raw_samples == 0) {
+        return;
+    }
+    int64_t first_us = end_us - (int64_t)(frame->raw_samples - 1) * 1000000 / sample_freq_hz;
+    add_samples(frame->raw_sum_mv, frame->raw_samples, frame->power_sum, sample_freq_hz, first_us, end_us);
+}
+
+void charge_request(uint8_t cmd) {
+    if (cmd & CHARGE_CMD_SNAPSHOT) {
+        snapshot_requested = true;
+    }
+    if (cmd & CHARGE_CMD_RESET) {
+        reset_requested = true;
+    }
+    if (cmd & CHARGE_CMD_LIVE) {
+        live_requested = true;
+    }
+}
+
+ChargeStatus charge_get_status() {
+    ChargeStatus status = {};
+    charge_status.read(&status); // No block closed yet -> all zero
+    return status;
+}
@@ -0,0 +1,60 @@
+#ifndef CHARGE_COUNTER_H
+#define CHARGE_COUNTER_H
+
+#include "globals.h"
+#include "adc_kernel.h"
+
+// --- Charge and Energy Counter ---
+// Running integrals over every primary sample at the conversion rate, taken from the
+// kernel's raw sums (before the decimator and the filter, so the DC blocker does not hide a
+// steady current): charge of (current - CURRENT_SENSOR_ZERO_MV) and, with a battery voltage
+// channel, energy of V*I. Added once per block in exact integer arithmetic (the fraction
+// below 1 uC / 1 uJ carries over to the next block), so the totals do not depend on the
+// output rate or on how often the master reads them. Frames lost to a pool overflow or a
+// read timeout are not in the totals: the covered time falls behind the elapsed time then.
+// In legacy mode the rest of the frame a batch ends in and the discard loop's frames are
+// scanned (frame_scan_primary) and counted in full, energy included. Master commands apply at the next block boundary, after it.
+
+const uint8_t CHARGE_CMD_SNAPSHOT = 1 << 0; // Hold the totals in the record (a new snapshot replaces the held one)
+const uint8_t CHARGE_CMD_RESET = 1 << 1;    // Restart the totals from zero (after the snapshot, if both)
+const uint8_t CHARGE_CMD_LIVE = 1 << 2;     // Release the held snapshot: the record follows the live totals
+
+struct ChargeTotals {
+    int64_t charge_uc;  // uA*s, current above the sensor zero counts positive
+    int64_t energy_uj;  // 0 without a battery voltage channel
+    int64_t covered_us; // Signal time in the integrals (samples / conversion rate)
+    int64_t first_us;   // esp_timer of the first and last integrated sample since the reset
+    int64_t last_us;
+};
+
+// State published for the I2C handler (ADC task writes, any context reads)
+struct ChargeStatus {
+    ChargeTotals totals; // The held snapshot while `held`, else the live totals
+    bool held;
+    uint16_t resets;     // CHARGE_CMD_RESET applied since boot (wraps)
+    uint16_t snapshots;  // CHARGE_CMD_SNAPSHOT applied since boot (wraps)
+};
+
+/**
+ * @brief Adds a closed block and applies pending commands (ADC task, every block).
+ * @param sample_freq_hz Conversion rate per channel the block was sampled at.
+ */
+void charge_after_block(const BlockPartial *block, uint32_t sample_freq_hz);
+
+/**
+ * @brief Adds a frame (or the rest of one) that legacy mode dropped (ADC task, from its frame_scan_primary() stats).
+ * @param end_us esp_timer of the frame's last conversion.
+ */
+void charge_after_discarded_frame(const FrameStats *frame, uint32_t sample_freq_hz, int64_t end_us);
+
+/**
+ * @brief Queues CHARGE_CMD_* bits for the next block boundary (I2C receive handler).
+ */
+void charge_request(uint8_t cmd);
+
+/**
+ * @brief Latest published totals (all zero before the first block).
+ */
+ChargeStatus charge_get_status();
+
+#endif // CHARGE_COUNTER_H
@@ -0,0 +1,35 @@
+#include "decimator.h"
+#include <string.h>
+
+bool cic_init(CicDecimator *cic, uint32_t decimation) {
+    memset(cic, 0, sizeof(*cic));
+    if (decimation == 0 || decimation > (uint32_t)CIC_MAX_DECIMATION || (decimation & (decimation - 1)) != 0) {
+        return false;
+    }
+    uint32_t log2_r = 0;
+    while ((1u << log2_r) < decimation) {
+        log2_r++;
+    }
+    cic->decimation = decimation;
+    cic->gain_shift = log2_r * CIC_ORDER;
+    cic->settling = (decimation > 1) ? CIC_ORDER - 1 : 0;
+    return true;
+}
+
+void cic_reset(CicDecimator *cic) {
+    memset(cic->integrator, 0, sizeof(cic->integrator));
+    memset(cic->comb_delay, 0, sizeof(cic->comb_delay));
+    cic->phase = 0;
+    cic->settling = (cic->decimation > 1) ? CIC_ORDER - 1 : 0;
+}
+
+uint32_t cic_process_block(CicDecimator *cic, const uint16_t *in, uint32_t count, uint16_t *out) {
+    uint32_t produced = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t y;
+        if (cic_push(cic, in[i], &y)) {
+            out[produced++] = (uint16_t)y;
+        }
+    }
+    return produced;
+}
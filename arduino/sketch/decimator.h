@@ -0,0 +1,74 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdint.h>
+
+// --- Fixed-Point CIC Decimator ---
+// N-stage cascaded integrator-comb filter decimating by a power of two. Used in the
+// high-rate acquisition mode to reduce noise and anti-alias the 80 kHz ADC stream
+// before RMS/frequency estimation. Integer only (no FPU on the C3): the integrators
+// wrap modulo 2^32, which is exact for a CIC as long as the output range
+// (input range * R^N) fits in 32 bits, i.e. 12-bit mV * 4^3 = 18 bits here.
+
+const int CIC_ORDER = 3;           // Number of integrator/comb stages
+const int CIC_MAX_DECIMATION = 16; // Largest supported rate change
+
+struct CicDecimator {
+    uint32_t integrator[CIC_ORDER];
+    uint32_t comb_delay[CIC_ORDER];
+    uint32_t phase;       // Input samples since the last output
+    uint32_t decimation;  // Rate change R (power of two)
+    uint32_t gain_shift;  // log2(R^N), removes the DC gain of the filter
+    uint32_t settling;    // Outputs still to suppress after a reset (filter start-up transient)
+};
+
+/**
+ * @brief Initializes (and clears) a CIC decimator.
+ * @param cic Decimator state.
+ * @param decimation Rate change R, a power of two between 1 and CIC_MAX_DECIMATION.
+ * @return true if the decimation factor is supported.
+ */
+bool cic_init(CicDecimator *cic, uint32_t decimation);
+
+/**
+ * @brief Clears the filter history, keeping the decimation factor. Call after a gap in
+ * the input stream so stale integrator state does not leak into new samples.
+ */
+void cic_reset(CicDecimator *cic);
+
+/**
+ * @brief Feeds one input sample (mV). Runs the integrators at the input rate and
+ * the combs at the output rate.
+ * @param out Receives the decimated, gain-corrected sample when one is produced.
+ * @return true every `decimation` inputs (once settled), when `*out` is valid.
+ */
+static inline bool cic_push(CicDecimator *cic, uint32_t x, uint32_t *out) {
+    uint32_t acc = x;
+    for (int i = 0; i < CIC_ORDER; ++i) {
+        cic->integrator[i] += acc;
+        acc = cic->integrator[i];
+    }
+    if (++cic->phase < cic->decimation) {
+        return false;
+    }
+    cic->phase = 0;
+    for (int i = 0; i < CIC_ORDER; ++i) {
+        uint32_t delayed = cic->comb_delay[i];
+        cic->comb_delay[i] = acc;
+        acc -= delayed;
+    }
+    if (cic->settling > 0) {
+        cic->settling--;
+        return false;
+    }
+    *out = (acc + (1u << cic->gain_shift >> 1)) >> cic->gain_shift; // Rounded
+    return true;
+}
+
+/**
+ * @brief Decimates a block of samples (used by the benchmarks).
+ * @return Number of samples written to `out` (at most `count / decimation + 1`).
+ */
+uint32_t cic_process_block(CicDecimator *cic, const uint16_t *in, uint32_t count, uint16_t *out);
+
+#endif // DECIMATOR_H
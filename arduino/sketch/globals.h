@@ -7,13 +7,27 @@
 #include <esp_adc/adc_continuous.h>
 // #include <nvs.h> // Removed - NVS no longer used
 #include <esp_adc_cal.h> // Added for ESP-IDF calibration
+#include "result_snapshot.h"
+#include "pipeline_config.h"
+#include "iir_filter.h"
 // --- Pin Definitions ---
-const int ADC_PIN_NUM = 4; // GPIO4 for ADC input (Confirm this corresponds to ADC1_CH4)
+const int ADC_PIN_NUM = 4; // GPIO4 for the primary ADC input (Confirm this corresponds to ADC1_CH4)
 const int LED_PIN = 8;
 // const int BOOT_BUTTON_PIN = 9; // Removed
 
 // --- I2C Configuration ---
 const uint8_t I2C_SLAVE_ADDR = 0x08;
+const int I2C_SDA_PIN = 0;
+const int I2C_SCL_PIN = 1;
+// Slave backend: 0 = Arduino Wire (each response is encoded in the onRequest callback
+// while the master is clock-stretched), 1 = ESP-IDF i2c_slave driver (i2c_slave_idf.h:
+// the response is staged in the TX FIFO before the master reads). A preprocessor define
+// so build flags can select it; 1 needs CONFIG_I2C_ENABLE_SLAVE_DRIVER_VERSION_2 (IDF 5.4+).
+#ifndef I2C_IDF_SLAVE_BACKEND
+#define I2C_IDF_SLAVE_BACKEND 0
+#endif
+const int I2C_SLAVE_QUEUE_LEN = 8;             // Master writes / driver events waiting for the service task
+const uint32_t I2C_SLAVE_IDLE_RESTAGE_MS = 5;  // Bus quiet this long: re-check that the latest result is staged
 
 // --- ADC Configuration ---
 // Choose ADC unit and channel based on ADC_PIN_NUM
@@ -22,16 +36,231 @@ const adc_unit_t ADC_UNIT = ADC_UNIT_1;
 const adc_channel_t ADC_CHANNEL = ADC_CHANNEL_4; // Verify this matches ADC_PIN_NUM for C3
 const adc_atten_t ADC_ATTEN = ADC_ATTEN_DB_11; // ~0-2.5V or ~0-3.1V range depending on Vref/chip
 const adc_bitwidth_t ADC_BITWIDTH = ADC_BITWIDTH_12; // 12-bit resolution (0-4095)
-const int TARGET_SAMPLE_FREQ_HZ = 25000; 
+
+// --- ADC Channel Pattern ---
+// Channels converted in turn by the continuous driver; the DMA stream is interleaved in
+// this order and demultiplexed in one pass. Entry 0 must be the primary current channel
+// (ADC_CHANNEL): it alone feeds the decimator, cycle detector, spectrum and window stats.
+// All entries share ADC_ATTEN, so one calibrated mV table serves every channel.
+enum class ChannelRole : uint8_t { CURRENT, CURRENT_AUX, BATTERY_VOLTAGE };
+struct AdcChannelConfig {
+    adc_channel_t channel;
+    int gpio;
+    ChannelRole role;
+};
+constexpr AdcChannelConfig ADC_PATTERN[] = {
+    { ADC_CHANNEL, ADC_PIN_NUM, ChannelRole::CURRENT },           // Primary ACS758 phase
+    // { ADC_CHANNEL_3, 3, ChannelRole::CURRENT_AUX },            // Second ACS758 phase (GPIO3)
+    // { ADC_CHANNEL_2, 2, ChannelRole::BATTERY_VOLTAGE },        // Battery divider (GPIO2)
+};
+constexpr int ADC_PATTERN_LEN = sizeof(ADC_PATTERN) / sizeof(ADC_PATTERN[0]);
+const int ADC_MAX_CHANNEL_ID = 8; // type2.channel is a 3-bit field
+constexpr int find_pattern_slot(ChannelRole role, int slot = 0) {
+    return slot >= ADC_PATTERN_LEN ? -1 : (ADC_PATTERN[slot].role == role ? slot : find_pattern_slot(role, slot + 1));
+}
+const int BATTERY_VOLTAGE_SLOT = find_pattern_slot(ChannelRole::BATTERY_VOLTAGE); // -1 if not sampled
+static_assert(ADC_PATTERN[0].channel == ADC_CHANNEL && ADC_PATTERN[0].role == ChannelRole::CURRENT,
+              "Pattern entry 0 must be the primary current channel");
+
+// --- Current / Voltage Scaling (power calculation) ---
+const int CURRENT_SENSOR_ZERO_MV = 1650;     // Sensor output at 0 A (bidirectional ACS758: Vcc/2)
+const int CURRENT_SENSOR_MA_PER_MV = 200;    // mA per mV at the ADC pin (matches FACTOR = 0.2 on the S3)
+const int BATTERY_DIVIDER_RATIO_X1000 = 11000; // Battery mV = pin mV * ratio / 1000 (10k/1k divider)
+const int TARGET_SAMPLE_FREQ_HZ = 25000; // Processing rate in the normal (non-decimated) mode
+// High-rate mode: the ADC runs near its 83.3 kHz hardware limit and a CIC filter
+// (decimator.h) decimates on-device, so RMS/frequency see a cleaner, anti-aliased stream.
+const bool ADC_HIGH_RATE_MODE = false;
+const int ADC_HIGH_RATE_SAMPLE_FREQ_HZ = 80000;
+const int ADC_DECIMATION_FACTOR = ADC_HIGH_RATE_MODE ? 4 : 1; // Power of two
+const int ADC_SAMPLE_FREQ_HZ = ADC_HIGH_RATE_MODE ? ADC_HIGH_RATE_SAMPLE_FREQ_HZ : TARGET_SAMPLE_FREQ_HZ; // Conversion rate per channel
 const int ADC_READ_LEN = 512; // Number of samples to read from DMA buffer at once (Increased)
-const int ADC_DMA_BUF_SIZE = 1024 * 8; // Keep DMA buffer size sufficient
-const int ADC_CONV_FRAME_SIZE = ADC_READ_LEN * SOC_ADC_DIGI_RESULT_BYTES; // Bytes per DMA frame (Updates automatically)
+const int ADC_DMA_BUF_SIZE = 1024 * (ADC_HIGH_RATE_MODE ? 16 : 8); // Keep ~25 ms of conversions buffered at either rate
+const int ADC_RAW_CODE_COUNT = 1 << 12; // Number of distinct raw codes for ADC_BITWIDTH_12 (size of the mV lookup table)
+
+// --- ADC Overload and Stall Recovery (adc_handler.cpp) ---
+// A full DMA pool drops each further frame (on_pool_ovf): results of the windows it hits carry
+// RESULT_FLAG_SAMPLES_DROPPED and the lost frames. After ADC_STALL_FAILURES failed frame
+// waits in a row (timeouts or read errors, about 90 ms each at the defaults) the ADC task
+// tears the continuous driver down and brings it up again with the active configuration;
+// a failed attempt is retried after a backoff that doubles up to the maximum.
+const uint32_t ADC_STALL_FAILURES = 10;
+const uint32_t ADC_RECOVERY_BACKOFF_MIN_MS = 100;
+const uint32_t ADC_RECOVERY_BACKOFF_MAX_MS = 10000;
 
 // --- Processing Configuration ---
 const int NUM_CYCLES_AVERAGE = 10; // Number of cycles to average over
 const int MIN_EXPECTED_FREQ_HZ = 20; // Minimum frequency used for MAX_SAMPLES_PER_BATCH calculation
-const int MAX_EXPECTED_FREQ_HZ = 300; // Maximum expected frequency (currently informational)
-const int TARGET_BATCH_INTERVAL_MS = 1000; // Target interval between batch starts (ms)
+const int MAX_EXPECTED_FREQ_HZ = 300; // Maximum expected frequency (cycles shorter than this are rejected as noise)
+const int ZC_HYSTERESIS_MV = 15; // Zero-crossing hysteresis band around the dynamic mean (mV)
+const int TARGET_BATCH_INTERVAL_MS = 1000; // Target interval between batch starts (legacy mode) and between detailed log reports (ms)
+
+// --- IIR Filter Chain (iir_filter.h) ---
+// DC blocker plus biquads on the primary channel between decode (and the CIC) and the
+// batch sums, so RMS, frequency and the spectrum see the filtered signal. The sections are
+// designed for the processing rate at boot and after every rate change; the master picks
+// which of them run (REG_CONFIG filter sections, acq_config.h). With the DC blocker active
+// the window mean, min and max are those of the filtered signal around CURRENT_SENSOR_ZERO_MV.
+const bool FILTER_STAGE_ENABLED = true; // false: no filter code or per-sample check in the kernel
+const float FILTER_DC_CUTOFF_HZ = 0.5f; // DC blocker corner, well below MIN_EXPECTED_FREQ_HZ
+constexpr BiquadSpec FILTER_BIQUADS[] = {
+    // 4th-order Butterworth low-pass at 3 kHz: ESC switching ripple (and its aliases) far above the fundamentals
+    { BiquadType::LOWPASS, 3000.0f, 0.5412f },
+    { BiquadType::LOWPASS, 3000.0f, 1.3066f },
+};
+constexpr int FILTER_BIQUAD_COUNT = sizeof(FILTER_BIQUADS) / sizeof(FILTER_BIQUADS[0]);
+const uint8_t FILTER_DEFAULT_SECTIONS = 0; // Active at boot (IIR_SECTION_* bits): unfiltered until the master selects sections
+static_assert(FILTER_BIQUAD_COUNT <= IIR_MAX_BIQUADS, "At most IIR_MAX_BIQUADS biquad sections");
+
+// --- Measurement Mode ---
+// GAPLESS: every DMA sample is accumulated into back-to-back blocks of BLOCK_SAMPLES
+//   conversions per channel (before decimation). Blocks are counted in conversion slots,
+//   so a result is published every block, on a fixed cadence locked to the ADC sample clock.
+//   Each result covers the last WINDOW_BLOCKS blocks (sliding window; 1 block = tumbling).
+// LEGACY_DISCARD: original behaviour. Collect MAX_SAMPLES_PER_BATCH samples, then read and
+//   drop DMA frames until TARGET_BATCH_INTERVAL_MS has elapsed since the batch started.
+enum class MeasurementMode { GAPLESS, LEGACY_DISCARD };
+const MeasurementMode MEASUREMENT_MODE = MeasurementMode::GAPLESS;
+
+// --- Output Rate / Sliding Window (GAPLESS mode) ---
+const int OUTPUT_RATE_HZ = 10;     // Results published per second (10, 20 or 50; the S3 master polls at 10 Hz)
+const int WINDOW_LENGTH_MS = 1000; // Signal span covered by each result (multiple of the output period)
+const int MAX_WINDOW_BLOCKS = 64;  // Size of the block ring
+// Sample rate, output rate, window length and attenuation above are the boot defaults;
+// the master can change them per session over I2C (acq_config.h, REG_CONFIG).
+const int CONFIG_MAX_OUTPUT_RATE_HZ = 50; // Highest output rate a runtime configuration may select
+
+// --- Warm-Up (result state, RESULT_STATE_* in result_snapshot.h) ---
+// After boot or a reconfiguration the first block is only WARMUP_BLOCK_MS long, so the master
+// gets a provisional result within about one DMA frame instead of one output period; results
+// are flagged provisional until the window holds WINDOW_LENGTH_MS of full blocks again.
+const int WARMUP_BLOCK_MS = 20; // About one DMA frame at the default rate (shorter than any output period)
+static_assert(WARMUP_BLOCK_MS >= 1 && WARMUP_BLOCK_MS * CONFIG_MAX_OUTPUT_RATE_HZ <= 1000,
+              "Warm-up block must not be longer than an output period");
+// --- Spectrum Analysis Mode (spectrum.h) ---
+// Optional harmonic analysis: the processed stream is boxcar-decimated by SPECTRUM_DECIMATION
+// into SPECTRUM_FFT_SIZE-sample captures, which a low-priority task windows (Hann) and runs
+// through the esp-dsp fixed-point FFT. Captures that arrive while the task is busy are skipped,
+// so the ADC task never waits on the FFT.
+const bool SPECTRUM_MODE_ENABLED = false;
+const int SPECTRUM_FFT_SIZE = 1024;     // 1024 or 2048 points
+const int SPECTRUM_DECIMATION = 8;      // Power of two: 25 kHz / 8 = 3125 Hz, ~3 Hz bins at 1024 points
+static_assert(SPECTRUM_FFT_SIZE == 1024 || SPECTRUM_FFT_SIZE == 2048, "Unsupported FFT size");
+static_assert((SPECTRUM_DECIMATION & (SPECTRUM_DECIMATION - 1)) == 0, "Spectrum decimation must be a power of two");
+
+// --- Scope Mode (scope.h) ---
+// Pre/post-trigger capture of raw primary-channel codes, read out over I2C in chunks.
+const bool SCOPE_MODE_ENABLED = true;
+const int SCOPE_SAMPLES = 4096;               // Power of two (8 KB of uint16 codes)
+const int SCOPE_PRE_TRIGGER_SAMPLES = 1024;   // History kept before the trigger
+const int SCOPE_POST_TRIGGER_SAMPLES = SCOPE_SAMPLES - SCOPE_PRE_TRIGGER_SAMPLES;
+const int SCOPE_TRIGGER_LEVEL_MV = 500;       // Deviation from CURRENT_SENSOR_ZERO_MV (500 mV = 100 A); 0 disables
+const int SCOPE_TRIGGER_SLOPE_MV = 300;       // Frame-to-frame mean step (e.g. an ESC cut-out); 0 disables
+const int SCOPE_PACKED_BLOCK_SAMPLES = 256;    // Samples per packed block of a frozen capture (wave_codec.h)
+static_assert((SCOPE_SAMPLES & (SCOPE_SAMPLES - 1)) == 0, "Scope ring size must be a power of two");
+static_assert(SCOPE_SAMPLES % SCOPE_PACKED_BLOCK_SAMPLES == 0, "Packed blocks must tile the capture");
+static_assert(SCOPE_PRE_TRIGGER_SAMPLES < SCOPE_SAMPLES, "Pre-trigger history must leave room for post-trigger samples");
+
+// --- Overcurrent Alert (overcurrent.h) ---
+// Per-frame peak / RMS check against the sensor zero, driving an open-drain alert line to
+// the S3 within one DMA frame. The trip levels are the boot defaults; the master can change
+// them over I2C (REG_ALERT). 0.2 A per mV at the ADC pin (CURRENT_SENSOR_MA_PER_MV).
+const bool OVERCURRENT_ALERT_ENABLED = true;
+const int OVERCURRENT_ALERT_PIN = 10;       // C3 -> S3, open drain, low while tripped (pull-up at the S3)
+const int OVERCURRENT_PEAK_TRIP_MV = 750;   // Largest |sample - zero| in a frame (750 mV = 150 A); 0 disables
+const int OVERCURRENT_RMS_TRIP_MV = 400;    // RMS about the zero over a frame (400 mV = 80 A); 0 disables
+const int OVERCURRENT_HYSTERESIS_MV = 50;   // Released once both are this far below their trip levels
+static_assert((OVERCURRENT_PEAK_TRIP_MV == 0 || OVERCURRENT_PEAK_TRIP_MV > OVERCURRENT_HYSTERESIS_MV) &&
+              (OVERCURRENT_RMS_TRIP_MV == 0 || OVERCURRENT_RMS_TRIP_MV > OVERCURRENT_HYSTERESIS_MV),
+              "Enabled overcurrent trip levels must be above the hysteresis");
+
+// --- Raw Sample Stream (stream.h) ---
+// Optional full-rate forwarding of every DMA frame to the S3 through an SPI slave. Each
+// frame is packed once into a DMA transaction buffer (delta + Rice coded blocks per
+// channel, see wave_codec.h, or plain u16 words) and the SPI DMA sends it from there;
+// only the used length is clocked out. The C3 raises STREAM_READY_PIN while a frame is armed
+// and the S3 clocks it out at its own pace. Frames the master has not collected when all
+// STREAM_QUEUE_DEPTH buffers are in use are dropped and counted, never waited for.
+const bool STREAM_ENABLED = false;
+const bool STREAM_PACKED = true;   // false: plain (channel << 12 | code) words, e.g. to debug the link
+const int STREAM_SCLK_PIN = 6;     // From the S3 (SPI master)
+const int STREAM_MISO_PIN = 5;     // C3 -> S3 data
+const int STREAM_CS_PIN = 7;       // From the S3, active low
+const int STREAM_READY_PIN = 20;   // C3 -> S3 handshake: high while a frame is armed
+const int STREAM_QUEUE_DEPTH = 4;  // Frames buffered for the master (one per DMA frame, ~20 ms each)
+
+// --- Processing Pipeline (pipeline_config.h) ---
+// The settings above as one compile-time configuration. The ADC kernel is specialized for
+// it, and every derived size and rate below comes from it (checked by its static_asserts).
+using AdcPipeline = PipelineConfig<ADC_PATTERN_LEN, ADC_SAMPLE_FREQ_HZ, ADC_DECIMATION_FACTOR, ADC_READ_LEN, ADC_DMA_BUF_SIZE,
+                                   OUTPUT_RATE_HZ, WINDOW_LENGTH_MS, BATTERY_VOLTAGE_SLOT,
+                                   (SCOPE_MODE_ENABLED ? PIPELINE_STAGE_SCOPE : 0) |
+                                   (SPECTRUM_MODE_ENABLED ? PIPELINE_STAGE_SPECTRUM : 0) |
+                                   (STREAM_ENABLED ? PIPELINE_STAGE_STREAM : 0) |
+                                   (FILTER_STAGE_ENABLED ? PIPELINE_STAGE_FILTER : 0)>;
+const int ADC_CONVERSION_FREQ_HZ = AdcPipeline::CONVERSION_FREQ_HZ;    // Hardware conversion rate (all pattern entries)
+const int PROCESSING_SAMPLE_FREQ_HZ = AdcPipeline::PROCESSING_FREQ_HZ; // Rate seen by RMS / zero-crossing code
+const int ADC_CONV_FRAME_SIZE = AdcPipeline::FRAME_BYTES;              // Bytes per DMA frame
+const uint32_t BLOCK_SAMPLES = AdcPipeline::BLOCK_SAMPLES;             // Conversions per channel per output period
+const int WINDOW_BLOCKS = AdcPipeline::WINDOW_BLOCKS;                  // Blocks per window
+// LEGACY_DISCARD batch: NUM_CYCLES_AVERAGE cycles at MIN_EXPECTED_FREQ_HZ, in conversion slots
+const uint32_t MAX_SAMPLES_PER_BATCH = (uint32_t)ADC_CONVERSION_FREQ_HZ * NUM_CYCLES_AVERAGE / MIN_EXPECTED_FREQ_HZ;
+const int SPECTRUM_SAMPLE_FREQ_HZ = PROCESSING_SAMPLE_FREQ_HZ / SPECTRUM_DECIMATION;
+// Every section the build defines (IIR_SECTION_* bits), and the chain spec they come from
+const uint8_t FILTER_AVAILABLE_SECTIONS = FILTER_STAGE_ENABLED ? (uint8_t)(IIR_SECTION_DC_BLOCK | ((1 << (FILTER_BIQUAD_COUNT + 1)) - 2)) : 0;
+const IirChainSpec FILTER_CHAIN_SPEC = { FILTER_DC_CUTOFF_HZ, CURRENT_SENSOR_ZERO_MV, FILTER_BIQUADS, FILTER_BIQUAD_COUNT };
+static_assert((FILTER_DEFAULT_SECTIONS & ~FILTER_AVAILABLE_SECTIONS) == 0, "Default filter sections must exist in this build");
+static_assert(WINDOW_BLOCKS <= MAX_WINDOW_BLOCKS, "Window must span at most MAX_WINDOW_BLOCKS output periods");
+static_assert(!AdcPipeline::HAS_SPECTRUM || SPECTRUM_SAMPLE_FREQ_HZ / 2 > MAX_EXPECTED_FREQ_HZ,
+              "Spectrum Nyquist must be above the highest expected fundamental");
+
+// --- Logging (logger.h) ---
+// LOG_* calls only queue a binary record; a low-priority task formats and prints them.
+// Statements above LOG_LEVEL compile away completely (a preprocessor define so build
+// flags can override it, e.g. -DLOG_LEVEL=LOG_LEVEL_DEBUG).
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+const int LOG_RING_SIZE = 64;         // Records (power of two), 48 bytes each
+const int LOG_MAX_ARGS = 8;           // 32-bit arguments per record (no floats / 64-bit values)
+const uint32_t LOG_DRAIN_INTERVAL_MS = 20;
+// Serial TX ring: setup() banners are sent by the UART driver in the background instead of
+// holding up the ADC start at 115200 baud (~87 us per character)
+const size_t SERIAL_TX_BUFFER_BYTES = 2048;
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "Log ring size must be a power of two");
+
+// --- Profiler (profiler.h) ---
+// Cycle-counter probes with log2 histograms on the hot paths. 0 removes every probe
+// at compile time (the statistics logs and the I2C profile record then read as empty).
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// --- Self-Benchmark (benchmark.h) ---
+// Times every processing stage on a synthetic buffer before the ADC starts, at each boot
+// with SELF_BENCHMARK_AT_BOOT, or once after a "bench" command (Serial line or I2C
+// BENCH_CMD_RUN) restarts the C3 into it. The live CPU idle monitor runs either way.
+const bool SELF_BENCHMARK_AT_BOOT = false;
+const int BENCH_REPEATS = 16;                 // Runs per stage; the fastest counts (drops interrupted runs)
+const bool CPU_IDLE_MONITOR_ENABLED = true;   // Idle-hook based idle time (keeps the idle task out of WFI)
+const uint32_t CPU_IDLE_MAX_GAP_CYCLES = 1000; // Longer gaps between idle-hook calls count as busy
+
+// --- Memory Plan (arena.h) ---
+// Frame-sized work buffers live in one static, DMA-capable arena sized here at compile
+// time (nothing frame-sized on a task stack or the heap), so the stacks below only hold
+// locals. Stack sizes are in bytes (ESP-IDF FreeRTOS). The headroom left on each stack and
+// the free heap are reported with the ADC task's timing report and in the I2C memory record.
+const uint32_t ADC_TASK_STACK_BYTES = 4096;
+const uint32_t SPECTRUM_TASK_STACK_BYTES = 4096;
+const uint32_t LOG_TASK_STACK_BYTES = 3072;
+const uint32_t LED_TASK_STACK_BYTES = 2048;
+const uint32_t I2C_SLAVE_TASK_STACK_BYTES = 3072; // I2C_IDF_SLAVE_BACKEND service task (encodes records)
+const uint32_t STACK_HEADROOM_WARN_BYTES = 512; // Warn when a task's minimum headroom drops below this
+
 // --- Calibration Configuration Removed ---
 // const uint32_t CALIBRATION_HOLD_TIME_MS = 5000;
 // const uint32_t MEAN_SET_HOLD_TIME_MS = 3000;
@@ -48,6 +277,8 @@ const int TARGET_BATCH_INTERVAL_MS = 1000; // Target interval between batch star
 extern TaskHandle_t adcProcessingTaskHandle;
 // extern TaskHandle_t buttonMonitorTaskHandle; // Removed
 extern TaskHandle_t ledNormalFlashTaskHandle; // Kept for optional status LED
+extern TaskHandle_t spectrumTaskHandle; // Only created when SPECTRUM_MODE_ENABLED
+extern TaskHandle_t logTaskHandle; // Drains the deferred log ring (logger.h)
 extern adc_continuous_handle_t adcHandle;
 // extern nvs_handle_t nvsHandle; // Removed
 extern esp_adc_cal_characteristics_t adc_chars; // Added for ESP-IDF calibration
@@ -56,15 +287,15 @@ extern esp_adc_cal_characteristics_t adc_chars; // Added for ESP-IDF calibration
 // extern float adc_voltage_offset;
 // extern float adc_scaling_factor;
 // extern int32_t waveform_mean_level_adc; // Mean level calculated dynamically
-// Processing Buffers & State
+// Processing Buffers & State (written by the cycle detector in the ADC task)
 extern float cycle_frequencies[NUM_CYCLES_AVERAGE]; // Stores frequencies of last N cycles (in Hz)
 extern float cycle_rms_values[NUM_CYCLES_AVERAGE]; // Stores RMS of last N cycles (in mV)
-extern int cycle_buffer_index;
+extern int cycle_buffer_index; // Next slot to write in the circular buffers above
 extern int cycle_count; // How many cycles measured since last average calculation
 
-// Shared Results (updated by ADC task, read by I2C handler)
-extern volatile uint16_t latest_freq_hz;
-extern volatile uint16_t latest_rms_millivolts;
+// Shared Results (published once per window by the ADC task, read by the I2C handler)
+extern ResultSnapshot<MeasurementResult> latest_result;
+extern ResultSnapshot<SpectrumResult> latest_spectrum; // Published by the spectrum task
 
 // LED State Control (Removed - No more button feedback)
 // enum class LedState { NORMAL, CAL_MODE_ENTRY, CAL_ZERO_WAIT, CAL_ZERO_SET, CAL_SPAN_WAIT, CAL_SPAN_SET, MEAN_SET };
@@ -1,57 +1,593 @@
 #include "i2c_handler.h"
 #include "globals.h"
+#include "i2c_registers.h"
+#include "scope.h"
+#include "logger.h"
+#include "profiler.h"
+#include "benchmark.h"
+#include "arena.h"
+#include "acq_config.h"
+#include "overcurrent.h"
+#include "time_sync.h"
+#include "charge_counter.h"
+#include "pipeline_config.h"
+#include "i2c_slave_idf.h"
 #include <Wire.h> // Arduino I2C library
+#include <esp_timer.h>
 // #include <esp_log.h> // Using Serial.printf instead
 
 static const char *TAG = "I2CHandler";
 
-// --- Define Global Variables (declared extern in globals.h) ---
-volatile uint16_t latest_freq_hz = 0;
-volatile uint16_t latest_rms_millivolts = 0;
+I2cSlaveCounters i2c_counters = {};
 
 // --- Initialize I2C Slave ---
 void init_i2c_slave() {
+#if I2C_IDF_SLAVE_BACKEND
+    init_i2c_slave_idf();
+    return;
+#endif
     // Note: Wire.begin(address) automatically sets SDA/SCL pins based on board definition
     // For ESP32, default is usually GPIO21 (SDA), GPIO22 (SCL).
     // We need GPIO0 (SDA) and GPIO1 (SCL) as per pinout.md.
     // Explicitly set pins *before* Wire.begin().
-    bool success = Wire.setPins(0, 1); // SDA=GPIO0, SCL=GPIO1
+    bool success = Wire.setPins(I2C_SDA_PIN, I2C_SCL_PIN);
     if (!success) {
-         Serial.printf("E (%s): Failed to set I2C pins (SDA=0, SCL=1).\n", TAG);
+         Serial.printf("E (%s): Failed to set I2C pins (SDA=%d, SCL=%d).\n", TAG, I2C_SDA_PIN, I2C_SCL_PIN);
          // Handle error appropriately  
          return;
     }
-    Serial.printf("I (%s): Set I2C pins: SDA=0, SCL=1\n", TAG);
+    Serial.printf("I (%s): Set I2C pins: SDA=%d, SCL=%d\n", TAG, I2C_SDA_PIN, I2C_SCL_PIN);
 
     Wire.begin(I2C_SLAVE_ADDR);
     Serial.printf("I (%s): I2C Slave started with address 0x%02X\n", TAG, I2C_SLAVE_ADDR);
 
-    // Register the request handler function
+    // Register the request and receive (register select) handler functions
     Wire.onRequest(i2cRequestEvent);
-    Serial.printf("I (%s): I2C onRequest handler registered.\n", TAG);
+    Wire.onReceive(i2cReceiveEvent);
+    Serial.printf("I (%s): I2C onRequest/onReceive handlers registered.\n", TAG);
 }
 
-// --- I2C Request Event Handler ---
-// This function is called in an ISR context when the master requests data
-void i2cRequestEvent() {
-    // Prepare the data buffer (2 bytes: uint16_t rms only)
-    uint8_t buffer[2];
+// --- Register Pointer ---
+// Set by the master's register write (i2cReceiveEvent), consumed by the next read.
+static volatile uint8_t register_pointer = REG_RESULT;
+static volatile uint8_t register_bank = I2C_BANK_MAIN; // Set by a REG_BANK_SELECT write, for the next read only
+// Next scope chunk returned by REG_SCOPE_DATA / REG_SCOPE_PACKED (set by a REG_SCOPE_CHUNK write, advanced per read)
+static volatile uint16_t scope_chunk_index = 0;
+// Next profiler probe returned by REG_PROFILE (set by a REG_PROFILE_PROBE write, advanced per read)
+static volatile uint8_t profile_probe_index = 0;
+
+// --- Pre-encoded Measurement Record ---
+// Encoded by the ADC task once per result (i2c_stage_result), read by the I2C backend
+static ResultSnapshot<EncodedResultRecord> encoded_result;
+
+// --- CRC-8 (poly 0x07, init 0x00), bitwise: at most 39 bytes per request ---
+static uint8_t crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0x00;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
 
-    // Read the volatile global variable atomically (should be safe for uint16_t on ESP32)
-    uint16_t rms = latest_rms_millivolts;
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
 
-    // Serial.printf("D (%s): I2C request received. Sending RMS: %u mV\n", TAG, rms); // Debug level
+static void put_u64(uint8_t *p, uint64_t v) {
+    put_u32(&p[0], (uint32_t)v);
+    put_u32(&p[4], (uint32_t)(v >> 32));
+}
+
+// --- Measurement Record Encoder (layout in i2c_registers.h) ---
+static void encode_result_record(const MeasurementResult &result, uint8_t *out) {
+    put_u16(&out[REG_RESULT_RMS], result.rms_mv);
+    put_u16(&out[REG_RESULT_FREQ], result.freq_dhz);
+    put_u16(&out[REG_RESULT_PEAK], result.peak_mv);
+    put_u16(&out[REG_RESULT_MEAN], result.mean_mv);
+    put_u32(&out[REG_RESULT_SAMPLES], result.sample_count);
+    put_u32(&out[REG_RESULT_SEQUENCE], result.sequence);
+    put_u32(&out[REG_RESULT_TIMESTAMP], result.timestamp_ms);
+    put_u16(&out[REG_RESULT_MIN], result.min_mv);
+    put_u16(&out[REG_RESULT_MAX], result.max_mv);
+    put_u16(&out[REG_RESULT_CREST], result.crest_x100);
+    put_u16(&out[REG_RESULT_CONFIG_VERSION], result.config_version);
+    put_u16(&out[REG_RESULT_STATUS], result.flags);
+    out[REG_RESULT_VERSION] = I2C_RECORD_VERSION;
+    out[REG_RESULT_CRC] = crc8(out, REG_RESULT_CRC);
+}
+
+void i2c_stage_result(const MeasurementResult &result) {
+    EncodedResultRecord record;
+    record.sequence = result.sequence;
+    encode_result_record(result, record.bytes);
+    encoded_result.publish(record);
+#if I2C_IDF_SLAVE_BACKEND
+    i2c_slave_idf_result_ready();
+#endif
+}
+
+void i2c_encoded_result(EncodedResultRecord *out) {
+    if (!encoded_result.read(out)) {
+        MeasurementResult result = {}; // Never published -> all zero, VALID flag clear
+        out->sequence = 0;
+        encode_result_record(result, out->bytes);
+    }
+}
+
+// --- Spectrum Record Encoder (offsets relative to REG_SPECTRUM) ---
+static void encode_spectrum_record(const SpectrumResult &result, uint8_t *out) {
+    put_u16(&out[REG_SPECTRUM_FUNDAMENTAL_FREQ - REG_SPECTRUM], result.fundamental_dhz);
+    put_u16(&out[REG_SPECTRUM_FUNDAMENTAL - REG_SPECTRUM], result.fundamental_mv);
+    put_u16(&out[REG_SPECTRUM_THD - REG_SPECTRUM], result.thd_dpct);
+    put_u16(&out[REG_SPECTRUM_BIN_WIDTH - REG_SPECTRUM], result.bin_cdhz);
+    for (int h = 0; h < SPECTRUM_RESULT_HARMONICS; ++h) {
+        put_u16(&out[REG_SPECTRUM_HARMONICS - REG_SPECTRUM + 2 * h], result.harmonic_mv[h]);
+    }
+    put_u32(&out[REG_SPECTRUM_SEQUENCE - REG_SPECTRUM], result.sequence);
+    put_u32(&out[REG_SPECTRUM_TIMESTAMP - REG_SPECTRUM], result.timestamp_ms);
+    put_u16(&out[REG_SPECTRUM_SKIPPED - REG_SPECTRUM], result.skipped);
+    put_u16(&out[REG_SPECTRUM_STATUS - REG_SPECTRUM], result.flags);
+    put_u16(&out[REG_SPECTRUM_RESERVED - REG_SPECTRUM], 0);
+    out[REG_SPECTRUM_VERSION - REG_SPECTRUM] = I2C_SPECTRUM_VERSION;
+    out[REG_SPECTRUM_CRC - REG_SPECTRUM] = crc8(out, REG_SPECTRUM_CRC - REG_SPECTRUM);
+}
+
+// --- Channel Record Encoder (offsets relative to REG_CHANNELS) ---
+static void encode_channels_record(const MeasurementResult &result, uint8_t *out) {
+    memset(out, 0, CHANNELS_RECORD_LEN);
+    put_u32(&out[REG_CHANNELS_SEQUENCE - REG_CHANNELS], result.sequence);
+    out[REG_CHANNELS_COUNT - REG_CHANNELS] = ADC_PATTERN_LEN;
+    out[REG_CHANNELS_BATTERY_SLOT - REG_CHANNELS] = (BATTERY_VOLTAGE_SLOT >= 0) ? (uint8_t)BATTERY_VOLTAGE_SLOT : 0xFF;
+    put_u16(&out[REG_CHANNELS_BATTERY - REG_CHANNELS], result.battery_mv);
+    put_u32(&out[REG_CHANNELS_POWER - REG_CHANNELS], (uint32_t)result.power_mw);
+    for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+        uint8_t *entry = &out[REG_CHANNELS_ENTRIES - REG_CHANNELS + slot * CHANNEL_ENTRY_LEN];
+        entry[0] = (uint8_t)ADC_PATTERN[slot].channel;
+        entry[1] = (uint8_t)ADC_PATTERN[slot].role;
+        put_u16(&entry[2], result.channel_rms_mv[slot]);
+        put_u16(&entry[4], result.channel_mean_mv[slot]);
+    }
+    put_u16(&out[REG_CHANNELS_STATUS - REG_CHANNELS], result.flags);
+    out[REG_CHANNELS_VERSION - REG_CHANNELS] = I2C_CHANNELS_VERSION;
+    out[REG_CHANNELS_CRC - REG_CHANNELS] = crc8(out, REG_CHANNELS_CRC - REG_CHANNELS);
+}
 
-    // Pack the data (Little Endian: LSB first)
-    buffer[0] = rms & 0xFF;         // RMS LSB
-    buffer[1] = (rms >> 8) & 0xFF;  // RMS MSB
+// --- Scope Status Encoder (offsets relative to REG_SCOPE) ---
+static void encode_scope_status(uint8_t *out) {
+    ScopeStatus status = scope_get_status();
+    out[REG_SCOPE_CONTROL - REG_SCOPE] = (uint8_t)status.state;
+    out[REG_SCOPE_SOURCE - REG_SCOPE] = status.trigger_source;
+    put_u16(&out[REG_SCOPE_TRIGGER_INDEX - REG_SCOPE], status.trigger_index);
+    put_u16(&out[REG_SCOPE_LENGTH - REG_SCOPE], SCOPE_SAMPLES);
+    put_u16(&out[REG_SCOPE_CHUNK - REG_SCOPE], scope_chunk_index);
+    put_u32(&out[REG_SCOPE_SEQUENCE - REG_SCOPE], status.sequence);
+    put_u32(&out[REG_SCOPE_TIMESTAMP - REG_SCOPE], status.trigger_time_ms);
+    put_u16(&out[REG_SCOPE_CHUNK_SAMPLES - REG_SCOPE], SCOPE_CHUNK_SAMPLES);
+    put_u16(&out[REG_SCOPE_PACKED_BYTES - REG_SCOPE], status.packed_bytes);
+    put_u16(&out[REG_SCOPE_PACKED_BLOCK - REG_SCOPE], SCOPE_PACKED_BLOCK_SAMPLES);
+    out[REG_SCOPE_VERSION - REG_SCOPE] = I2C_SCOPE_VERSION;
+    out[REG_SCOPE_CRC - REG_SCOPE] = crc8(out, REG_SCOPE_CRC - REG_SCOPE);
+}
 
-    // Send the buffer to the master
-    size_t bytes_written = Wire.write(buffer, sizeof(buffer));
+// --- Scope Data Chunk Encoder (REG_SCOPE_DATA) ---
+static void encode_scope_chunk(uint8_t *out) {
+    uint16_t chunk = scope_chunk_index;
+    uint16_t samples[SCOPE_CHUNK_SAMPLES];
+    if (scope_read_samples((uint32_t)chunk * SCOPE_CHUNK_SAMPLES, samples, SCOPE_CHUNK_SAMPLES)) {
+        scope_chunk_index = chunk + 1;
+    } else {
+        chunk = 0xFFFF; // Not frozen, or past the end of the capture
+        memset(samples, 0, sizeof(samples));
+    }
+    put_u16(&out[0], chunk);
+    for (int i = 0; i < SCOPE_CHUNK_SAMPLES; ++i) {
+        put_u16(&out[2 + 2 * i], samples[i]);
+    }
+    out[SCOPE_DATA_LEN - 1] = crc8(out, SCOPE_DATA_LEN - 1);
+}
 
-    if (bytes_written != sizeof(buffer)) {
-         Serial.printf("W (%s): I2C write failed or wrote partial data (%d bytes)\n", TAG, bytes_written);
+// --- Packed Scope Chunk Encoder (REG_SCOPE_PACKED) ---
+static void encode_scope_packed_chunk(uint8_t *out) {
+    uint16_t chunk = scope_chunk_index;
+    ScopeStatus status = scope_get_status();
+    if ((uint32_t)chunk * SCOPE_PACKED_CHUNK_BYTES < status.packed_bytes &&
+        scope_read_packed((uint32_t)chunk * SCOPE_PACKED_CHUNK_BYTES, &out[2], SCOPE_PACKED_CHUNK_BYTES)) {
+        scope_chunk_index = chunk + 1;
     } else {
-         // Serial.printf("D (%s): Sent %d bytes via I2C.\n", TAG, bytes_written); // Debug level
+        chunk = 0xFFFF; // Not frozen, or past the end of the packed capture
+        memset(&out[2], 0, SCOPE_PACKED_CHUNK_BYTES);
+    }
+    put_u16(&out[0], chunk);
+    out[SCOPE_DATA_LEN - 1] = crc8(out, SCOPE_DATA_LEN - 1);
+}
+
+// --- Profile Record Encoder (offsets relative to REG_PROFILE) ---
+static void encode_profile_record(uint8_t *out) {
+    uint8_t probe = profile_probe_index;
+    if (probe >= PROBE_COUNT) {
+        probe = 0;
     }
-}
\ No newline at end of file
+    profile_probe_index = (uint8_t)((probe + 1) % PROBE_COUNT);
+    ProfileStats stats;
+    ProfileSummary summary;
+    profiler_snapshot((ProfileProbe)probe, &stats);
+    profiler_summarize(&stats, NULL, &summary);
+    out[REG_PROFILE_PROBE - REG_PROFILE] = probe;
+    out[REG_PROFILE_PROBE_COUNT - REG_PROFILE] = PROBE_COUNT;
+    put_u16(&out[REG_PROFILE_CPU_MHZ - REG_PROFILE], (uint16_t)getCpuFrequencyMhz());
+    put_u32(&out[REG_PROFILE_COUNT - REG_PROFILE], summary.count);
+    put_u32(&out[REG_PROFILE_AVG - REG_PROFILE], summary.avg_us);
+    put_u32(&out[REG_PROFILE_P50 - REG_PROFILE], summary.p50_us);
+    put_u32(&out[REG_PROFILE_P90 - REG_PROFILE], summary.p90_us);
+    put_u32(&out[REG_PROFILE_P99 - REG_PROFILE], summary.p99_us);
+    put_u32(&out[REG_PROFILE_MAX - REG_PROFILE], summary.max_us);
+    put_u16(&out[REG_PROFILE_RESERVED - REG_PROFILE], 0);
+    out[REG_PROFILE_VERSION - REG_PROFILE] = I2C_PROFILE_VERSION;
+    out[REG_PROFILE_CRC - REG_PROFILE] = crc8(out, REG_PROFILE_CRC - REG_PROFILE);
+}
+
+// --- Benchmark Record Encoder (offsets relative to REG_BENCH) ---
+static void encode_bench_record(uint8_t *out) {
+    BenchmarkReport report = {};
+    latest_benchmark.read(&report); // No benchmark at this boot -> all zero
+    put_u16(&out[REG_BENCH_DECODE - REG_BENCH], report.decode_dcps);
+    put_u16(&out[REG_BENCH_ACCUMULATE - REG_BENCH], report.accumulate_dcps);
+    put_u16(&out[REG_BENCH_DETECTOR - REG_BENCH], report.detector_dcps);
+    put_u16(&out[REG_BENCH_CIC - REG_BENCH], report.cic_dcps);
+    put_u16(&out[REG_BENCH_KERNEL - REG_BENCH], report.kernel_dcps);
+    put_u16(&out[REG_BENCH_CPU_IDLE - REG_BENCH], cpu_idle_latest());
+    put_u32(&out[REG_BENCH_FFT - REG_BENCH], report.fft_cycles);
+    put_u32(&out[REG_BENCH_MAX_RATE - REG_BENCH], report.max_rate_hz);
+    put_u16(&out[REG_BENCH_STATUS - REG_BENCH], report.flags);
+    out[REG_BENCH_VERSION - REG_BENCH] = I2C_BENCH_VERSION;
+    out[REG_BENCH_CRC - REG_BENCH] = crc8(out, REG_BENCH_CRC - REG_BENCH);
+}
+
+// --- Memory Record Encoder (offsets relative to REG_MEMORY) ---
+static void encode_memory_record(uint8_t *out) {
+    MemoryReport report = {};
+    latest_memory.read(&report); // No report interval closed yet -> all zero
+    put_u32(&out[REG_MEMORY_FREE_HEAP - REG_MEMORY], report.free_heap);
+    put_u32(&out[REG_MEMORY_MIN_FREE_HEAP - REG_MEMORY], report.min_free_heap);
+    put_u32(&out[REG_MEMORY_LARGEST_BLOCK - REG_MEMORY], report.largest_free_block);
+    for (int i = 0; i < MEMORY_TASK_COUNT; ++i) {
+        put_u16(&out[REG_MEMORY_STACKS - REG_MEMORY + 2 * i], report.stack_headroom[i]);
+    }
+    out[REG_MEMORY_VERSION - REG_MEMORY] = I2C_MEMORY_VERSION;
+    out[REG_MEMORY_CRC - REG_MEMORY] = crc8(out, REG_MEMORY_CRC - REG_MEMORY);
+}
+static_assert(REG_MEMORY_STACKS + 2 * MEMORY_TASK_COUNT <= REG_MEMORY_VERSION, "Memory record has room for every task");
+
+// --- Acquisition Config Record Encoder (offsets relative to REG_CONFIG) ---
+static void encode_config_record(uint8_t *out) {
+    ConfigStatus status = {};
+    config_status.read(&status); // ADC task not started yet -> all zero
+    uint8_t reject = 0;
+    ConfigState state = acq_config_state(status, &reject);
+    put_u32(&out[REG_CONFIG_SAMPLE_FREQ - REG_CONFIG], status.active.sample_freq_hz);
+    put_u16(&out[REG_CONFIG_WINDOW - REG_CONFIG], status.active.window_length_ms);
+    out[REG_CONFIG_OUTPUT_RATE - REG_CONFIG] = status.active.output_rate_hz;
+    out[REG_CONFIG_ATTEN - REG_CONFIG] = status.active.atten;
+    out[REG_CONFIG_FILTER - REG_CONFIG] = status.active.filter_sections;
+    out[REG_CONFIG_FILTER_AVAILABLE - REG_CONFIG] = FILTER_AVAILABLE_SECTIONS;
+    put_u16(&out[REG_CONFIG_VERSION - REG_CONFIG], status.version);
+    out[REG_CONFIG_STATE - REG_CONFIG] = (uint8_t)state;
+    out[REG_CONFIG_REJECT - REG_CONFIG] = reject;
+    out[REG_CONFIG_LAYOUT_VERSION - REG_CONFIG] = I2C_CONFIG_VERSION;
+    out[REG_CONFIG_CRC - REG_CONFIG] = crc8(out, REG_CONFIG_CRC - REG_CONFIG);
+}
+
+// --- Acquisition Config Write (same field layout as the record, then a CRC-8) ---
+static void handle_config_write(const uint8_t *payload, size_t len) {
+    if (len != CONFIG_WRITE_LEN || crc8(payload, CONFIG_WRITE_LEN - 1) != payload[CONFIG_WRITE_LEN - 1]) {
+        acq_config_reject(CONFIG_REJECT_FORMAT);
+        return;
+    }
+    AcquisitionConfig cfg = {};
+    cfg.sample_freq_hz = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    cfg.window_length_ms = (uint16_t)(payload[4] | (payload[5] << 8));
+    cfg.output_rate_hz = payload[6];
+    cfg.atten = payload[7];
+    cfg.filter_sections = payload[8];
+    uint8_t reject = acq_config_request(cfg); // Applied by the ADC task, not in this callback
+    if (reject != 0) {
+        LOG_W(TAG, "Config write rejected (reasons 0x%02X)", reject);
+    }
+}
+
+// --- Overcurrent Alert Record Encoder (offsets relative to REG_ALERT) ---
+static void encode_alert_record(uint8_t *out) {
+    OvercurrentStatus status = overcurrent_get_status();
+    out[REG_ALERT_STATE - REG_ALERT] = (status.active ? ALERT_STATE_ACTIVE : 0) | (status.latched ? ALERT_STATE_LATCHED : 0);
+    out[REG_ALERT_SOURCE - REG_ALERT] = status.source;
+    put_u16(&out[REG_ALERT_PEAK_TRIP - REG_ALERT], status.thresholds.peak_trip_mv);
+    put_u16(&out[REG_ALERT_RMS_TRIP - REG_ALERT], status.thresholds.rms_trip_mv);
+    put_u16(&out[REG_ALERT_HYSTERESIS - REG_ALERT], status.thresholds.hysteresis_mv);
+    put_u16(&out[REG_ALERT_TRIPS - REG_ALERT], status.trips);
+    out[REG_ALERT_VERSION - REG_ALERT] = I2C_ALERT_VERSION;
+    out[REG_ALERT_CRC - REG_ALERT] = crc8(out, REG_ALERT_CRC - REG_ALERT);
+}
+
+// --- Overcurrent Alert Write: a command byte, or the trip levels plus a CRC-8 ---
+static void handle_alert_write(const uint8_t *payload, size_t len) {
+    if (len == 1) {
+        if (payload[0] == ALERT_CMD_CLEAR) {
+            overcurrent_request_clear();
+        }
+        return;
+    }
+    if (len != ALERT_WRITE_LEN || crc8(payload, ALERT_WRITE_LEN - 1) != payload[ALERT_WRITE_LEN - 1]) {
+        LOG_W(TAG, "Alert threshold write ignored (%u bytes, bad length or CRC)", (unsigned)len);
+        return;
+    }
+    OvercurrentThresholds thresholds = {};
+    thresholds.peak_trip_mv = (uint16_t)(payload[0] | (payload[1] << 8));
+    thresholds.rms_trip_mv = (uint16_t)(payload[2] | (payload[3] << 8));
+    thresholds.hysteresis_mv = (uint16_t)(payload[4] | (payload[5] << 8));
+    if (!overcurrent_request_thresholds(thresholds)) { // Applied by the ADC task at the next frame
+        LOG_W(TAG, "Alert thresholds rejected: trip levels must be above the hysteresis (%u mV)", thresholds.hysteresis_mv);
+    }
+}
+
+// --- I2C Stats Record Encoder (offsets relative to REG_I2C_STATS) ---
+static void encode_i2c_stats_record(uint8_t *out) {
+    uint16_t dropped = i2c_counters.dropped_writes;
+#if I2C_IDF_SLAVE_BACKEND
+    dropped += i2c_slave_idf_isr_dropped(); // Writes the driver callback could not queue
+#endif
+    put_u16(&out[REG_I2C_STATS_BUS_ERRORS - REG_I2C_STATS], i2c_counters.bus_errors);
+    put_u16(&out[REG_I2C_STATS_DROPPED - REG_I2C_STATS], dropped);
+    put_u16(&out[REG_I2C_STATS_STRETCHED - REG_I2C_STATS], i2c_counters.stretched_reads);
+    out[REG_I2C_STATS_VERSION - REG_I2C_STATS] = I2C_STATS_VERSION;
+    out[REG_I2C_STATS_CRC - REG_I2C_STATS] = crc8(out, REG_I2C_STATS_CRC - REG_I2C_STATS);
+}
+
+// --- Charge Record Encoder (extended bank, offsets relative to REG_EXT_CHARGE) ---
+static void encode_charge_record(uint8_t *out) {
+    ChargeStatus status = charge_get_status();
+    const ChargeTotals &t = status.totals;
+    int64_t elapsed_us = t.last_us - t.first_us;
+    put_u64(&out[REG_EXT_CHARGE_CHARGE - REG_EXT_CHARGE], (uint64_t)t.charge_uc);
+    put_u64(&out[REG_EXT_CHARGE_ENERGY - REG_EXT_CHARGE], (uint64_t)t.energy_uj);
+    put_u32(&out[REG_EXT_CHARGE_COVERED - REG_EXT_CHARGE], (uint32_t)(t.covered_us / 1000));
+    put_u32(&out[REG_EXT_CHARGE_ELAPSED - REG_EXT_CHARGE], (uint32_t)(elapsed_us > 0 ? elapsed_us / 1000 : 0));
+    put_u16(&out[REG_EXT_CHARGE_RESETS - REG_EXT_CHARGE], status.resets);
+    put_u16(&out[REG_EXT_CHARGE_SNAPSHOTS - REG_EXT_CHARGE], status.snapshots);
+    out[REG_EXT_CHARGE_FLAGS - REG_EXT_CHARGE] = (status.held ? CHARGE_FLAG_HELD : 0) | (AdcPipeline::HAS_POWER ? CHARGE_FLAG_ENERGY : 0);
+    out[REG_EXT_CHARGE_RESERVED - REG_EXT_CHARGE] = 0;
+    out[REG_EXT_CHARGE_VERSION - REG_EXT_CHARGE] = I2C_CHARGE_VERSION;
+    out[REG_EXT_CHARGE_CRC - REG_EXT_CHARGE] = crc8(out, REG_EXT_CHARGE_CRC - REG_EXT_CHARGE);
+}
+
+// --- Window Times Record Encoder (extended bank, offsets relative to REG_EXT_TIMES) ---
+static void encode_times_record(uint8_t *out) {
+    MeasurementResult result = {};
+    latest_result.read(&result); // No window yet -> all zero
+    put_u32(&out[REG_EXT_TIMES_SEQUENCE], result.sequence);
+    put_u64(&out[REG_EXT_TIMES_START], (uint64_t)result.window_start_us);
+    put_u64(&out[REG_EXT_TIMES_END], (uint64_t)result.window_end_us);
+    put_u32(&out[REG_EXT_TIMES_SYNCS], time_sync_get_status().syncs);
+    put_u16(&out[REG_EXT_TIMES_STATUS], result.flags);
+    out[REG_EXT_TIMES_VERSION] = I2C_TIMES_VERSION;
+    out[REG_EXT_TIMES_CRC] = crc8(out, REG_EXT_TIMES_CRC);
+}
+
+// --- Master Time Sync Write: u64 master time (us) plus a CRC-8 ---
+static void handle_time_sync_write(const uint8_t *payload, size_t len, int64_t received_us) {
+    if (len != TIME_SYNC_WRITE_LEN || crc8(payload, TIME_SYNC_WRITE_LEN - 1) != payload[TIME_SYNC_WRITE_LEN - 1]) {
+        LOG_W(TAG, "Time sync write ignored (%u bytes, bad length or CRC)", (unsigned)len);
+        return;
+    }
+    uint64_t master_us = 0;
+    for (int i = 7; i >= 0; --i) {
+        master_us = (master_us << 8) | payload[i];
+    }
+    time_sync_apply(received_us, (int64_t)master_us);
+}
+
+// --- Register Writes ---
+// Payload bytes that follow the register byte in a master write.
+static void handle_register_write(uint8_t reg, const uint8_t *payload, size_t len) {
+    if (reg == REG_SCOPE_CONTROL) {
+        if (payload[0] == SCOPE_CMD_ARM) {
+            scope_chunk_index = 0;
+            scope_request_arm();
+        } else if (payload[0] == SCOPE_CMD_TRIGGER) {
+            scope_request_trigger();
+        }
+    } else if (reg == REG_SCOPE_CHUNK && len >= 2) {
+        scope_chunk_index = (uint16_t)(payload[0] | (payload[1] << 8));
+    } else if (reg == REG_PROFILE_PROBE) {
+        profile_probe_index = payload[0];
+    } else if (reg == REG_BENCH_CONTROL && payload[0] == BENCH_CMD_RUN) {
+        benchmark_request_restart(); // loop() restarts, not the I2C callback
+    } else if (reg == REG_CONFIG) {
+        handle_config_write(payload, len);
+    } else if (reg == REG_ALERT) {
+        handle_alert_write(payload, len);
+    }
+    // Other registers are read-only: payload ignored
+}
+
+// Extended bank writes (after REG_BANK_SELECT, bank and register)
+static void handle_extended_write(uint8_t reg, const uint8_t *payload, size_t len, int64_t received_us) {
+    if (reg == REG_EXT_TIMES) {
+        handle_time_sync_write(payload, len, received_us);
+    } else if (reg == REG_EXT_CHARGE) {
+        charge_request(payload[0]);
+    }
+    // Other registers are read-only: payload ignored
+}
+
+void i2c_handle_master_write(const uint8_t *data, size_t len, int64_t received_us) {
+    if (len == 0) {
+        return;
+    }
+    register_bank = I2C_BANK_MAIN;
+    register_pointer = data[0];
+    if (data[0] == REG_BANK_SELECT && len >= 3) {
+        register_bank = data[1];
+        register_pointer = data[2];
+        if (len > 3 && data[1] == I2C_BANK_EXTENDED) {
+            handle_extended_write(data[2], &data[3], len - 3, received_us);
+        } else if (len > 3 && data[1] == I2C_BANK_MAIN) {
+            handle_register_write(data[2], &data[3], len - 3);
+        }
+    } else if (len > 1) {
+        handle_register_write(data[0], &data[1], len - 1);
+    }
+}
+
+uint8_t i2c_register_pointer() {
+    return register_pointer;
+}
+
+uint8_t i2c_register_bank() {
+    return register_bank;
+}
+
+// --- I2C Receive Event Handler ---
+// The first byte of a master write selects the register for the following read;
+// any further bytes are written to that register. Over-long writes are not applied.
+void i2cReceiveEvent(int num_bytes) {
+    int64_t received_us = esp_timer_get_time(); // Before anything else: a time sync write is dated by it
+    if (num_bytes <= 0) {
+        return;
+    }
+    uint8_t data[1 + I2C_MAX_WRITE_PAYLOAD];
+    size_t len = 0;
+    while (Wire.available()) {
+        uint8_t b = (uint8_t)Wire.read();
+        if (len < sizeof(data)) {
+            data[len] = b;
+        }
+        len++;
+    }
+    if (len > sizeof(data)) {
+        i2c_counters.dropped_writes++;
+        register_bank = I2C_BANK_MAIN;
+        register_pointer = data[0]; // The register select still holds
+        return;
+    }
+    i2c_handle_master_write(data, len, received_us);
+}
+
+// --- Response Encoder ---
+// From the selected register to the end of its block, shared by both backends.
+size_t i2c_encode_response(uint8_t bank, uint8_t reg, uint8_t *buffer, const uint8_t **start) {
+    register_bank = I2C_BANK_MAIN;
+    register_pointer = REG_RESULT; // Plain reads always start at the record
+    *start = buffer;
+    size_t len = 0;
+
+    if (bank != I2C_BANK_MAIN) {
+        if (bank == I2C_BANK_EXTENDED && reg >= REG_EXT_TIMES && reg < REG_EXT_TIMES + TIMES_RECORD_LEN) {
+            encode_times_record(buffer);
+            *start = &buffer[reg - REG_EXT_TIMES];
+            len = TIMES_RECORD_LEN - (reg - REG_EXT_TIMES);
+        } else if (bank == I2C_BANK_EXTENDED && reg >= REG_EXT_CHARGE && reg < REG_EXT_CHARGE + CHARGE_RECORD_LEN) {
+            encode_charge_record(buffer);
+            *start = &buffer[reg - REG_EXT_CHARGE];
+            len = CHARGE_RECORD_LEN - (reg - REG_EXT_CHARGE);
+        } else {
+            buffer[0] = 0; // Unmapped register or bank
+            len = 1;
+        }
+    } else if (reg < RESULT_RECORD_LEN) {
+        // Pre-encoded by the ADC task (lock-free copy, ISR safe)
+        EncodedResultRecord record;
+        i2c_encoded_result(&record);
+        memcpy(buffer, record.bytes, RESULT_RECORD_LEN);
+        *start = &buffer[reg];
+        len = RESULT_RECORD_LEN - reg;
+    } else if (reg >= REG_PROFILE && reg < REG_PROFILE + PROFILE_RECORD_LEN) {
+        encode_profile_record(buffer);
+        *start = &buffer[reg - REG_PROFILE];
+        len = PROFILE_RECORD_LEN - (reg - REG_PROFILE);
+    } else if (reg >= REG_BENCH && reg < REG_BENCH + BENCH_RECORD_LEN) {
+        encode_bench_record(buffer);
+        *start = &buffer[reg - REG_BENCH];
+        len = BENCH_RECORD_LEN - (reg - REG_BENCH);
+    } else if (reg >= REG_MEMORY && reg < REG_MEMORY + MEMORY_RECORD_LEN) {
+        encode_memory_record(buffer);
+        *start = &buffer[reg - REG_MEMORY];
+        len = MEMORY_RECORD_LEN - (reg - REG_MEMORY);
+    } else if (reg >= REG_SPECTRUM && reg < REG_SPECTRUM + SPECTRUM_RECORD_LEN) {
+        SpectrumResult spectrum = {};
+        latest_spectrum.read(&spectrum); // Spectrum mode off / no capture yet -> all zero
+        encode_spectrum_record(spectrum, buffer);
+        *start = &buffer[reg - REG_SPECTRUM];
+        len = SPECTRUM_RECORD_LEN - (reg - REG_SPECTRUM);
+    } else if (reg >= REG_CHANNELS && reg < REG_CHANNELS + CHANNELS_RECORD_LEN) {
+        MeasurementResult result = {};
+        latest_result.read(&result);
+        encode_channels_record(result, buffer);
+        *start = &buffer[reg - REG_CHANNELS];
+        len = CHANNELS_RECORD_LEN - (reg - REG_CHANNELS);
+    } else if (reg >= REG_CONFIG && reg < REG_CONFIG + CONFIG_RECORD_LEN) {
+        encode_config_record(buffer);
+        *start = &buffer[reg - REG_CONFIG];
+        len = CONFIG_RECORD_LEN - (reg - REG_CONFIG);
+    } else if (reg >= REG_ALERT && reg < REG_ALERT + ALERT_RECORD_LEN) {
+        encode_alert_record(buffer);
+        *start = &buffer[reg - REG_ALERT];
+        len = ALERT_RECORD_LEN - (reg - REG_ALERT);
+    } else if (reg >= REG_SCOPE && reg < REG_SCOPE + SCOPE_STATUS_LEN) {
+        encode_scope_status(buffer);
+        *start = &buffer[reg - REG_SCOPE];
+        len = SCOPE_STATUS_LEN - (reg - REG_SCOPE);
+    } else if (reg >= REG_I2C_STATS && reg < REG_I2C_STATS + I2C_STATS_RECORD_LEN) {
+        encode_i2c_stats_record(buffer);
+        *start = &buffer[reg - REG_I2C_STATS];
+        len = I2C_STATS_RECORD_LEN - (reg - REG_I2C_STATS);
+    } else if (reg == REG_SCOPE_DATA) {
+        encode_scope_chunk(buffer);
+        len = SCOPE_DATA_LEN;
+    } else if (reg == REG_SCOPE_PACKED) {
+        encode_scope_packed_chunk(buffer);
+        len = SCOPE_DATA_LEN;
+    } else if (reg == REG_DEVICE_ID) {
+        buffer[0] = I2C_DEVICE_ID;
+        buffer[1] = I2C_PROTOCOL_VERSION;
+        len = 2;
+    } else if (reg == REG_PROTOCOL_VERSION) {
+        buffer[0] = I2C_PROTOCOL_VERSION;
+        len = 1;
+    } else {
+        buffer[0] = 0; // Unmapped register
+        len = 1;
+    }
+    return len;
+}
+static_assert(RESULT_RECORD_LEN <= I2C_MAX_RESPONSE_LEN && SPECTRUM_RECORD_LEN <= I2C_MAX_RESPONSE_LEN &&
+              CHANNELS_RECORD_LEN <= I2C_MAX_RESPONSE_LEN && SCOPE_STATUS_LEN <= I2C_MAX_RESPONSE_LEN &&
+              SCOPE_DATA_LEN <= I2C_MAX_RESPONSE_LEN && CHARGE_RECORD_LEN <= I2C_MAX_RESPONSE_LEN &&
+              TIMES_RECORD_LEN <= I2C_MAX_RESPONSE_LEN, "I2C_MAX_RESPONSE_LEN covers every record");
+
+// --- I2C Request Event Handler ---
+// Called when the master requests data. Sends from the selected register to the
+// end of its block in one burst; the master is clock-stretched meanwhile.
+void i2cRequestEvent() {
+    PROFILE_SCOPE(PROBE_I2C_REQUEST);
+    uint8_t buffer[I2C_MAX_RESPONSE_LEN];
+    const uint8_t *start;
+    size_t len = i2c_encode_response(register_bank, register_pointer, buffer, &start);
+    i2c_counters.stretched_reads++; // Wire builds every response on request
+
+    size_t bytes_written = Wire.write(start, len);
+
+    if (bytes_written != len) {
+        i2c_counters.bus_errors++; // Reported in the I2C stats record (no log while the bus is held)
+    }
+}
@@ -2,21 +2,89 @@
 #define I2C_HANDLER_H
 
 #include "globals.h"
+#include "i2c_registers.h"
 
 // --- Function Declarations ---
 
 /**
  * @brief Initializes the I2C peripheral in Slave mode.
- * Sets the slave address and registers the request handler.
+ * Sets the slave address and registers the request and receive handlers (Wire), or
+ * starts the ESP-IDF slave backend with I2C_IDF_SLAVE_BACKEND (i2c_slave_idf.h).
  */
 void init_i2c_slave();
 
+/**
+ * @brief I2C receive event handler.
+ * Called by the Wire library when the I2C Master writes to the slave. The first
+ * byte selects the start register (see i2c_registers.h) for the next read.
+ * @param num_bytes Number of bytes written by the master.
+ */
+void i2cReceiveEvent(int num_bytes);
+
 /**
  * @brief I2C request event handler (ISR context).
  * Called by the Wire library when the I2C Master requests data.
- * Reads the latest averaged RMS value and sends it (2 bytes, little endian).
+ * Sends from the selected register to the end of its block; the measurement record
+ * is the copy pre-encoded by i2c_stage_result(). Every record carries a CRC-8 so the
+ * master can reject corrupt reads.
  */
 void i2cRequestEvent();
 
+/**
+ * @brief Encodes a published result into the 32-byte measurement record once, so a
+ * master read only copies it (ADC task, right after latest_result.publish()).
+ * The IDF backend is also told to stage it in the slave TX FIFO.
+ */
+void i2c_stage_result(const MeasurementResult &result);
+
+// --- Backend Interface (Wire callbacks or the IDF slave service task) ---
+
+// A measurement record as encoded at publish time
+struct EncodedResultRecord {
+    uint32_t sequence; // Window sequence (0 = nothing published yet)
+    uint8_t bytes[RESULT_RECORD_LEN];
+};
+
+/**
+ * @brief The latest pre-encoded measurement record; a zeroed record (VALID flag clear,
+ * CRC valid) before the first result.
+ */
+void i2c_encoded_result(EncodedResultRecord *out);
+
+/**
+ * @brief Applies one master write: data[0] selects the register for the next read,
+ * any further bytes are that register's payload (after the bank and register of a
+ * REG_BANK_SELECT write).
+ * @param received_us esp_timer when the write arrived (dates a time sync write to REG_EXT_TIMES).
+ */
+void i2c_handle_master_write(const uint8_t *data, size_t len, int64_t received_us);
+
+/**
+ * @brief Encodes the response to a read starting at `reg` of `bank` (to the end of its
+ * block) and returns the pointer reset to REG_RESULT (main bank) for the read after it.
+ * @param buffer At least I2C_MAX_RESPONSE_LEN bytes.
+ * @param start Set to the first byte to send (inside `buffer`).
+ * @return Bytes to send.
+ */
+size_t i2c_encode_response(uint8_t bank, uint8_t reg, uint8_t *buffer, const uint8_t **start);
+
+/**
+ * @brief Register the next read starts at (the latest write, or REG_RESULT).
+ */
+uint8_t i2c_register_pointer();
+
+/**
+ * @brief Bank of i2c_register_pointer() (I2C_BANK_MAIN unless a REG_BANK_SELECT write chose another).
+ */
+uint8_t i2c_register_bank();
+
+// Slave counters (I2C stats record). Written only by the backend's task context (Wire
+// callbacks or the IDF service task), which also encodes the record.
+struct I2cSlaveCounters {
+    uint16_t bus_errors;      // Failed or partial response writes
+    uint16_t dropped_writes;  // Master writes not applied
+    uint16_t stretched_reads; // Reads that waited for the response to be built
+};
+extern I2cSlaveCounters i2c_counters;
 
-#endif // I2C_HANDLER_H
\ No newline at end of file
+#endif // I2C_HANDLER_H
@@ -0,0 +1,414 @@
+#ifndef I2C_REGISTERS_H
+#define I2C_REGISTERS_H
+
+#include <stdint.h>
+
+// --- I2C Register Map (slave 0x08) ---
+// The master writes a one-byte start register, then burst-reads (repeated start or a
+// separate read). Writable registers take their payload after the register byte. Multi-byte fields are little endian. After every read the register
+// pointer returns to REG_RESULT, so a plain read without a register write still
+// starts with the RMS field (compatible with the old 2-byte protocol).
+//
+// Measurement record (one published window, read all 32 bytes from REG_RESULT):
+//   0x00 u16  RMS (mV)
+//   0x02 u16  Frequency (0.1 Hz units), 0 if no cycles detected
+//   0x04 u16  Peak (mV, largest deviation from the window mean)
+//   0x06 u16  Mean (mV)
+//   0x08 u32  Sample count
+//   0x0C u32  Window sequence number
+//   0x10 u32  Timestamp (ms since C3 boot, when the window closed)
+//   0x14 u16  Minimum sample (mV)
+//   0x16 u16  Maximum sample (mV)
+//   0x18 u16  Crest factor (peak / RMS, x100)
+//   0x1A u16  Config version the window was measured with (REG_CONFIG_VERSION)
+//   0x1C u16  Status flags (RESULT_FLAG_* in result_snapshot.h; bits 6..7 RESULT_STATE_* warm-up state, bit 8 overcurrent latched,
+//             bit 9 frames lost to a DMA pool overflow, bit 10 ADC driver restarted after a stall, bit 11 window times on the master's clock)
+//   0x1E u8   Record layout version (I2C_RECORD_VERSION)
+//   0x1F u8   CRC-8 (poly 0x07, init 0x00) over bytes 0x00..0x1E
+// Record version 1 ended after the timestamp with status/version/CRC at 0x14..0x17;
+// version 2 had 0x1A reserved. The window's sample times are in the window times record
+// of the extended bank (below).
+//
+// Profile record (one profiler probe per read, statistics since boot, read all 32 bytes from REG_PROFILE):
+//   0x20 u8   Probe index (ProfileProbe in profiler.h)                 W: u8 probe index
+//   0x21 u8   Probe count
+//   0x22 u16  CPU clock (MHz)
+//   0x24 u32  Samples recorded
+//   0x28 u32  Average (us)
+//   0x2C u32  50th percentile (us)
+//   0x30 u32  90th percentile (us)
+//   0x34 u32  99th percentile (us)
+//   0x38 u32  Maximum (us)
+//   0x3C u16  Reserved (0)
+//   0x3E u8   Record layout version (I2C_PROFILE_VERSION)
+//   0x3F u8   CRC-8 over bytes 0x20..0x3E
+// The probe index advances after every read (wrapping), so PROBE_COUNT consecutive
+// reads return every probe. Percentiles have log2-bucket resolution; all zero when the
+// firmware is built with PROFILER_ENABLED 0.
+//
+// Spectrum record (SPECTRUM_MODE_ENABLED builds, read all 40 bytes from REG_SPECTRUM):
+//   0x40 u16  Fundamental frequency (0.1 Hz units), 0 if none found
+//   0x42 u16  Fundamental RMS (mV)
+//   0x44 u16  THD over harmonics 2..9 (0.1 % units)
+//   0x46 u16  FFT bin width (0.01 Hz units)
+//   0x48 u16  Harmonic 2..9 RMS (mV), 8 entries, 0 above Nyquist
+//   0x58 u32  Capture sequence number (0 = no spectrum yet / spectrum mode disabled)
+//   0x5C u32  Timestamp (ms since C3 boot, when the analysis finished)
+//   0x60 u16  Captures skipped since the previous result
+//   0x62 u16  Status flags (SPECTRUM_FLAG_* in result_snapshot.h)
+//   0x64 u16  Reserved (0)
+//   0x66 u8   Record layout version (I2C_SPECTRUM_VERSION)
+//   0x67 u8   CRC-8 over bytes 0x40..0x66
+//
+// Benchmark record (self-benchmark of this boot + live CPU idle, read all 24 bytes from REG_BENCH):
+//   0x68 u16  Decode (0.1 cycles per conversion slot)                 W: command (BENCH_CMD_*)
+//   0x6A u16  Accumulate: fused kernel, frequency detector idle (0.1 cycles per slot)
+//   0x6C u16  Frequency detector (0.1 cycles per processed sample)
+//   0x6E u16  CIC decimator (0.1 cycles per input sample)
+//   0x70 u16  Fused kernel as configured (0.1 cycles per slot)
+//   0x72 u16  Live CPU idle over the last report interval (0.1 %), 0xFFFF if unknown
+//   0x74 u32  FFT analysis (cycles per capture), 0 if not measured
+//   0x78 u32  Maximum sustainable conversion rate (Hz, all channels)
+//   0x7C u16  Status flags (BENCH_FLAG_* in benchmark.h); 0 if no benchmark ran at this boot
+//   0x7E u8   Record layout version (I2C_BENCH_VERSION)
+//   0x7F u8   CRC-8 over bytes 0x68..0x7E
+// Cycle figures use the CPU clock from the profile record. BENCH_CMD_RUN restarts the
+// C3 into the benchmark (acquisition stops for about a second).
+//
+// Channel record (one entry per ADC_PATTERN slot, read all 40 bytes from REG_CHANNELS):
+//   0x80 u32  Window sequence number (same window as the measurement record)
+//   0x84 u8   Channel count (pattern length)
+//   0x85 u8   Battery voltage slot (0xFF if no voltage channel)
+//   0x86 u16  Battery voltage (mV, after divider scaling)
+//   0x88 i32  Mean power V*I over the window (mW)
+//   0x8C      4 entries of 6 bytes: u8 ADC channel, u8 role (ChannelRole), u16 RMS (mV), u16 mean (mV)
+//   0xA4 u16  Status flags (RESULT_FLAG_*)
+//   0xA6 u8   Record layout version (I2C_CHANNELS_VERSION)
+//   0xA7 u8   CRC-8 over bytes 0x80..0xA6
+//
+// Memory record (heap and per-task stack headroom, read all 24 bytes from REG_MEMORY):
+//   0xA8 u32  Free heap (bytes)
+//   0xAC u32  Minimum free heap since boot (bytes)
+//   0xB0 u32  Largest free heap block (bytes)
+//   0xB4 u16  Stack headroom: ADC task (bytes, minimum since the task started)
+//   0xB6 u16  Stack headroom: spectrum task
+//   0xB8 u16  Stack headroom: log task
+//   0xBA u16  Stack headroom: LED task
+//   0xBC u16  Stack headroom: Arduino loop task
+//   0xBE u8   Record layout version (I2C_MEMORY_VERSION)
+//   0xBF u8   CRC-8 over bytes 0xA8..0xBE
+// Refreshed once per ADC report interval (all zero before the first one); headroom is
+// 0xFFFF for a task that is not running.
+//
+// Scope status (read all 24 bytes from REG_SCOPE):
+//   0xC0 u8   State (ScopeState: 0 armed, 1 triggered, 2 frozen)     W: command (SCOPE_CMD_*)
+//   0xC1 u8   Trigger source (SCOPE_TRIGGER_SOURCE_* | SCOPE_CAPTURE_GAP)
+//   0xC2 u16  Trigger sample index within the capture
+//   0xC4 u16  Capture length (samples)
+//   0xC6 u16  Next chunk index for REG_SCOPE_DATA                       W: u16 chunk index
+//   0xC8 u32  Capture sequence number (captures frozen since boot)
+//   0xCC u32  Trigger timestamp (ms since C3 boot)
+//   0xD0 u16  Samples per chunk
+//   0xD2 u16  Packed capture size (bytes, 0 unless frozen)
+//   0xD4 u16  Samples per packed block
+//   0xD6 u8   Record layout version (I2C_SCOPE_VERSION)
+//   0xD7 u8   CRC-8 over bytes 0xC0..0xD6
+// Scope status version 1 ended after the chunk size with version/CRC at 0xD2..0xD3.
+//
+// I2C slave statistics (since boot, wrapping; read all 8 bytes from REG_I2C_STATS):
+//   0xD8 u16  Bus errors (failed or partial response writes to the slave TX buffer)
+//   0xDA u16  Dropped writes (master writes not applied: too long, or no room in the
+//             I2C_IDF_SLAVE_BACKEND write queue)
+//   0xDC u16  Stretched reads (the response was not staged when the read began; always
+//             counts the reads of a Wire build, where every response is built on request)
+//   0xDE u8   Record layout version (I2C_STATS_VERSION)
+//   0xDF u8   CRC-8 over bytes 0xD8..0xDE
+// The slave cannot see its own NACKs: a write the C3 could not take is NACKed by the
+// driver and counted in 0xDA. Writes rejected for their content (CRC, range) are reported
+// by the record they target, not here.
+//
+// Scope data (frozen captures only, oldest sample first, raw 12-bit ADC codes):
+//   0xE0      u16 chunk index, SCOPE_CHUNK_SAMPLES x u16 codes, u8 CRC-8 (35 bytes).
+//             The chunk index advances after every read, so consecutive reads stream
+//             the whole capture. Reads when not frozen return chunk index 0xFFFF.
+//   0xE1      Packed capture (wave_codec.h blocks): u16 chunk index, SCOPE_PACKED_CHUNK_BYTES
+//             bytes of the packed capture (zero past its end), u8 CRC-8 (35 bytes). Same
+//             chunk index as 0xE0; ceil(packed size / SCOPE_PACKED_CHUNK_BYTES) reads
+//             instead of capture length / SCOPE_CHUNK_SAMPLES.
+//
+// Acquisition config (runtime configuration, acq_config.h; read all 16 bytes from REG_CONFIG):
+//   0xE2 u32  Sample rate (Hz per channel, before decimation)           W: new configuration, see below
+//   0xE6 u16  Window length (ms)
+//   0xE8 u8   Output rate (Hz)
+//   0xE9 u8   Attenuation (adc_atten_t)
+//   0xEA u8   Filter sections (IIR_SECTION_* bits: 0 DC blocker, 1 + i biquad i of FILTER_BIQUADS)
+//   0xEB u8   Filter sections this build has (read only)
+//   0xEC u16  Config version (configurations applied since boot, 0 = build defaults)
+//   0xEE u8   State of the latest write (ConfigState: 0 active, 1 pending, 2 rejected, 3 failed)
+//   0xEF u8   Reject reasons of the latest write (CONFIG_REJECT_* in acq_config.h)
+//   0xF0 u8   Record layout version (I2C_CONFIG_VERSION)
+//   0xF1 u8   CRC-8 over bytes 0xE2..0xF0
+// Fields 0xE2..0xEA are the active configuration. A write to REG_CONFIG carries the same
+// 9 bytes plus a CRC-8 over them (10 payload bytes); it is validated at once (state 2 if
+// invalid, nothing changes) and applied by the ADC task at the next block boundary (state
+// 1 until then). Rate and attenuation changes restart the ADC (one frame dropped, marked as
+// a gap); the window and the filter state restart either way. Not kept across a reset.
+// Config version 1 had no filter fields (version at 0xEA, 14 bytes, 8-byte writes).
+//
+// Overcurrent alert (overcurrent.h; read all 12 bytes from REG_ALERT):
+//   0xF2 u8   State: bit 0 alert pin asserted, bit 1 latched           W: command (ALERT_CMD_*) or thresholds, see below
+//   0xF3 u8   Trip sources since the latch was cleared (OVERCURRENT_SOURCE_*)
+//   0xF4 u16  Peak trip level (mV deviation from the sensor zero, 0 = disabled)
+//   0xF6 u16  RMS trip level (mV about the sensor zero over one frame, 0 = disabled)
+//   0xF8 u16  Hysteresis (mV)
+//   0xFA u16  Trips since boot (wraps)
+//   0xFC u8   Record layout version (I2C_ALERT_VERSION)
+//   0xFD u8   CRC-8 over bytes 0xF2..0xFC
+// The alert pin (OVERCURRENT_ALERT_PIN, open drain, active low) follows the comparator; the
+// latch, also RESULT_FLAG_OVERCURRENT in every result, stays set until ALERT_CMD_CLEAR (it
+// sets again at once while the pin is still asserted). A write of the 6 bytes 0xF4..0xF9
+// plus a CRC-8 over them (7 payload bytes) sets new trip levels from the next frame; it is
+// ignored if the CRC fails or an enabled level is not above the hysteresis (read back to
+// check). Not kept across a reset.
+//
+// Identification:
+//   0xFE u8   I2C_DEVICE_ID                                             W: bank select, see below
+//   0xFF u8   I2C_PROTOCOL_VERSION
+//
+// --- Extended Bank (I2C_BANK_EXTENDED) ---
+// Registers added once this map was full. The master writes REG_BANK_SELECT followed by
+// the bank and a start register (plus that register's payload, for a write); the next read
+// starts there. Like every read it returns the pointer to REG_RESULT in this bank, so each
+// extended read takes its own bank select write, and a master that never writes
+// REG_BANK_SELECT sees the map above only. Extended addresses are byte-addressed the same way.
+//
+// Window times (the window of the latest measurement record, read all 28 bytes from REG_EXT_TIMES):
+//   0x00 u32  Window sequence number (same window as the measurement record)  W: time sync, see below
+//   0x04 i64  First sample time (us)
+//   0x0C i64  Last sample time (us)
+//   0x14 u32  Time syncs applied since boot (0 = never synced)
+//   0x18 u16  Status flags (RESULT_FLAG_*, as in the measurement record)
+//   0x1A u8   Record layout version (I2C_TIMES_VERSION)
+//   0x1B u8   CRC-8 over bytes 0x00..0x1A
+// Sample times are when the window's first and last conversions completed, dated from the
+// DMA frame interrupts (not from when the C3 got to the frame). They count us since C3 boot
+// until the master writes its clock: a u64 master time (us, any epoch) plus a CRC-8 over it,
+// 9 payload bytes to REG_EXT_TIMES, stands for the moment the write's last byte arrives.
+// From then on (status bit 11) both times are on the master's clock. Offset only: repeat
+// the write every few seconds to keep the C3's crystal drift below a millisecond (time_sync.h).
+//
+// Charge and energy counter (charge_counter.h; read all 32 bytes from REG_EXT_CHARGE):
+//   0x20 i64  Charge (uC, current above the sensor zero positive)       W: command (CHARGE_CMD_*)
+//   0x28 i64  Energy (uJ, 0 without CHARGE_FLAG_ENERGY)
+//   0x30 u32  Covered time (ms of signal in the totals)
+//   0x34 u32  Elapsed time (ms from the first to the last integrated sample)
+//   0x38 u16  Resets since boot (wraps)
+//   0x3A u16  Snapshots since boot (wraps)
+//   0x3C u8   Flags (CHARGE_FLAG_*)
+//   0x3D u8   Reserved (0)
+//   0x3E u8   Record layout version (I2C_CHARGE_VERSION)
+//   0x3F u8   CRC-8 over bytes 0x20..0x3E
+// Integrated at the conversion rate and updated once per block. Covered time below the
+// elapsed time means frames were lost (pool overflow, read timeout) and are not counted.
+// While CHARGE_FLAG_HELD, the record shows the snapshot taken by CHARGE_CMD_SNAPSHOT and
+// the live totals keep running; CHARGE_CMD_LIVE releases it. Not kept across a reset.
+// Extended addresses 0x1C..0x1F and 0x40..0xFF are unmapped.
+
+const uint8_t REG_RESULT = 0x00;
+const uint8_t REG_RESULT_RMS = 0x00;
+const uint8_t REG_RESULT_FREQ = 0x02;
+const uint8_t REG_RESULT_PEAK = 0x04;
+const uint8_t REG_RESULT_MEAN = 0x06;
+const uint8_t REG_RESULT_SAMPLES = 0x08;
+const uint8_t REG_RESULT_SEQUENCE = 0x0C;
+const uint8_t REG_RESULT_TIMESTAMP = 0x10;
+const uint8_t REG_RESULT_MIN = 0x14;
+const uint8_t REG_RESULT_MAX = 0x16;
+const uint8_t REG_RESULT_CREST = 0x18;
+const uint8_t REG_RESULT_CONFIG_VERSION = 0x1A;
+const uint8_t REG_RESULT_STATUS = 0x1C;
+const uint8_t REG_RESULT_VERSION = 0x1E;
+const uint8_t REG_RESULT_CRC = 0x1F;
+const uint8_t RESULT_RECORD_LEN = 0x20;
+
+const uint8_t REG_PROFILE = 0x20;
+const uint8_t REG_PROFILE_PROBE = 0x20;
+const uint8_t REG_PROFILE_PROBE_COUNT = 0x21;
+const uint8_t REG_PROFILE_CPU_MHZ = 0x22;
+const uint8_t REG_PROFILE_COUNT = 0x24;
+const uint8_t REG_PROFILE_AVG = 0x28;
+const uint8_t REG_PROFILE_P50 = 0x2C;
+const uint8_t REG_PROFILE_P90 = 0x30;
+const uint8_t REG_PROFILE_P99 = 0x34;
+const uint8_t REG_PROFILE_MAX = 0x38;
+const uint8_t REG_PROFILE_RESERVED = 0x3C;
+const uint8_t REG_PROFILE_VERSION = 0x3E;
+const uint8_t REG_PROFILE_CRC = 0x3F;
+const uint8_t PROFILE_RECORD_LEN = 0x20;
+
+const uint8_t REG_SPECTRUM = 0x40;
+const uint8_t REG_SPECTRUM_FUNDAMENTAL_FREQ = 0x40;
+const uint8_t REG_SPECTRUM_FUNDAMENTAL = 0x42;
+const uint8_t REG_SPECTRUM_THD = 0x44;
+const uint8_t REG_SPECTRUM_BIN_WIDTH = 0x46;
+const uint8_t REG_SPECTRUM_HARMONICS = 0x48;
+const uint8_t REG_SPECTRUM_SEQUENCE = 0x58;
+const uint8_t REG_SPECTRUM_TIMESTAMP = 0x5C;
+const uint8_t REG_SPECTRUM_SKIPPED = 0x60;
+const uint8_t REG_SPECTRUM_STATUS = 0x62;
+const uint8_t REG_SPECTRUM_RESERVED = 0x64;
+const uint8_t REG_SPECTRUM_VERSION = 0x66;
+const uint8_t REG_SPECTRUM_CRC = 0x67;
+const uint8_t SPECTRUM_RECORD_LEN = 0x28;
+
+const uint8_t REG_BENCH = 0x68;
+const uint8_t REG_BENCH_CONTROL = 0x68;
+const uint8_t REG_BENCH_DECODE = 0x68;
+const uint8_t REG_BENCH_ACCUMULATE = 0x6A;
+const uint8_t REG_BENCH_DETECTOR = 0x6C;
+const uint8_t REG_BENCH_CIC = 0x6E;
+const uint8_t REG_BENCH_KERNEL = 0x70;
+const uint8_t REG_BENCH_CPU_IDLE = 0x72;
+const uint8_t REG_BENCH_FFT = 0x74;
+const uint8_t REG_BENCH_MAX_RATE = 0x78;
+const uint8_t REG_BENCH_STATUS = 0x7C;
+const uint8_t REG_BENCH_VERSION = 0x7E;
+const uint8_t REG_BENCH_CRC = 0x7F;
+const uint8_t BENCH_RECORD_LEN = 0x18;
+
+const uint8_t BENCH_CMD_RUN = 0x01; // Restart into the self-benchmark
+
+const uint8_t REG_CHANNELS = 0x80;
+const uint8_t REG_CHANNELS_SEQUENCE = 0x80;
+const uint8_t REG_CHANNELS_COUNT = 0x84;
+const uint8_t REG_CHANNELS_BATTERY_SLOT = 0x85;
+const uint8_t REG_CHANNELS_BATTERY = 0x86;
+const uint8_t REG_CHANNELS_POWER = 0x88;
+const uint8_t REG_CHANNELS_ENTRIES = 0x8C;
+const uint8_t CHANNEL_ENTRY_LEN = 6;
+const uint8_t REG_CHANNELS_STATUS = 0xA4;
+const uint8_t REG_CHANNELS_VERSION = 0xA6;
+const uint8_t REG_CHANNELS_CRC = 0xA7;
+const uint8_t CHANNELS_RECORD_LEN = 0x28;
+
+const uint8_t REG_MEMORY = 0xA8;
+const uint8_t REG_MEMORY_FREE_HEAP = 0xA8;
+const uint8_t REG_MEMORY_MIN_FREE_HEAP = 0xAC;
+const uint8_t REG_MEMORY_LARGEST_BLOCK = 0xB0;
+const uint8_t REG_MEMORY_STACKS = 0xB4; // MEMORY_TASK_COUNT x u16, in MemoryTask order
+const uint8_t REG_MEMORY_VERSION = 0xBE;
+const uint8_t REG_MEMORY_CRC = 0xBF;
+const uint8_t MEMORY_RECORD_LEN = 0x18;
+
+const uint8_t REG_SCOPE = 0xC0;
+const uint8_t REG_SCOPE_CONTROL = 0xC0;
+const uint8_t REG_SCOPE_SOURCE = 0xC1;
+const uint8_t REG_SCOPE_TRIGGER_INDEX = 0xC2;
+const uint8_t REG_SCOPE_LENGTH = 0xC4;
+const uint8_t REG_SCOPE_CHUNK = 0xC6;
+const uint8_t REG_SCOPE_SEQUENCE = 0xC8;
+const uint8_t REG_SCOPE_TIMESTAMP = 0xCC;
+const uint8_t REG_SCOPE_CHUNK_SAMPLES = 0xD0;
+const uint8_t REG_SCOPE_PACKED_BYTES = 0xD2;
+const uint8_t REG_SCOPE_PACKED_BLOCK = 0xD4;
+const uint8_t REG_SCOPE_VERSION = 0xD6;
+const uint8_t REG_SCOPE_CRC = 0xD7;
+const uint8_t SCOPE_STATUS_LEN = 0x18;
+const uint8_t REG_I2C_STATS = 0xD8;
+const uint8_t REG_I2C_STATS_BUS_ERRORS = 0xD8;
+const uint8_t REG_I2C_STATS_DROPPED = 0xDA;
+const uint8_t REG_I2C_STATS_STRETCHED = 0xDC;
+const uint8_t REG_I2C_STATS_VERSION = 0xDE;
+const uint8_t REG_I2C_STATS_CRC = 0xDF;
+const uint8_t I2C_STATS_RECORD_LEN = 0x08;
+const uint8_t REG_SCOPE_DATA = 0xE0;
+const uint8_t REG_SCOPE_PACKED = 0xE1;
+const uint8_t SCOPE_CHUNK_SAMPLES = 16;
+const uint8_t SCOPE_DATA_LEN = 2 + SCOPE_CHUNK_SAMPLES * 2 + 1;
+const uint8_t SCOPE_PACKED_CHUNK_BYTES = SCOPE_CHUNK_SAMPLES * 2; // Same record length as REG_SCOPE_DATA
+
+const uint8_t SCOPE_CMD_ARM = 0x01;     // Discard the capture and re-arm
+const uint8_t SCOPE_CMD_TRIGGER = 0x02; // Force a trigger
+
+const uint8_t REG_CONFIG = 0xE2;
+const uint8_t REG_CONFIG_SAMPLE_FREQ = 0xE2;
+const uint8_t REG_CONFIG_WINDOW = 0xE6;
+const uint8_t REG_CONFIG_OUTPUT_RATE = 0xE8;
+const uint8_t REG_CONFIG_ATTEN = 0xE9;
+const uint8_t REG_CONFIG_FILTER = 0xEA;
+const uint8_t REG_CONFIG_FILTER_AVAILABLE = 0xEB;
+const uint8_t REG_CONFIG_VERSION = 0xEC;
+const uint8_t REG_CONFIG_STATE = 0xEE;
+const uint8_t REG_CONFIG_REJECT = 0xEF;
+const uint8_t REG_CONFIG_LAYOUT_VERSION = 0xF0;
+const uint8_t REG_CONFIG_CRC = 0xF1;
+const uint8_t CONFIG_RECORD_LEN = 0x10;
+const uint8_t CONFIG_WRITE_LEN = 10; // Sample rate .. filter sections, CRC-8
+
+const uint8_t REG_ALERT = 0xF2;
+const uint8_t REG_ALERT_STATE = 0xF2;
+const uint8_t REG_ALERT_SOURCE = 0xF3;
+const uint8_t REG_ALERT_PEAK_TRIP = 0xF4;
+const uint8_t REG_ALERT_RMS_TRIP = 0xF6;
+const uint8_t REG_ALERT_HYSTERESIS = 0xF8;
+const uint8_t REG_ALERT_TRIPS = 0xFA;
+const uint8_t REG_ALERT_VERSION = 0xFC;
+const uint8_t REG_ALERT_CRC = 0xFD;
+const uint8_t ALERT_RECORD_LEN = 0x0C;
+const uint8_t ALERT_WRITE_LEN = 7; // Peak trip, RMS trip, hysteresis, CRC-8
+
+const uint8_t ALERT_STATE_ACTIVE = 1 << 0;
+const uint8_t ALERT_STATE_LATCHED = 1 << 1;
+const uint8_t ALERT_CMD_CLEAR = 0x01; // Clear the latch
+
+const int I2C_MAX_WRITE_PAYLOAD = 16; // Bytes accepted after the register byte
+const int I2C_MAX_RESPONSE_LEN = 40;  // Longest record a read can return (spectrum, channels)
+
+const uint8_t REG_DEVICE_ID = 0xFE;
+const uint8_t REG_BANK_SELECT = 0xFE; // W: u8 bank, u8 start register [+ payload]
+const uint8_t REG_PROTOCOL_VERSION = 0xFF;
+
+// Extended bank (reached through REG_BANK_SELECT)
+const uint8_t I2C_BANK_MAIN = 0;
+const uint8_t I2C_BANK_EXTENDED = 1;
+const uint8_t REG_EXT_TIMES = 0x00;
+const uint8_t REG_EXT_TIMES_SEQUENCE = 0x00;
+const uint8_t REG_EXT_TIMES_START = 0x04;
+const uint8_t REG_EXT_TIMES_END = 0x0C;
+const uint8_t REG_EXT_TIMES_SYNCS = 0x14;
+const uint8_t REG_EXT_TIMES_STATUS = 0x18;
+const uint8_t REG_EXT_TIMES_VERSION = 0x1A;
+const uint8_t REG_EXT_TIMES_CRC = 0x1B;
+const uint8_t TIMES_RECORD_LEN = 0x1C;
+const uint8_t REG_EXT_CHARGE = 0x20;
+const uint8_t REG_EXT_CHARGE_CHARGE = 0x20;
+const uint8_t REG_EXT_CHARGE_ENERGY = 0x28;
+const uint8_t REG_EXT_CHARGE_COVERED = 0x30;
+const uint8_t REG_EXT_CHARGE_ELAPSED = 0x34;
+const uint8_t REG_EXT_CHARGE_RESETS = 0x38;
+const uint8_t REG_EXT_CHARGE_SNAPSHOTS = 0x3A;
+const uint8_t REG_EXT_CHARGE_FLAGS = 0x3C;
+const uint8_t REG_EXT_CHARGE_RESERVED = 0x3D;
+const uint8_t REG_EXT_CHARGE_VERSION = 0x3E;
+const uint8_t REG_EXT_CHARGE_CRC = 0x3F;
+const uint8_t CHARGE_RECORD_LEN = 0x20;
+const uint8_t CHARGE_FLAG_HELD = 1 << 0;   // The totals are the held snapshot
+const uint8_t CHARGE_FLAG_ENERGY = 1 << 1; // This build integrates energy (battery voltage channel)
+const uint8_t TIME_SYNC_WRITE_LEN = 9; // u64 master time (us), CRC-8
+
+const uint8_t I2C_DEVICE_ID = 0xC3;
+const uint8_t I2C_PROTOCOL_VERSION = 16; // 2: spectrum block, 3: channel block, 4: scope, 5: profile record, 6: benchmark record, 7: packed scope data, 8: memory record, 9: runtime config, 10: result warm-up state, 11: filter sections in the config record, 12: overcurrent alert, 13: I2C statistics, 14: dropped-frame and ADC restart flags, 15: window sample times and master time sync (extended bank), 16: charge/energy counter (extended bank)
+const uint8_t I2C_RECORD_VERSION = 3;
+const uint8_t I2C_SPECTRUM_VERSION = 1;
+const uint8_t I2C_CHANNELS_VERSION = 1;
+const uint8_t I2C_SCOPE_VERSION = 2;
+const uint8_t I2C_PROFILE_VERSION = 1;
+const uint8_t I2C_BENCH_VERSION = 1;
+const uint8_t I2C_MEMORY_VERSION = 1;
+const uint8_t I2C_CONFIG_VERSION = 2;
+const uint8_t I2C_ALERT_VERSION = 1;
+const uint8_t I2C_STATS_VERSION = 1;
+const uint8_t I2C_TIMES_VERSION = 1;
+const uint8_t I2C_CHARGE_VERSION = 1;
+
+#endif // I2C_REGISTERS_H
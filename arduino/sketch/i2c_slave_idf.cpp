@@ -0,0 +1,239 @@
+#include "i2c_slave_idf.h"
+
+#if I2C_IDF_SLAVE_BACKEND
+
+#include "i2c_handler.h"
+#include <driver/i2c_slave.h>
+#include <hal/i2c_ll.h>
+#include <freertos/queue.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <string.h> // For memcpy
+
+#if !CONFIG_I2C_ENABLE_SLAVE_DRIVER_VERSION_2
+#error "I2C_IDF_SLAVE_BACKEND needs the version 2 i2c_slave driver (CONFIG_I2C_ENABLE_SLAVE_DRIVER_VERSION_2, ESP-IDF 5.4+)"
+#endif
+
+static const char *TAG = "I2CSlaveIDF";
+
+// --- Service Queue ---
+enum class SlaveEvent : uint8_t {
+    MASTER_WRITE, // Register select (+ payload) in data
+    READ_WAITING, // A read found the TX FIFO empty: the master is stretched
+    RESULT_READY, // The ADC task pre-encoded a new result
+};
+
+struct SlaveMessage {
+    SlaveEvent event;
+    uint8_t len;
+    uint8_t data[1 + I2C_MAX_WRITE_PAYLOAD];
+    int64_t received_us; // esp_timer at the receive callback (dates a time sync write)
+};
+
+static i2c_slave_dev_handle_t slave_handle = NULL;
+static QueueHandle_t slave_queue = NULL;
+static TaskHandle_t i2cSlaveTaskHandle = NULL;
+static i2c_dev_t *const slave_hw = I2C_LL_GET_HW(I2C_NUM_0);
+
+// --- State Shared with the Driver Callbacks ---
+// Set by the service task once a result record is staged from its first byte, cleared by
+// whichever context empties the FIFO (the receive callback or the service task).
+static volatile bool fifo_holds_result = false;
+static volatile uint16_t isr_dropped = 0;      // Receive callback only
+static volatile bool result_ready_queued = false; // At most one RESULT_READY waits (ADC task sets, service task clears)
+
+// --- Service Task State ---
+static uint32_t staged_sequence = 0; // Window sequence of the staged result
+
+// --- Driver Callbacks (ISR context): copy and hand over, nothing else ---
+static bool IRAM_ATTR on_receive(i2c_slave_dev_handle_t handle, const i2c_slave_rx_done_event_data_t *evt, void *arg) {
+    if (evt->length == 0) {
+        return false;
+    }
+    if (evt->length > 1 || evt->buffer[0] != REG_RESULT || !fifo_holds_result) {
+        // The staged bytes are not what this write selects: the next read stretches
+        // until the service task has staged the right record
+        i2c_ll_txfifo_rst(slave_hw);
+        fifo_holds_result = false;
+    }
+    SlaveMessage msg;
+    if (evt->length > sizeof(msg.data)) {
+        isr_dropped++; // Longer than any register write
+        return false;
+    }
+    msg.event = SlaveEvent::MASTER_WRITE;
+    msg.received_us = esp_timer_get_time();
+    msg.len = (uint8_t)evt->length;
+    memcpy(msg.data, evt->buffer, evt->length);
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(slave_queue, &msg, &woken) != pdTRUE) {
+        isr_dropped++;
+    }
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR on_request(i2c_slave_dev_handle_t handle, const i2c_slave_request_event_data_t *evt, void *arg) {
+    SlaveMessage msg;
+    msg.event = SlaveEvent::READ_WAITING;
+    msg.len = 0;
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(slave_queue, &msg, &woken); // Queue full: the task is busy staging anyway
+    return woken == pdTRUE;
+}
+
+// --- Staging (service task) ---
+static uint32_t tx_fifo_pending() {
+    uint32_t free_len = 0;
+    i2c_ll_get_txfifo_len(slave_hw, &free_len);
+    return SOC_I2C_FIFO_LEN - free_len;
+}
+
+// Replacing the FIFO contents is safe once it is empty (a read stretches) or no transfer is running
+static bool can_restage() {
+    return tx_fifo_pending() == 0 || !i2c_ll_is_bus_busy(slave_hw);
+}
+
+static void stage_bytes(const uint8_t *data, size_t len) {
+    i2c_ll_txfifo_rst(slave_hw);
+    uint32_t written = 0;
+    esp_err_t ret = i2c_slave_write(slave_handle, data, len, &written, 0);
+    if (ret != ESP_OK || written != len) {
+        i2c_counters.bus_errors++;
+    }
+}
+
+static void stage_result() {
+    EncodedResultRecord record;
+    i2c_encoded_result(&record);
+    fifo_holds_result = false;
+    stage_bytes(record.bytes, RESULT_RECORD_LEN);
+    staged_sequence = record.sequence;
+    fifo_holds_result = true;
+}
+
+// The latest result is staged, complete and unread
+static bool staged_result_current() {
+    EncodedResultRecord record;
+    i2c_encoded_result(&record);
+    return fifo_holds_result && tx_fifo_pending() == RESULT_RECORD_LEN && staged_sequence == record.sequence;
+}
+
+// Response to the selected register (consumes the pointer like a Wire read)
+static void stage_response() {
+    uint8_t bank = i2c_register_bank();
+    uint8_t reg = i2c_register_pointer();
+    if (bank == I2C_BANK_MAIN && reg == REG_RESULT) {
+        stage_result();
+        return;
+    }
+    uint8_t buffer[I2C_MAX_RESPONSE_LEN];
+    const uint8_t *start;
+    size_t len = i2c_encode_response(bank, reg, buffer, &start);
+    fifo_holds_result = false;
+    stage_bytes(start, len);
+}
+
+// Between transfers: the next plain read must find the latest result, unless another
+// register's response is still waiting for its read
+static void restage_result_if_idle() {
+    if (uxQueueMessagesWaiting(slave_queue) > 0 || (!fifo_holds_result && tx_fifo_pending() > 0)) {
+        return;
+    }
+    if (!staged_result_current() && can_restage()) {
+        stage_result();
+    }
+}
+
+static void i2cSlaveTask(void *parameter) {
+    SlaveMessage msg;
+    for (;;) {
+        // The master drains the FIFO without an event: poll while the bus is quiet
+        if (xQueueReceive(slave_queue, &msg, pdMS_TO_TICKS(I2C_SLAVE_IDLE_RESTAGE_MS)) != pdTRUE) {
+            restage_result_if_idle();
+            continue;
+        }
+        switch (msg.event) {
+            case SlaveEvent::MASTER_WRITE:
+                i2c_handle_master_write(msg.data, msg.len, msg.received_us);
+                if (msg.len == 1 && msg.data[0] == REG_RESULT) {
+                    if (!staged_result_current() && can_restage()) {
+                        stage_result(); // Otherwise the read in progress gets the previous, complete record
+                    }
+                } else {
+                    stage_response(); // FIFO already emptied by the receive callback
+                }
+                break;
+            case SlaveEvent::READ_WAITING:
+                i2c_counters.stretched_reads++;
+                stage_response();
+                break;
+            case SlaveEvent::RESULT_READY:
+                result_ready_queued = false;
+                restage_result_if_idle();
+                break;
+        }
+    }
+}
+
+bool init_i2c_slave_idf() {
+    slave_queue = xQueueCreate(I2C_SLAVE_QUEUE_LEN, sizeof(SlaveMessage));
+    if (slave_queue == NULL) {
+        Serial.printf("E (%s): Failed to create the service queue\n", TAG);
+        return false;
+    }
+
+    i2c_slave_config_t slave_config = {};
+    slave_config.i2c_port = I2C_NUM_0;
+    slave_config.sda_io_num = (gpio_num_t)I2C_SDA_PIN;
+    slave_config.scl_io_num = (gpio_num_t)I2C_SCL_PIN;
+    slave_config.clk_source = I2C_CLK_SRC_DEFAULT;
+    slave_config.send_buf_depth = 2 * I2C_MAX_RESPONSE_LEN;
+    slave_config.receive_buf_depth = 2 * (1 + I2C_MAX_WRITE_PAYLOAD); // Over-long writes reach the callback and are dropped there
+    slave_config.slave_addr = I2C_SLAVE_ADDR;
+    slave_config.addr_bit_len = I2C_ADDR_BIT_LEN_7;
+
+    esp_err_t ret = i2c_new_slave_device(&slave_config, &slave_handle);
+    if (ret != ESP_OK) {
+        Serial.printf("E (%s): Failed to start the I2C slave driver: %s\n", TAG, esp_err_to_name(ret));
+        return false;
+    }
+
+    i2c_slave_event_callbacks_t callbacks = {};
+    callbacks.on_request = on_request;
+    callbacks.on_receive = on_receive;
+    ret = i2c_slave_register_event_callbacks(slave_handle, &callbacks, NULL);
+    if (ret != ESP_OK) {
+        Serial.printf("E (%s): Failed to register the I2C slave callbacks: %s\n", TAG, esp_err_to_name(ret));
+        return false;
+    }
+
+    stage_result(); // Zeroed record without RESULT_FLAG_VALID until the first result
+
+    // Above the ADC task (priority 4): a stretched master waits on this task only
+    if (xTaskCreatePinnedToCore(i2cSlaveTask, "I2C Slave Task", I2C_SLAVE_TASK_STACK_BYTES, NULL, 5, &i2cSlaveTaskHandle, 0) != pdPASS) {
+        Serial.printf("E (%s): Failed to create the I2C slave task\n", TAG);
+        return false;
+    }
+    Serial.printf("I (%s): I2C slave (IDF driver) started with address 0x%02X (SDA=%d, SCL=%d), responses pre-staged\n",
+                  TAG, I2C_SLAVE_ADDR, I2C_SDA_PIN, I2C_SCL_PIN);
+    return true;
+}
+
+void i2c_slave_idf_result_ready() {
+    if (slave_queue == NULL || result_ready_queued) {
+        return;
+    }
+    result_ready_queued = true;
+    SlaveMessage msg;
+    msg.event = SlaveEvent::RESULT_READY;
+    msg.len = 0;
+    if (xQueueSend(slave_queue, &msg, 0) != pdTRUE) {
+        result_ready_queued = false; // The idle poll stages it instead
+    }
+}
+
+uint16_t i2c_slave_idf_isr_dropped() {
+    return isr_dropped;
+}
+
+#endif // I2C_IDF_SLAVE_BACKEND
@@ -0,0 +1,38 @@
+#ifndef I2C_SLAVE_IDF_H
+#define I2C_SLAVE_IDF_H
+
+#include "globals.h"
+
+// --- ESP-IDF I2C Slave Backend (I2C_IDF_SLAVE_BACKEND) ---
+// Replaces the Wire callbacks with the IDF i2c_slave driver (version 2). The response to
+// the next read is written into the slave TX FIFO before the master asks for it, so a
+// read is clocked out by the hardware without waiting on any code:
+//   - the ADC task pre-encodes every result (i2c_stage_result) and wakes the service
+//     task, which stages it while the bus is idle and the register pointer is REG_RESULT;
+//   - a register write is handed over by the receive callback, which only copies the
+//     bytes into a queue and, unless the master selected the already staged result,
+//     empties the TX FIFO so the following read stretches until the service task has
+//     encoded the selected record (tens of us, not the Wire task round trip);
+//   - a read that finds the FIFO empty is counted (stretched reads, I2C stats record) and
+//     served as soon as the service task has staged the response.
+// The service task runs above the ADC task's priority; record encoding is the only work
+// it does. Records longer than the 32-byte FIFO also pass through the driver's send ring
+// and are never restaged while partly read.
+
+/**
+ * @brief Starts the slave driver on I2C_SDA_PIN / I2C_SCL_PIN and its service task
+ * (setup(), from init_i2c_slave()). @return false if the driver refused the configuration.
+ */
+bool init_i2c_slave_idf();
+
+/**
+ * @brief A new pre-encoded result is available (ADC task, from i2c_stage_result()).
+ */
+void i2c_slave_idf_result_ready();
+
+/**
+ * @brief Master writes the receive callback could not queue (ISR-written, wraps).
+ */
+uint16_t i2c_slave_idf_isr_dropped();
+
+#endif // I2C_SLAVE_IDF_H
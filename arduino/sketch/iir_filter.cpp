@@ -0,0 +1,101 @@
+#include "iir_filter.h"
+#include <cmath>    // For sin, cos, exp
+#include <string.h> // For memset
+
+static int32_t to_fixed(double value, int shift) {
+    return (int32_t)lround(value * (double)(1u << shift));
+}
+
+uint8_t iir_unsupported_sections(const IirChainSpec &spec, uint8_t sections, uint32_t sample_freq_hz) {
+    uint8_t unsupported = 0;
+    float nyquist_hz = sample_freq_hz / 2.0f;
+    if ((sections & IIR_SECTION_DC_BLOCK) && !(spec.dc_cutoff_hz > 0.0f && spec.dc_cutoff_hz < nyquist_hz)) {
+        unsupported |= IIR_SECTION_DC_BLOCK;
+    }
+    for (int i = 0; i < 7; ++i) { // Mask bits 1..7
+        uint8_t bit = iir_section_biquad(i);
+        if (!(sections & bit)) {
+            continue;
+        }
+        if (i >= (int)spec.biquad_count || i >= IIR_MAX_BIQUADS) {
+            unsupported |= bit;
+            continue;
+        }
+        const BiquadSpec &b = spec.biquads[i];
+        if (!(b.freq_hz > 0.0f && b.freq_hz < nyquist_hz && b.q > 0.0f)) {
+            unsupported |= bit;
+        }
+    }
+    return unsupported;
+}
+
+// RBJ audio-EQ cookbook biquads, normalized by a0
+static void design_biquad(Biquad *s, const BiquadSpec &spec, uint32_t sample_freq_hz) {
+    double w0 = 2.0 * M_PI * spec.freq_hz / sample_freq_hz;
+    double c = cos(w0);
+    double alpha = sin(w0) / (2.0 * spec.q);
+    double b0, b1, b2;
+    switch (spec.type) {
+        case BiquadType::LOWPASS:  b0 = (1.0 - c) / 2.0; b1 = 1.0 - c;    b2 = b0;     break;
+        case BiquadType::HIGHPASS: b0 = (1.0 + c) / 2.0; b1 = -(1.0 + c); b2 = b0;     break;
+        case BiquadType::BANDPASS: b0 = alpha;           b1 = 0.0;        b2 = -alpha; break; // 0 dB peak
+        default:                   b0 = 1.0;             b1 = -2.0 * c;   b2 = 1.0;    break; // NOTCH
+    }
+    double a0 = 1.0 + alpha;
+    double a1 = -2.0 * c / a0;
+    double a2 = (1.0 - alpha) / a0;
+    b0 /= a0;
+    b1 /= a0;
+    b2 /= a0;
+    memset(s, 0, sizeof(*s));
+    s->b0 = to_fixed(b0, IIR_COEFF_SHIFT);
+    s->b1 = to_fixed(b1, IIR_COEFF_SHIFT);
+    s->b2 = to_fixed(b2, IIR_COEFF_SHIFT);
+    s->a1 = to_fixed(a1, IIR_COEFF_SHIFT);
+    s->a2 = to_fixed(a2, IIR_COEFF_SHIFT);
+    s->dc_gain = to_fixed((b0 + b1 + b2) / (1.0 + a1 + a2), IIR_COEFF_SHIFT);
+}
+
+bool iir_design(IirChain *chain, const IirChainSpec &spec, uint8_t sections, uint32_t sample_freq_hz) {
+    memset(chain, 0, sizeof(*chain));
+    if (iir_unsupported_sections(spec, sections, sample_freq_hz) != 0) {
+        return false;
+    }
+    chain->sections = sections;
+    if (sections & IIR_SECTION_DC_BLOCK) {
+        chain->dc_block = true;
+        chain->dc_pole = to_fixed(exp(-2.0 * M_PI * spec.dc_cutoff_hz / sample_freq_hz), IIR_POLE_SHIFT);
+        chain->dc_bias = spec.dc_bias_mv << IIR_SIGNAL_SHIFT;
+    }
+    for (uint32_t i = 0; i < spec.biquad_count; ++i) {
+        if (sections & iir_section_biquad(i)) {
+            design_biquad(&chain->biquad[chain->biquad_count++], spec.biquads[i], sample_freq_hz);
+        }
+    }
+    return true;
+}
+
+void iir_reset(IirChain *chain) {
+    chain->primed = false;
+}
+
+void iir_prime(IirChain *chain, int32_t x) {
+    // Steady state for a constant input: the DC blocker outputs exactly its bias, and each
+    // biquad passes its input times its DC gain
+    chain->dc_x1 = x;
+    chain->dc_y1 = 0;
+    int32_t v = chain->dc_block ? chain->dc_bias : x;
+    for (uint32_t i = 0; i < chain->biquad_count; ++i) {
+        Biquad *s = &chain->biquad[i];
+        s->x1 = s->x2 = v;
+        v = iir_round_shift((int64_t)v * s->dc_gain, IIR_COEFF_SHIFT);
+        s->y1 = s->y2 = v;
+    }
+    chain->primed = true;
+}
+
+void iir_process_block(IirChain *chain, const uint16_t *in, uint32_t count, uint16_t *out) {
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = (uint16_t)iir_push(chain, in[i]);
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef IIR_FILTER_H
+#define IIR_FILTER_H
+
+#include <stdint.h>
+
+// --- Fixed-Point IIR Filter Chain ---
+// A first-order DC-blocking high-pass followed by up to IIR_MAX_BIQUADS biquad sections,
+// run on the primary channel's processed samples (after the CIC decimator) ahead of the
+// batch sums and the cycle detector, so RMS and frequency see the filtered signal without
+// a second pass. Sections are designed once per processing rate (float, RBJ cookbook
+// formulas); per sample everything is integer: signal and state in Q.12 mV, Q2.29
+// coefficients, 32x32 -> 64-bit products (a mul/mulh pair each on the C3) and one
+// rounding shift per section (direct form I, so the state never needs more headroom
+// than the signal). The DC blocker removes the signal mean, so its output is re-centred
+// on a fixed bias: with it active, the window mean/min/max describe the filtered signal
+// around that level instead of the sensor output.
+
+const int IIR_MAX_BIQUADS = 4;
+const int IIR_SIGNAL_SHIFT = 12; // Q.12 mV samples and state
+const int IIR_COEFF_SHIFT = 29;  // Q2.29 biquad coefficients (|c| < 4)
+const int IIR_POLE_SHIFT = 30;   // Q1.30 DC blocker pole
+const uint32_t IIR_OUTPUT_MAX_MV = 8191; // Output clamp: overshoot stays below 2^13 (squares fit the kernel's 32-bit sums)
+
+// Section mask: bit 0 the DC blocker, bit 1 + i biquad i of the chain spec
+const uint8_t IIR_SECTION_DC_BLOCK = 1 << 0;
+constexpr uint8_t iir_section_biquad(int index) { return (uint8_t)(1 << (1 + index)); }
+
+enum class BiquadType : uint8_t { LOWPASS, HIGHPASS, BANDPASS, NOTCH };
+
+struct BiquadSpec {
+    BiquadType type;
+    float freq_hz; // Cutoff (low/high-pass) or centre frequency (band-pass, notch)
+    float q;       // Quality factor (0.7071 = Butterworth for a single section)
+};
+
+struct IirChainSpec {
+    float dc_cutoff_hz;      // DC blocker -3 dB corner
+    int32_t dc_bias_mv;      // Level the DC blocker output is re-centred on
+    const BiquadSpec *biquads;
+    uint32_t biquad_count;   // At most IIR_MAX_BIQUADS
+};
+
+struct Biquad {
+    int32_t b0, b1, b2, a1, a2; // Q2.29, normalized by a0: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2
+    int32_t dc_gain;            // Q2.29 steady-state gain, primes the state after a reset
+    int32_t x1, x2, y1, y2;     // Q.12 mV
+};
+
+struct IirChain {
+    uint8_t sections;        // Active IIR_SECTION_* bits (0 = pass-through)
+    bool dc_block;
+    bool primed;             // State matches the signal (false after a reset: primed by the next sample)
+    int32_t dc_pole;         // Q1.30
+    int32_t dc_bias;         // Q.12 mV
+    int32_t dc_x1, dc_y1;    // Q.12 mV
+    uint32_t biquad_count;   // Active biquads, in chain order
+    Biquad biquad[IIR_MAX_BIQUADS];
+};
+
+/**
+ * @brief Sections of `sections` that `spec` cannot realize at `sample_freq_hz` (bits past
+ * its biquads, frequencies at or above Nyquist or not positive, Q not positive).
+ * @return 0 if every selected section can be designed.
+ */
+uint8_t iir_unsupported_sections(const IirChainSpec &spec, uint8_t sections, uint32_t sample_freq_hz);
+
+/**
+ * @brief Designs the selected sections for `sample_freq_hz` processed samples per second
+ * and clears the state. Leaves a pass-through chain if any section is unsupported.
+ * @return true if every selected section was designed.
+ */
+bool iir_design(IirChain *chain, const IirChainSpec &spec, uint8_t sections, uint32_t sample_freq_hz);
+
+/**
+ * @brief Drops the filter history after a gap in the input stream; the next sample
+ * primes every section at its steady state, so there is no start-up transient.
+ */
+void iir_reset(IirChain *chain);
+
+/**
+ * @brief Sets every section to the steady state for input `x` (Q.12 mV). Used by iir_push().
+ */
+void iir_prime(IirChain *chain, int32_t x);
+
+static inline int32_t iir_round_shift(int64_t acc, int shift) {
+    return (int32_t)((acc + ((int64_t)1 << (shift - 1))) >> shift);
+}
+
+/**
+ * @brief Filters one processed sample (mV).
+ * @return The filtered sample (mV), clamped to 0..IIR_OUTPUT_MAX_MV.
+ */
+static inline uint32_t iir_push(IirChain *chain, uint32_t mv) {
+    if (chain->sections == 0) {
+        return mv;
+    }
+    int32_t x = (int32_t)mv << IIR_SIGNAL_SHIFT;
+    if (!chain->primed) {
+        iir_prime(chain, x);
+    }
+    if (chain->dc_block) {
+        // y = x - x1 + a * y1 (pole just inside the unit circle, zero at DC)
+        int32_t y = x - chain->dc_x1 + iir_round_shift((int64_t)chain->dc_pole * chain->dc_y1, IIR_POLE_SHIFT);
+        chain->dc_x1 = x;
+        chain->dc_y1 = y;
+        x = y + chain->dc_bias;
+    }
+    for (uint32_t i = 0; i < chain->biquad_count; ++i) {
+        Biquad *s = &chain->biquad[i];
+        int64_t acc = (int64_t)s->b0 * x + (int64_t)s->b1 * s->x1 + (int64_t)s->b2 * s->x2
+                    - (int64_t)s->a1 * s->y1 - (int64_t)s->a2 * s->y2;
+        int32_t y = iir_round_shift(acc, IIR_COEFF_SHIFT);
+        s->x2 = s->x1;
+        s->x1 = x;
+        s->y2 = s->y1;
+        s->y1 = y;
+        x = y;
+    }
+    int32_t out = iir_round_shift(x, IIR_SIGNAL_SHIFT);
+    if (out < 0) {
+        return 0;
+    }
+    return ((uint32_t)out > IIR_OUTPUT_MAX_MV) ? IIR_OUTPUT_MAX_MV : (uint32_t)out;
+}
+
+/**
+ * @brief Filters a block of samples (used by the benchmarks).
+ */
+void iir_process_block(IirChain *chain, const uint16_t *in, uint32_t count, uint16_t *out);
+
+#endif // IIR_FILTER_H
@@ -1,5 +1,6 @@
 #include "led_handler.h"
 #include "globals.h"
+#include "logger.h"
 // #include <esp_log.h> // Using Serial.printf instead
 
 static const char *TAG = "LEDHandler";
@@ -13,7 +14,7 @@ TaskHandle_t ledNormalFlashTaskHandle = NULL;
 // --- Blocking LED Flash ---
 // Used for immediate feedback (e.g., after calibration step)
 void flash_led_blocking(int pin, int count, int on_ms, int off_ms) {
-    Serial.printf("I (%s): Flashing LED %d times (On: %dms, Off: %dms)\n", TAG, count, on_ms, off_ms);
+    LOG_I(TAG, "Flashing LED %d times (On: %dms, Off: %dms)", count, on_ms, off_ms);
     pinMode(pin, OUTPUT); // Ensure pin is output
     for (int i = 0; i < count; ++i) {
         digitalWrite(pin, HIGH);
@@ -34,8 +35,7 @@ void flash_led_blocking(int pin, int count, int on_ms, int off_ms) {
 
 // --- Normal LED Flash Task ---
 void ledNormalFlashTask(void *pvParameters) {
-    Serial.println("DEBUG: >>> Entering ledNormalFlashTask function <<<"); // <-- Added log
-    Serial.printf("I (%s): LED Normal Flash Task started.\n", TAG);
+    LOG_I(TAG, "LED Normal Flash Task started.");
     TickType_t lastWakeTime = xTaskGetTickCount();
     // Simple heartbeat blink: 1s ON, 1s OFF
     const TickType_t blinkInterval = pdMS_TO_TICKS(5000);
@@ -43,7 +43,6 @@ void ledNormalFlashTask(void *pvParameters) {
 
     while (1) {
         // Simple heartbeat blink
-        Serial.printf("LED BLINK");
         ledIsOn = !ledIsOn;
         digitalWrite(LED_PIN, ledIsOn ? HIGH : LOW);
         vTaskDelayUntil(&lastWakeTime, blinkInterval);
@@ -0,0 +1,93 @@
+#include "logger.h"
+
+static const char *TAG = "Logger";
+
+// --- Define Global Variables (declared extern in globals.h) ---
+TaskHandle_t logTaskHandle = NULL;
+
+// --- Record Ring ---
+// Bounded multi-producer / single-consumer queue (Vyukov): every slot carries a
+// sequence number. A slot at position pos is free for a producer when its sequence
+// equals pos, and holds a complete record once the producer has set it to pos + 1.
+// Producers claim positions with a compare-and-swap on enqueue_pos, so a task that is
+// preempted (or interrupted) mid-write never blocks the others; the consumer only
+// sees slots whose copy has finished. The ESP32-C3 has no atomic instructions, so the
+// toolchain implements the CAS by masking interrupts for a few cycles: short and
+// bounded, and safe from ISRs.
+struct LogRing {
+    LogRecord slots[LOG_RING_SIZE];
+    uint32_t enqueue_pos;
+    uint32_t dequeue_pos; // logTask only
+    uint32_t dropped;
+
+    LogRing() : slots(), enqueue_pos(0), dequeue_pos(0), dropped(0) {
+        for (uint32_t i = 0; i < (uint32_t)LOG_RING_SIZE; ++i) {
+            slots[i].sequence = i;
+        }
+    }
+};
+
+static LogRing ring;
+static_assert(LOG_MAX_ARGS == 8, "log_print_next() passes exactly eight arguments");
+
+bool log_push(uint8_t level, const char *tag, const char *fmt, const uintptr_t *args, int arg_count) {
+    uint32_t pos = __atomic_load_n(&ring.enqueue_pos, __ATOMIC_RELAXED);
+    LogRecord *slot;
+    while (1) {
+        slot = &ring.slots[pos & (LOG_RING_SIZE - 1)];
+        int32_t dif = (int32_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ring.enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break; // Slot claimed
+            }
+            // pos was reloaded by the failed CAS
+        } else if (dif < 0) {
+            __atomic_fetch_add(&ring.dropped, 1, __ATOMIC_RELAXED); // Full: the consumer is a lap behind
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring.enqueue_pos, __ATOMIC_RELAXED); // Another producer claimed it
+        }
+    }
+    slot->level = level;
+    slot->tag = tag;
+    slot->fmt = fmt;
+    for (int i = 0; i < LOG_MAX_ARGS; ++i) {
+        slot->args[i] = (i < arg_count) ? args[i] : 0;
+    }
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE); // Publish to the consumer
+    return true;
+}
+
+// Pops and prints one record. Returns false when the ring is empty (or the oldest
+// slot is still being written).
+static bool log_print_next() {
+    LogRecord *slot = &ring.slots[ring.dequeue_pos & (LOG_RING_SIZE - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != ring.dequeue_pos + 1) {
+        return false;
+    }
+    LogRecord record = *slot;
+    // Hand the slot back for the producer one lap ahead
+    __atomic_store_n(&slot->sequence, ring.dequeue_pos + LOG_RING_SIZE, __ATOMIC_RELEASE);
+    ring.dequeue_pos++;
+
+    static const char LEVEL_CHARS[] = "?EWID";
+    char message[160];
+    const uintptr_t *a = record.args;
+    snprintf(message, sizeof(message), record.fmt, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    Serial.printf("%c (%s): %s\n", LEVEL_CHARS[record.level <= LOG_LEVEL_DEBUG ? record.level : 0], record.tag, message);
+    return true;
+}
+
+void logTask(void *pvParameters) {
+    uint32_t reported_drops = 0;
+    while (1) {
+        while (log_print_next()) {
+        }
+        uint32_t drops = __atomic_load_n(&ring.dropped, __ATOMIC_RELAXED);
+        if (drops != reported_drops) {
+            Serial.printf("W (%s): %lu log records dropped (ring full)\n", TAG, drops - reported_drops);
+            reported_drops = drops;
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
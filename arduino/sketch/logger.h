@@ -0,0 +1,93 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "globals.h"
+#include <type_traits>
+
+// --- Deferred Logging ---
+// LOG_E/W/I/D(tag, fmt, ...) store a fixed-size binary record (level, tag and format
+// pointers, up to LOG_MAX_ARGS raw arguments) in a bounded ring and return without
+// touching the UART. logTask formats and prints the records later, in the same
+// "L (tag): message" layout as before (the logger adds the newline). Safe from tasks
+// and ISRs; never blocks. When the ring is full the record is dropped and counted,
+// and the drop count is printed once the ring drains.
+//
+// Restrictions (checked at compile time where possible):
+//  - tag, fmt and any %s argument must point at storage that outlives the record
+//    (string literals, static TAG strings, esp_err_to_name()).
+//  - Arguments are stored as 32-bit words: no floats/doubles, no 64-bit integers.
+//    Use fixed point in the format, e.g. "%lu.%02lu".
+
+struct LogRecord {
+    uint32_t sequence;            // Ring slot sequence (see logger.cpp)
+    const char *tag;
+    const char *fmt;
+    uintptr_t args[LOG_MAX_ARGS];
+    uint8_t level;
+};
+
+/**
+ * @brief Queues one record. Use the LOG_* macros instead of calling this directly.
+ * @return false if the ring was full and the record was dropped.
+ */
+bool log_push(uint8_t level, const char *tag, const char *fmt, const uintptr_t *args, int arg_count);
+
+template <typename T>
+static inline uintptr_t log_arg(T value) {
+    static_assert(!std::is_floating_point<T>::value, "Floats are not supported in deferred logs; use fixed point");
+    static_assert(std::is_pointer<T>::value || sizeof(T) <= 4, "64-bit log arguments are not supported");
+    return (uintptr_t)value;
+}
+
+// Never called: lets the compiler check the format against the arguments as for printf.
+static inline void log_format_check(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void log_format_check(const char *fmt, ...) {}
+
+template <typename... Args>
+static inline void log_write(uint8_t level, const char *tag, const char *fmt, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments (LOG_MAX_ARGS)");
+    const uintptr_t packed[sizeof...(Args) + 1] = {log_arg(args)..., 0};
+    log_push(level, tag, fmt, packed, (int)sizeof...(Args));
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(tag, fmt, ...) do { \
+        if (false) log_format_check(fmt, ##__VA_ARGS__); \
+        log_write(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define LOG_E(tag, fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(tag, fmt, ...) do { \
+        if (false) log_format_check(fmt, ##__VA_ARGS__); \
+        log_write(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define LOG_W(tag, fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(tag, fmt, ...) do { \
+        if (false) log_format_check(fmt, ##__VA_ARGS__); \
+        log_write(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define LOG_I(tag, fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(tag, fmt, ...) do { \
+        if (false) log_format_check(fmt, ##__VA_ARGS__); \
+        log_write(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__); \
+    } while (0)
+#else
+#define LOG_D(tag, fmt, ...) do {} while (0)
+#endif
+
+/**
+ * @brief Task that drains the log ring to Serial every LOG_DRAIN_INTERVAL_MS.
+ * Runs at the lowest application priority so printing only uses idle time.
+ * @param pvParameters Task parameters (unused).
+ */
+void logTask(void *pvParameters);
+
+#endif // LOGGER_H
@@ -0,0 +1,143 @@
+#include "overcurrent.h"
+#include "logger.h"
+#include <cmath> // For sqrt (trip log only)
+
+static const char *TAG = "Overcurrent";
+
+// --- Comparator State (owned by the ADC task) ---
+static OvercurrentThresholds thresholds = { OVERCURRENT_PEAK_TRIP_MV, OVERCURRENT_RMS_TRIP_MV, OVERCURRENT_HYSTERESIS_MV };
+static bool active = false;
+static bool latched = false;
+static uint8_t latched_source = 0;
+static uint16_t trips = 0;
+
+// --- Master Commands (set by the I2C handler, consumed by the ADC task) ---
+static ResultSnapshot<OvercurrentThresholds> pending_thresholds;
+static volatile uint32_t thresholds_requested = 0; // Writes accepted since boot
+static volatile bool clear_requested = false;
+
+static ResultSnapshot<OvercurrentStatus> overcurrent_status;
+
+static void publish_status() {
+    OvercurrentStatus status = {};
+    status.active = active;
+    status.latched = latched;
+    status.source = latched_source;
+    status.trips = trips;
+    status.thresholds = thresholds;
+    overcurrent_status.publish(status);
+}
+
+static void set_pin(bool assert_alert) {
+    digitalWrite(OVERCURRENT_ALERT_PIN, assert_alert ? LOW : HIGH); // HIGH releases the open-drain output
+}
+
+void init_overcurrent() {
+    if (!OVERCURRENT_ALERT_ENABLED) {
+        return;
+    }
+    digitalWrite(OVERCURRENT_ALERT_PIN, HIGH); // Released before the output is enabled: no glitch at boot
+    pinMode(OVERCURRENT_ALERT_PIN, OUTPUT_OPEN_DRAIN);
+    publish_status();
+    Serial.printf("I (%s): Alert on GPIO %d (open drain, active low): peak %u mV, RMS %u mV, hysteresis %u mV\n", TAG,
+                  OVERCURRENT_ALERT_PIN, thresholds.peak_trip_mv, thresholds.rms_trip_mv, thresholds.hysteresis_mv);
+}
+
+// Sum of (x - zero)^2 over the frame's raw samples from their plain sums (exact, < 2^45 for a frame)
+static uint64_t deviation_sum_sq(const FrameStats *frame) {
+    int64_t zero = CURRENT_SENSOR_ZERO_MV;
+    int64_t sum_sq = (int64_t)frame->raw_sum_sq_mv - 2 * zero * (int64_t)frame->raw_sum_mv + (int64_t)frame->raw_samples * zero * zero;
+    return sum_sq > 0 ? (uint64_t)sum_sq : 0;
+}
+
+// Level checks against an enabled (non-zero) limit; the RMS compares n * limit^2 with the deviation sum of squares
+static bool peak_at_least(uint32_t peak_mv, uint32_t limit_mv) {
+    return limit_mv > 0 && peak_mv >= limit_mv;
+}
+
+static bool rms_at_least(uint64_t dev_sum_sq, uint32_t samples, uint32_t limit_mv) {
+    return limit_mv > 0 && dev_sum_sq >= (uint64_t)samples * limit_mv * limit_mv;
+}
+
+void overcurrent_after_frame(const FrameStats *frame) {
+    if (!OVERCURRENT_ALERT_ENABLED) {
+        return;
+    }
+    static uint32_t thresholds_taken = 0;
+    bool changed = false;
+    if (thresholds_requested != thresholds_taken) {
+        OvercurrentThresholds next;
+        if (pending_thresholds.read(&next)) {
+            thresholds_taken = thresholds_requested;
+            thresholds = next;
+            changed = true;
+            LOG_I(TAG, "Thresholds set by master: peak %u mV, RMS %u mV, hysteresis %u mV",
+                  thresholds.peak_trip_mv, thresholds.rms_trip_mv, thresholds.hysteresis_mv);
+        }
+    }
+    if (clear_requested) {
+        clear_requested = false;
+        latched = active; // Still over the release level: the latch sets again straight away
+        latched_source = active ? latched_source : 0;
+        changed = true;
+    }
+    if (frame->raw_samples > 0) {
+        int32_t zero = CURRENT_SENSOR_ZERO_MV;
+        uint32_t peak_mv = (uint32_t)max((int32_t)frame->raw_max_mv - zero, zero - (int32_t)frame->raw_min_mv);
+        uint64_t dev_sum_sq = deviation_sum_sq(frame);
+        if (!active) {
+            uint8_t source = (peak_at_least(peak_mv, thresholds.peak_trip_mv) ? OVERCURRENT_SOURCE_PEAK : 0) |
+                             (rms_at_least(dev_sum_sq, frame->raw_samples, thresholds.rms_trip_mv) ? OVERCURRENT_SOURCE_RMS : 0);
+            if (source != 0) {
+                set_pin(true); // First: everything else can wait
+                active = true;
+                latched = true;
+                latched_source |= source;
+                trips++;
+                changed = true;
+                uint32_t rms_mv = (uint32_t)lround(sqrt((double)dev_sum_sq / frame->raw_samples));
+                LOG_W(TAG, "Trip #%u (source 0x%02X): frame peak %lu mV, RMS %lu mV about zero",
+                      trips, source, peak_mv, rms_mv);
+            }
+        } else {
+            // Release only once every enabled level is below its trip level by the hysteresis
+            // (enabled trip levels are always above it, see overcurrent_request_thresholds)
+            bool peak_high = thresholds.peak_trip_mv > 0 && peak_mv >= (uint32_t)(thresholds.peak_trip_mv - thresholds.hysteresis_mv);
+            bool rms_high = thresholds.rms_trip_mv > 0 &&
+                            rms_at_least(dev_sum_sq, frame->raw_samples, thresholds.rms_trip_mv - thresholds.hysteresis_mv);
+            if (!peak_high && !rms_high) {
+                set_pin(false);
+                active = false;
+                changed = true;
+                LOG_I(TAG, "Released: frame peak %lu mV", peak_mv);
+            }
+        }
+    }
+    if (changed) {
+        publish_status();
+    }
+}
+
+bool overcurrent_latched() {
+    return latched;
+}
+
+bool overcurrent_request_thresholds(const OvercurrentThresholds &next) {
+    if ((next.peak_trip_mv > 0 && next.peak_trip_mv <= next.hysteresis_mv) ||
+        (next.rms_trip_mv > 0 && next.rms_trip_mv <= next.hysteresis_mv)) {
+        return false;
+    }
+    pending_thresholds.publish(next);
+    thresholds_requested = thresholds_requested + 1;
+    return true;
+}
+
+void overcurrent_request_clear() {
+    clear_requested = true;
+}
+
+OvercurrentStatus overcurrent_get_status() {
+    OvercurrentStatus status = {};
+    overcurrent_status.read(&status); // Not initialized (alert disabled) -> all zero
+    return status;
+}
@@ -0,0 +1,64 @@
+#ifndef OVERCURRENT_H
+#define OVERCURRENT_H
+
+#include "globals.h"
+#include "adc_kernel.h"
+
+// --- Overcurrent Fast Path ---
+// Checked once per DMA frame in the ADC task, right after the kernel has accumulated it:
+// the frame's largest deviation from CURRENT_SENSOR_ZERO_MV (peak) and its RMS about the
+// zero (mean square of the deviation, compared squared: no sqrt) against trip levels.
+// A trip pulls OVERCURRENT_ALERT_PIN low (open drain, active low) and latches the alert
+// flag, which stays set in the alert record and in every result's RESULT_FLAG_OVERCURRENT
+// until the master clears it. The pin is released once both figures are
+// OVERCURRENT_HYSTERESIS_MV below their trip levels. Latency is one frame (ADC_READ_LEN
+// conversions, about 20 ms at the default rate), independent of the output rate and of
+// the legacy discard loop, whose dropped frames are scanned too. The check sees every
+// primary sample before the decimator and the filter (FrameStats raw_*), so a steady DC
+// overcurrent trips it whatever filter sections the master has enabled.
+
+const uint8_t OVERCURRENT_SOURCE_PEAK = 1 << 0; // Frame peak deviation reached the peak trip level
+const uint8_t OVERCURRENT_SOURCE_RMS = 1 << 1;  // Frame RMS about the zero reached the RMS trip level
+
+struct OvercurrentThresholds {
+    uint16_t peak_trip_mv;  // Largest |sample - zero| in a frame (mV), 0 disables
+    uint16_t rms_trip_mv;   // RMS of (sample - zero) over a frame (mV), 0 disables
+    uint16_t hysteresis_mv; // Release once both are this far below their trip levels
+};
+
+// State published for the I2C handler (ADC task writes, any context reads)
+struct OvercurrentStatus {
+    bool active;             // Alert pin asserted
+    bool latched;            // Tripped since the master last cleared the latch
+    uint8_t source;          // OVERCURRENT_SOURCE_* of every trip since the latch was cleared
+    uint16_t trips;          // Trips since boot (wraps)
+    OvercurrentThresholds thresholds;
+};
+
+/**
+ * @brief Releases the alert pin (open drain, setup()) and publishes the build's thresholds.
+ */
+void init_overcurrent();
+
+/**
+ * @brief Per-frame comparison, pin and latch update (ADC task).
+ */
+void overcurrent_after_frame(const FrameStats *frame);
+
+/**
+ * @brief Alert latch as of the latest frame, for the result flags (ADC task).
+ */
+bool overcurrent_latched();
+
+// --- Master commands (called from the I2C receive handler, applied at the next frame) ---
+
+/**
+ * @brief Checks and queues new thresholds. @return false (nothing changes) if an enabled
+ * trip level is not above the hysteresis.
+ */
+bool overcurrent_request_thresholds(const OvercurrentThresholds &thresholds);
+void overcurrent_request_clear(); // Clear the latch (the pin follows the signal regardless)
+
+OvercurrentStatus overcurrent_get_status();
+
+#endif // OVERCURRENT_H
@@ -0,0 +1,69 @@
+#ifndef PIPELINE_CONFIG_H
+#define PIPELINE_CONFIG_H
+
+#include <stdint.h>
+#include <esp_adc/adc_continuous.h> // SOC_ADC_* limits
+#include "result_snapshot.h"
+
+// --- Processing Pipeline Configuration ---
+// The shape of one build's acquisition pipeline as a type: every parameter is a template
+// argument and every derived figure (rates, frame and block sizes, timeouts) a constant
+// member, so nothing is worked out at run time and impossible combinations fail to
+// compile. The kernel (adc_kernel.cpp) is instantiated for the build's configuration
+// (AdcPipeline in globals.h): stages a build leaves out are discarded at compile time
+// (`if constexpr`), not tested per sample, and no code or state of theirs is referenced.
+
+const uint32_t PIPELINE_STAGE_SCOPE = 1 << 0;    // Raw primary codes into the scope ring (scope.h)
+const uint32_t PIPELINE_STAGE_SPECTRUM = 1 << 1; // Processed samples into the spectrum capture (spectrum.h)
+const uint32_t PIPELINE_STAGE_STREAM = 1 << 2;   // Raw frames to the S3 over SPI (stream.h)
+const uint32_t PIPELINE_STAGE_FILTER = 1 << 3;   // IIR chain on the primary samples before accumulation (iir_filter.h)
+
+template <int Channels,       // ADC_PATTERN entries (slot 0 is the primary current channel)
+          int SampleFreqHz,   // Conversions per second per channel
+          int Decimation,     // CIC decimation of the primary channel (1 = off)
+          int ReadLen,        // Conversion results per DMA frame
+          int DmaBufBytes,    // Driver conversion pool
+          int OutputRateHz,   // Results per second (gapless blocks)
+          int WindowLengthMs, // Signal span of each result
+          int BatterySlot,    // Pattern slot of the battery divider, -1 without one
+          uint32_t Stages>    // PIPELINE_STAGE_* bits
+struct PipelineConfig {
+    static constexpr int CHANNELS = Channels;
+    static constexpr int SAMPLE_FREQ_HZ = SampleFreqHz;
+    static constexpr int CONVERSION_FREQ_HZ = SampleFreqHz * Channels; // Hardware rate over all entries
+    static constexpr int DECIMATION = Decimation;
+    static constexpr int PROCESSING_FREQ_HZ = SampleFreqHz / Decimation; // Rate seen by RMS / zero-crossing code
+    static constexpr int READ_LEN = ReadLen;
+    static constexpr int FRAME_BYTES = ReadLen * SOC_ADC_DIGI_RESULT_BYTES;
+    static constexpr uint32_t FRAME_PERIOD_US = (uint32_t)((uint64_t)ReadLen * 1000000 / CONVERSION_FREQ_HZ);
+    static constexpr uint32_t FRAME_PERIOD_MS = (uint32_t)ReadLen * 1000 / CONVERSION_FREQ_HZ; // Rounded down
+    static constexpr uint32_t BLOCK_SAMPLES = SampleFreqHz / OutputRateHz; // Conversions per channel per output period
+    static constexpr uint32_t BLOCK_SLOTS = BLOCK_SAMPLES * Channels;     // Same, in conversion slots
+    static constexpr int WINDOW_BLOCKS = WindowLengthMs * OutputRateHz / 1000;
+    static constexpr int BATTERY_SLOT = BatterySlot;
+
+    static constexpr bool HAS_AUX_CHANNELS = Channels > 1;
+    static constexpr bool HAS_DECIMATOR = Decimation > 1;
+    static constexpr bool HAS_POWER = BatterySlot > 0;
+    static constexpr bool HAS_SCOPE = (Stages & PIPELINE_STAGE_SCOPE) != 0;
+    static constexpr bool HAS_SPECTRUM = (Stages & PIPELINE_STAGE_SPECTRUM) != 0;
+    static constexpr bool HAS_STREAM = (Stages & PIPELINE_STAGE_STREAM) != 0;
+    static constexpr bool HAS_FILTER = (Stages & PIPELINE_STAGE_FILTER) != 0;
+
+    static_assert(Channels >= 1 && Channels <= RESULT_MAX_CHANNELS, "Pattern must have 1..RESULT_MAX_CHANNELS entries");
+    static_assert(BatterySlot == -1 || (BatterySlot > 0 && BatterySlot < Channels), "Battery channel must be a secondary pattern slot");
+    static_assert(CONVERSION_FREQ_HZ >= SOC_ADC_SAMPLE_FREQ_THRES_LOW && CONVERSION_FREQ_HZ <= SOC_ADC_SAMPLE_FREQ_THRES_HIGH,
+                  "Sample rate x pattern length outside the ADC hardware range");
+    static_assert(Decimation >= 1 && (Decimation & (Decimation - 1)) == 0, "Decimation factor must be a power of two");
+    static_assert(SampleFreqHz % Decimation == 0, "Decimated rate must be a whole number of samples per second");
+    static_assert(ReadLen >= Channels, "A DMA frame must hold at least one full pattern");
+    static_assert(FRAME_BYTES % 4 == 0, "DMA frames must be a whole number of words");
+    static_assert(DmaBufBytes % FRAME_BYTES == 0 && DmaBufBytes >= 2 * FRAME_BYTES,
+                  "Conversion pool must hold a whole number of frames, at least two (one read while the next fills)");
+    static_assert(FRAME_PERIOD_MS >= 1, "Frame period below the millisecond timeout resolution");
+    static_assert(BLOCK_SAMPLES > 0 && SampleFreqHz % OutputRateHz == 0, "Output period must be a whole number of samples");
+    static_assert((WindowLengthMs * OutputRateHz) % 1000 == 0 && WINDOW_BLOCKS >= 1,
+                  "Window length must be a positive multiple of the output period");
+};
+
+#endif // PIPELINE_CONFIG_H
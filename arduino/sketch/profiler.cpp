@@ -0,0 +1,87 @@
+#include "profiler.h"
+#include "logger.h"
+#include <string.h> // For memcpy/memset
+
+static const char *TAG = "Profiler";
+
+const char *const PROFILE_PROBE_NAMES[PROBE_COUNT] = {
+    "adc_read", "read_gap", "kernel", "window", "discard_read", "i2c_request", "spectrum",
+};
+
+#if PROFILER_ENABLED
+ProfileStats profile_stats[PROBE_COUNT];
+#endif
+
+void profiler_snapshot(ProfileProbe probe, ProfileStats *out) {
+#if PROFILER_ENABLED
+    memcpy(out, &profile_stats[probe], sizeof(*out));
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+// Value at the given rank (1-based) of a log2 histogram, interpolated linearly inside
+// the bucket that holds it.
+static uint32_t histogram_rank_value(const uint32_t *buckets, uint32_t rank) {
+    uint32_t before = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; ++b) {
+        if (buckets[b] > 0 && before + buckets[b] >= rank) {
+            uint64_t lo = (b == 0) ? 0 : (1ull << b);
+            uint64_t hi = 1ull << (b + 1);
+            uint64_t value = lo + (hi - lo) * (rank - before) / buckets[b];
+            return (uint32_t)(value > 0 ? value - 1 : 0);
+        }
+        before += buckets[b];
+    }
+    return 0;
+}
+
+void profiler_summarize(const ProfileStats *now, const ProfileStats *since, ProfileSummary *out) {
+    uint32_t buckets[PROFILE_BUCKETS];
+    uint32_t count = now->count;
+    uint64_t sum = now->sum_cycles;
+    int top = -1;
+    for (int b = 0; b < PROFILE_BUCKETS; ++b) {
+        buckets[b] = now->buckets[b] - (since ? since->buckets[b] : 0);
+        if (buckets[b] > 0) {
+            top = b;
+        }
+    }
+    if (since) {
+        count -= since->count;
+        sum -= since->sum_cycles;
+    }
+    memset(out, 0, sizeof(*out));
+    out->count = count;
+    if (count == 0) {
+        return;
+    }
+    uint32_t max_cycles = now->max_cycles;
+    if (since && top >= 0 && top < PROFILE_BUCKETS - 1) {
+        max_cycles = min(max_cycles, (uint32_t)((2ull << top) - 1)); // Interval max is only known to its bucket
+    }
+    uint32_t mhz = max((uint32_t)getCpuFrequencyMhz(), (uint32_t)1);
+    out->avg_us = (uint32_t)(sum / count / mhz);
+    out->p50_us = min(histogram_rank_value(buckets, (count + 1) / 2), max_cycles) / mhz;
+    out->p90_us = min(histogram_rank_value(buckets, (uint32_t)(((uint64_t)count * 90 + 99) / 100)), max_cycles) / mhz;
+    out->p99_us = min(histogram_rank_value(buckets, (uint32_t)(((uint64_t)count * 99 + 99) / 100)), max_cycles) / mhz;
+    out->max_us = max_cycles / mhz;
+}
+
+void profiler_log_interval(ProfileSummary *out) {
+    static ProfileStats previous[PROBE_COUNT]; // Snapshot at the previous call
+    for (int p = 0; p < PROBE_COUNT; ++p) {
+        ProfileStats now;
+        ProfileSummary summary;
+        profiler_snapshot((ProfileProbe)p, &now);
+        profiler_summarize(&now, &previous[p], &summary);
+        previous[p] = now;
+        if (out) {
+            out[p] = summary;
+        }
+        if (summary.count > 0) {
+            LOG_I(TAG, "%s: n=%lu avg=%lu p50=%lu p90=%lu p99=%lu max=%lu us", PROFILE_PROBE_NAMES[p],
+                  summary.count, summary.avg_us, summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us);
+        }
+    }
+}
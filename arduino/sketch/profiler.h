@@ -0,0 +1,104 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "globals.h"
+#include <esp_cpu.h>
+
+// --- Hot-Path Profiler ---
+// Each probe keeps a histogram of durations in CPU cycles with log2 buckets
+// (bucket b counts durations in [2^b, 2^(b+1)), bucket 0 also holds 0), plus the
+// count, sum and maximum. Recording is a handful of instructions and never blocks.
+// Statistics only ever grow; readers take a snapshot and subtract an earlier one for
+// interval figures, so nothing has to be reset under a writer.
+//
+// Every probe must be recorded from one context only (single writer). Snapshots taken
+// from another context may be off by the record in flight; fine for diagnostics.
+// With PROFILER_ENABLED 0 the probes compile to nothing.
+
+enum ProfileProbe : uint8_t {
+    PROBE_ADC_READ = 0,  // adc_continuous_read() in the main loop (ADC task)
+    PROBE_READ_GAP,      // End of one read to start of the next: processing + waiting (ADC task)
+    PROBE_KERNEL,        // Fused decode/accumulate kernel, per DMA frame (ADC task)
+    PROBE_WINDOW,        // Block completion: window result, publish, reports (ADC task)
+    PROBE_DISCARD_READ,  // adc_continuous_read() in the legacy discard loop (ADC task)
+    PROBE_I2C_REQUEST,   // i2cRequestEvent(): encode + Wire.write (I2C callback)
+    PROBE_SPECTRUM,      // One spectrum analysis (spectrum task)
+    PROBE_COUNT
+};
+
+const int PROFILE_BUCKETS = 32;
+
+struct ProfileStats {
+    uint32_t buckets[PROFILE_BUCKETS];
+    uint32_t count;
+    uint32_t max_cycles; // Since boot
+    uint64_t sum_cycles;
+};
+
+// Summary in microseconds. Percentiles are interpolated within their log2 bucket.
+struct ProfileSummary {
+    uint32_t count;
+    uint32_t avg_us;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us; // Exact since boot; upper edge of the highest hit bucket for intervals
+};
+
+extern const char *const PROFILE_PROBE_NAMES[PROBE_COUNT];
+
+#if PROFILER_ENABLED
+extern ProfileStats profile_stats[PROBE_COUNT];
+
+static inline uint32_t profiler_cycles() {
+    return esp_cpu_get_cycle_count();
+}
+
+static inline void profiler_record(ProfileProbe probe, uint32_t cycles) {
+    ProfileStats *s = &profile_stats[probe];
+    s->buckets[cycles ? 31 - __builtin_clz(cycles) : 0]++;
+    s->count++;
+    s->sum_cycles += cycles;
+    if (cycles > s->max_cycles) {
+        s->max_cycles = cycles;
+    }
+}
+
+// Records the lifetime of the enclosing scope on one probe.
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileProbe probe) : probe_(probe), start_(profiler_cycles()) {}
+    ~ProfileScope() { profiler_record(probe_, profiler_cycles() - start_); }
+
+private:
+    ProfileProbe probe_;
+    uint32_t start_;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(probe) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(probe)
+#else
+static inline uint32_t profiler_cycles() { return 0; }
+static inline void profiler_record(ProfileProbe, uint32_t) {}
+#define PROFILE_SCOPE(probe) do {} while (0)
+#endif
+
+/**
+ * @brief Copies a probe's statistics (all zero when the profiler is compiled out).
+ */
+void profiler_snapshot(ProfileProbe probe, ProfileStats *out);
+
+/**
+ * @brief Summarises `now - since` (or everything since boot when `since` is NULL).
+ */
+void profiler_summarize(const ProfileStats *now, const ProfileStats *since, ProfileSummary *out);
+
+/**
+ * @brief Logs one line per probe with activity since the previous call and optionally
+ * returns the interval summaries (PROBE_COUNT entries). Call from one task only.
+ * @param out Interval summaries, or NULL.
+ */
+void profiler_log_interval(ProfileSummary *out);
+
+#endif // PROFILER_H
@@ -0,0 +1,133 @@
+#ifndef RESULT_SNAPSHOT_H
+#define RESULT_SNAPSHOT_H
+
+#include <stdint.h>
+
+const int RESULT_MAX_CHANNELS = 4; // Pattern entries reported per window
+
+// --- Measurement Result Record ---
+// One complete, self-consistent set of results for a finished window. Published
+// as a unit by the ADC task so readers never mix fields from different windows.
+struct MeasurementResult {
+    uint32_t sequence;      // Window sequence number (increments once per published window)
+    uint32_t timestamp_ms;  // millis() when the window closed
+    // First and last conversion of the window (esp_timer us; the master's clock with RESULT_FLAG_TIME_SYNCED, time_sync.h)
+    int64_t window_start_us;
+    int64_t window_end_us;
+    uint32_t sample_count;  // Samples that contributed to this window
+    uint16_t rms_mv;        // Window AC RMS (mV)
+    uint16_t freq_dhz;      // Average cycle frequency (0.1 Hz units), 0 if no cycles detected
+    uint16_t peak_mv;       // Largest deviation from the window mean (mV)
+    uint16_t mean_mv;       // Window mean (mV)
+    uint16_t min_mv;        // Smallest sample in the window (mV)
+    uint16_t max_mv;        // Largest sample in the window (mV)
+    uint16_t crest_x100;    // Crest factor peak/RMS (x100), 0 if RMS is 0
+    // Per pattern entry (index = ADC_PATTERN slot; slot 0 repeats the primary values above)
+    uint8_t channel_count;
+    uint16_t channel_rms_mv[RESULT_MAX_CHANNELS];
+    uint16_t channel_mean_mv[RESULT_MAX_CHANNELS];
+    uint16_t battery_mv;    // Battery voltage after divider scaling (mV), 0 without a voltage channel
+    int32_t power_mw;       // Mean of V*I over the window (mW), 0 without a voltage channel
+    uint16_t flags;         // RESULT_FLAG_* bits
+    uint16_t config_version; // Runtime configuration the window was measured with (acq_config.h, 0 = build defaults)
+    uint16_t dropped_frames;  // DMA frames lost to pool overflows within the window (RESULT_FLAG_SAMPLES_DROPPED)
+    uint32_t dropped_samples; // Conversion slots in those frames (all channels)
+};
+
+const uint16_t RESULT_FLAG_VALID = 1 << 0;        // Window completed without read errors/timeouts
+const uint16_t RESULT_FLAG_READ_TIMEOUT = 1 << 1; // At least one DMA frame wait timed out in this window
+const uint16_t RESULT_FLAG_READ_ERROR = 1 << 2;   // adc_continuous_read returned an error in this window
+const uint16_t RESULT_FLAG_NO_SAMPLES = 1 << 3;   // A frame (or the window) had no samples from the primary channel
+const uint16_t RESULT_FLAG_NO_CYCLES = 1 << 4;    // No valid cycles detected (frequency reported as 0)
+const uint16_t RESULT_FLAG_LEGACY_MODE = 1 << 5;  // MeasurementMode::LEGACY_DISCARD (window is not gapless)
+// Warm-up state, a 2-bit field in the flags (0 = steady, so masters that ignore it see ordinary results)
+const uint16_t RESULT_STATE_MASK = 3 << 6;
+const uint16_t RESULT_STATE_STEADY = 0 << 6;      // The window spans the configured length
+const uint16_t RESULT_STATE_WARMING_UP = 1 << 6;  // Only the short warm-up block (WARMUP_BLOCK_MS) since boot or a reconfiguration
+const uint16_t RESULT_STATE_PROVISIONAL = 2 << 6; // Full blocks, but fewer than a window: still filling
+const uint16_t RESULT_FLAG_OVERCURRENT = 1 << 8;  // Overcurrent alert latched (overcurrent.h), until the master clears it
+const uint16_t RESULT_FLAG_SAMPLES_DROPPED = 1 << 9; // The DMA pool overflowed: frames were lost in this window (processing fell behind)
+const uint16_t RESULT_FLAG_ADC_RESTARTED = 1 << 10;  // The ADC task restarted a stalled driver in this window
+const uint16_t RESULT_FLAG_TIME_SYNCED = 1 << 11;    // Window times are on the master's clock (a time sync was written since boot)
+
+// --- Spectrum Result Record ---
+// Harmonic analysis of one spectrum capture (SPECTRUM_MODE_ENABLED only).
+const int SPECTRUM_RESULT_HARMONICS = 8; // Harmonics 2..9
+struct SpectrumResult {
+    uint32_t sequence;       // Capture sequence number (increments once per analysed capture)
+    uint32_t timestamp_ms;   // millis() when the analysis finished
+    uint16_t fundamental_dhz; // Fundamental frequency (0.1 Hz units), 0 if none found
+    uint16_t fundamental_mv; // Fundamental RMS (mV)
+    uint16_t thd_dpct;       // Total harmonic distortion over the reported harmonics (0.1 % units)
+    uint16_t bin_cdhz;       // FFT bin width (0.01 Hz units)
+    uint16_t harmonic_mv[SPECTRUM_RESULT_HARMONICS]; // RMS of harmonics 2..9 (mV), 0 above Nyquist
+    uint16_t skipped;        // Captures dropped since the previous result (task was still busy)
+    uint16_t flags;          // SPECTRUM_FLAG_* bits
+};
+
+const uint16_t SPECTRUM_FLAG_VALID = 1 << 0;         // A fundamental was found in the expected range
+const uint16_t SPECTRUM_FLAG_FFT_ERROR = 1 << 1;     // esp-dsp returned an error
+const uint16_t SPECTRUM_FLAG_CAPTURE_SKIPPED = 1 << 2; // Captures were skipped since the previous result
+
+/**
+ * @brief Double-buffered, sequence-counted snapshot for a single writer and any
+ * number of readers (tasks or ISRs), without locks or critical sections.
+ *
+ * Each slot carries its own sequence, odd while the writer is filling it. A publish
+ * fills the slot that readers are *not* directed to, then stores the incremented
+ * version that selects it. A reader copies the selected slot and accepts the copy
+ * only if the slot's sequence was even and unchanged across it; a writer that got
+ * round to the same slot during the copy (two publishes) makes it odd or moves it
+ * on, and the reader retries with the new version. Because the slot a reader is
+ * directed to is complete, an ISR that preempts the writer mid-publish still gets
+ * the previous record instead of spinning. Only aligned 32-bit loads/stores are
+ * used, which are atomic on the C3 without the RISC-V A extension.
+ */
+template <typename T>
+class ResultSnapshot {
+public:
+    // Writer side (ADC task only)
+    void publish(const T &value) {
+        uint32_t next = version_ + 1; // Only the writer modifies version_ and the slot sequences
+        Slot &slot = slots_[next & 1];
+        uint32_t seq = slot.seq + 1; // Odd: being written
+        __atomic_store_n(&slot.seq, seq, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE); // The odd sequence is visible before any of the data
+        slot.value = value;
+        __atomic_store_n(&slot.seq, seq + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&version_, next, __ATOMIC_RELEASE);
+    }
+
+    // Reader side (any context). Returns false only if no record was ever published
+    // or the writer kept overtaking the reader (not possible at window cadence).
+    bool read(T *out) const {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            uint32_t version = __atomic_load_n(&version_, __ATOMIC_ACQUIRE);
+            if (version == 0) {
+                return false;
+            }
+            const Slot &slot = slots_[version & 1];
+            uint32_t before = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+            if (before & 1) {
+                continue; // Being rewritten (the writer published twice since the version load)
+            }
+            *out = slot.value;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            uint32_t after = __atomic_load_n(&slot.seq, __ATOMIC_RELAXED);
+            if (after == before) {
+                return true; // The slot was not touched during the copy
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        T value = {};
+        uint32_t seq = 0; // Writes started on this slot x2; odd while one is in progress
+    };
+    Slot slots_[2];
+    uint32_t version_ = 0; // Number of publishes; slot (version_ & 1) is the latest
+};
+
+#endif // RESULT_SNAPSHOT_H
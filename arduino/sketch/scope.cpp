@@ -0,0 +1,167 @@
+#include "scope.h"
+#include "logger.h"
+#include "wave_codec.h"
+
+static const char *TAG = "Scope";
+
+// --- Capture Storage ---
+static uint16_t scope_ring[SCOPE_SAMPLES];
+static uint16_t scope_sink; // Write target while frozen (mask 0)
+ScopeWriter scope_writer = { scope_ring, SCOPE_SAMPLES - 1, 0 };
+static uint8_t scope_packed[SCOPE_SAMPLES / SCOPE_PACKED_BLOCK_SAMPLES * wave_max_block_bytes(SCOPE_PACKED_BLOCK_SAMPLES)];
+static uint32_t scope_packed_bytes = 0;
+
+// --- Trigger State (owned by the ADC task) ---
+static ScopeState state = ScopeState::ARMED;
+static uint32_t history_start_pos = 0; // First position of contiguous pre-trigger history
+static uint32_t trigger_pos = 0;
+static uint8_t trigger_source = 0;
+static uint32_t trigger_time_ms = 0;
+static int32_t prev_frame_mean_mv = -1; // -1: no previous frame (slope trigger disabled)
+static uint32_t capture_sequence = 0;
+static uint32_t sample_freq_hz = ADC_SAMPLE_FREQ_HZ; // Primary channel rate, for the packed block timestamps
+
+// --- Master Commands (set by the I2C handler, consumed by the ADC task) ---
+static volatile bool arm_requested = false;
+static volatile bool trigger_requested = false;
+
+// Status published for the I2C handler (same lock-free snapshot as the results)
+static ResultSnapshot<ScopeStatus> scope_status;
+
+static void publish_status(uint32_t start_pos) {
+    ScopeStatus status = {};
+    status.state = state;
+    status.trigger_source = trigger_source;
+    status.trigger_index = (state == ScopeState::FROZEN) ? (uint16_t)(trigger_pos - start_pos) : 0;
+    status.sequence = capture_sequence;
+    status.trigger_time_ms = trigger_time_ms;
+    status.start_pos = start_pos;
+    status.packed_bytes = (state == ScopeState::FROZEN) ? (uint16_t)scope_packed_bytes : 0;
+    scope_status.publish(status);
+}
+
+// Packs the frozen ring, oldest sample first; about 40 cycles per sample, once per capture
+static void pack_capture(uint32_t start_pos) {
+    uint16_t block[SCOPE_PACKED_BLOCK_SAMPLES];
+    scope_packed_bytes = 0;
+    for (int first = 0; first < SCOPE_SAMPLES; first += SCOPE_PACKED_BLOCK_SAMPLES) {
+        for (int i = 0; i < SCOPE_PACKED_BLOCK_SAMPLES; ++i) {
+            block[i] = scope_ring[(start_pos + first + i) & (SCOPE_SAMPLES - 1)];
+        }
+        // Time of the block's first sample, relative to the trigger
+        int32_t offset_samples = first - (int32_t)(trigger_pos - start_pos);
+        uint32_t timestamp_ms = trigger_time_ms + offset_samples * 1000 / (int32_t)sample_freq_hz;
+        scope_packed_bytes += wave_encode_block(block, SCOPE_PACKED_BLOCK_SAMPLES, ADC_PATTERN[0].channel, timestamp_ms,
+                                                &scope_packed[scope_packed_bytes]);
+    }
+}
+
+static void rearm() {
+    scope_writer.base = scope_ring;
+    scope_writer.mask = SCOPE_SAMPLES - 1;
+    state = ScopeState::ARMED;
+    history_start_pos = scope_writer.pos;
+    trigger_source = 0;
+    prev_frame_mean_mv = -1;
+    publish_status(0);
+}
+
+void scope_after_frame(uint32_t frame_start_pos, uint32_t frame_min_mv, uint32_t frame_max_mv, uint32_t frame_mean_mv, uint32_t frame_samples) {
+    if (arm_requested) {
+        arm_requested = false;
+        rearm();
+        LOG_I(TAG, "Re-armed by master.");
+    }
+    if (state == ScopeState::ARMED) {
+        uint8_t source = 0;
+        if (trigger_requested) {
+            source |= SCOPE_TRIGGER_SOURCE_COMMAND;
+        }
+        if (frame_samples > 0) {
+            if (SCOPE_TRIGGER_LEVEL_MV > 0 &&
+                ((int32_t)frame_max_mv - CURRENT_SENSOR_ZERO_MV >= SCOPE_TRIGGER_LEVEL_MV ||
+                 CURRENT_SENSOR_ZERO_MV - (int32_t)frame_min_mv >= SCOPE_TRIGGER_LEVEL_MV)) {
+                source |= SCOPE_TRIGGER_SOURCE_LEVEL;
+            }
+            if (SCOPE_TRIGGER_SLOPE_MV > 0 && prev_frame_mean_mv >= 0 &&
+                abs((int32_t)frame_mean_mv - prev_frame_mean_mv) >= SCOPE_TRIGGER_SLOPE_MV) {
+                source |= SCOPE_TRIGGER_SOURCE_SLOPE;
+            }
+            prev_frame_mean_mv = (int32_t)frame_mean_mv;
+        }
+        // Trigger only once the pre-trigger history is complete (a forced trigger waits for it)
+        if (source != 0 && frame_start_pos - history_start_pos >= (uint32_t)SCOPE_PRE_TRIGGER_SAMPLES) {
+            trigger_requested = false;
+            state = ScopeState::TRIGGERED;
+            trigger_pos = frame_start_pos; // Frame granularity: the trigger frame starts here
+            trigger_source = source;
+            trigger_time_ms = millis();
+            publish_status(0);
+        }
+    } else if (state == ScopeState::TRIGGERED) {
+        if (scope_writer.pos - trigger_pos >= (uint32_t)SCOPE_POST_TRIGGER_SAMPLES) {
+            // Freeze: the capture is the last SCOPE_SAMPLES samples before this point
+            uint32_t start_pos = scope_writer.pos - SCOPE_SAMPLES;
+            scope_writer.base = &scope_sink;
+            scope_writer.mask = 0;
+            state = ScopeState::FROZEN;
+            capture_sequence++;
+            pack_capture(start_pos);
+            publish_status(start_pos);
+            LOG_I(TAG, "Capture #%lu frozen (source 0x%02X, trigger at sample %lu of %d, packed to %lu bytes).",
+                  capture_sequence, trigger_source, trigger_pos - start_pos, SCOPE_SAMPLES, scope_packed_bytes);
+        }
+    }
+}
+
+void scope_reset_history() {
+    if (state == ScopeState::ARMED) {
+        history_start_pos = scope_writer.pos;
+        prev_frame_mean_mv = -1;
+    } else if (state == ScopeState::TRIGGERED) {
+        trigger_source |= SCOPE_CAPTURE_GAP;
+    }
+}
+
+void scope_set_sample_rate(uint32_t hz) {
+    sample_freq_hz = hz;
+    scope_reset_history();
+}
+
+void scope_request_arm() {
+    arm_requested = true;
+}
+
+void scope_request_trigger() {
+    trigger_requested = true;
+}
+
+ScopeStatus scope_get_status() {
+    ScopeStatus status = {};
+    scope_status.read(&status); // Nothing published yet -> ARMED, no capture
+    return status;
+}
+
+bool scope_read_samples(uint32_t index, uint16_t *out, uint32_t count) {
+    ScopeStatus status = scope_get_status();
+    if (status.state != ScopeState::FROZEN || index + count > (uint32_t)SCOPE_SAMPLES) {
+        return false;
+    }
+    // The frozen ring is not written until the master re-arms it
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = scope_ring[(status.start_pos + index + i) & (SCOPE_SAMPLES - 1)];
+    }
+    return true;
+}
+
+bool scope_read_packed(uint32_t offset, uint8_t *out, uint32_t count) {
+    ScopeStatus status = scope_get_status();
+    if (status.state != ScopeState::FROZEN) {
+        return false;
+    }
+    // Written before the FROZEN status was published, untouched until the master re-arms
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = (offset + i < status.packed_bytes) ? scope_packed[offset + i] : 0;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include "globals.h"
+
+// --- Triggered Waveform Capture ("Scope Mode") ---
+// A ring of raw 12-bit codes from the primary channel, written with one store per
+// sample from the fused kernel. Trigger conditions are evaluated once per DMA frame
+// from the frame's min/max/mean, never per sample. Once SCOPE_POST_TRIGGER_SAMPLES
+// have been written after a trigger the ring is frozen by pointing the writer at a
+// one-entry sink, so the master can read the capture while acquisition continues.
+// At the freeze the capture is also packed (delta + Rice, wave_codec.h) into blocks of
+// SCOPE_PACKED_BLOCK_SAMPLES, which the master can read instead of the plain codes.
+
+enum class ScopeState : uint8_t { ARMED = 0, TRIGGERED = 1, FROZEN = 2 };
+
+const uint8_t SCOPE_TRIGGER_SOURCE_LEVEL = 1 << 0;   // |frame extreme - zero| >= SCOPE_TRIGGER_LEVEL_MV
+const uint8_t SCOPE_TRIGGER_SOURCE_SLOPE = 1 << 1;   // |frame mean - previous frame mean| >= SCOPE_TRIGGER_SLOPE_MV
+const uint8_t SCOPE_TRIGGER_SOURCE_COMMAND = 1 << 2; // Forced by the master (I2C)
+const uint8_t SCOPE_CAPTURE_GAP = 1 << 7;            // A read gap occurred after the trigger (post-trigger data not contiguous)
+
+struct ScopeWriter {
+    uint16_t *base;  // scope ring while armed/triggered, the sink once frozen
+    uint32_t mask;   // SCOPE_SAMPLES - 1, or 0 for the sink
+    uint32_t pos;    // Free-running write position (samples written since boot)
+};
+
+extern ScopeWriter scope_writer;
+
+/**
+ * @brief Stores one raw code. The only per-sample cost of scope mode.
+ */
+static inline void scope_push(ScopeWriter *w, uint16_t raw) {
+    w->base[w->pos++ & w->mask] = raw;
+}
+
+/**
+ * @brief Per-frame trigger evaluation and state machine (ADC task).
+ * @param frame_start_pos scope_writer.pos before the frame was accumulated.
+ * @param frame_min_mv / frame_max_mv / frame_mean_mv Primary channel stats of the frame.
+ */
+void scope_after_frame(uint32_t frame_start_pos, uint32_t frame_min_mv, uint32_t frame_max_mv, uint32_t frame_mean_mv, uint32_t frame_samples);
+
+/**
+ * @brief Restarts the pre-trigger history after a gap in the sample stream
+ * (no effect on a frozen capture).
+ */
+void scope_reset_history();
+
+/**
+ * @brief Sets the primary channel rate after a runtime reconfiguration (ADC task). Handled
+ * as a gap: the pre-trigger history restarts, a capture in progress is marked SCOPE_CAPTURE_GAP.
+ */
+void scope_set_sample_rate(uint32_t hz);
+
+// --- Master commands (called from the I2C receive handler) ---
+void scope_request_arm();     // Discard the current capture and re-arm
+void scope_request_trigger(); // Force a trigger at the next frame
+
+/**
+ * @brief Capture metadata for the I2C status block.
+ */
+struct ScopeStatus {
+    ScopeState state;
+    uint8_t trigger_source;     // SCOPE_TRIGGER_SOURCE_* of the current capture
+    uint16_t trigger_index;     // Index of the trigger sample within the capture
+    uint32_t sequence;          // Number of captures frozen since boot
+    uint32_t trigger_time_ms;   // millis() at the trigger
+    uint32_t start_pos;         // Writer position of capture sample 0 (valid when frozen)
+    uint16_t packed_bytes;      // Size of the packed capture (0 unless frozen)
+};
+ScopeStatus scope_get_status();
+
+/**
+ * @brief Copies `count` samples of the frozen capture starting at `index`
+ * (oldest sample first). Returns false unless the capture is frozen.
+ */
+bool scope_read_samples(uint32_t index, uint16_t *out, uint32_t count);
+
+/**
+ * @brief Copies `count` bytes of the packed frozen capture starting at byte `offset`
+ * (zero past its end). Returns false unless the capture is frozen.
+ */
+bool scope_read_packed(uint32_t offset, uint8_t *out, uint32_t count);
+
+#endif // SCOPE_H
@@ -5,40 +5,54 @@
 #include "adc_handler.h"
 #include "i2c_handler.h"
 #include "led_handler.h" // Kept as optional status indicator
+#include "spectrum.h"
+#include "logger.h"
+#include "benchmark.h"
+#include "stream.h"
+#include "arena.h"
+#include "overcurrent.h"
 
 // --- Global Variables are now defined in their respective handler .cpp files ---
 
 void setup() {
+  boot_milestone(BOOT_SETUP);
+  // Fast path to the first measurement after a (re)start: pins, I2C and the ADC come up
+  // first with no settling delays and the ADC task starts right behind them, so the master
+  // gets a provisional result within tens of ms. What can wait (FFT tables, LED,
+  // diagnostics) follows once conversions are running.
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER_BYTES); // Before begin(): banners never wait on the UART
   Serial.begin(115200);
-  delay(100); // Allow serial to initialize
   Serial.println("--- ESP32-C3 ADC/I2C Processor Starting ---"); // Use Serial for early debug
-  delay(100);
 
   // 1. Set ADC Pin Mode (Important before ADC init)
 
-  pinMode(ADC_PIN_NUM, INPUT);
-  Serial.printf("DEBUG: Set GPIO %d to INPUT mode.\n", ADC_PIN_NUM);
-  delay(100);
+  for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+      pinMode(ADC_PATTERN[slot].gpio, INPUT);
+      Serial.printf("DEBUG: Set GPIO %d to INPUT mode.\n", ADC_PATTERN[slot].gpio);
+  }
 
 
   // 2. Initialize Hardware Pins (LED only)
-  Serial.println("DEBUG: Initializing GPIO pins...");
-  delay(100);
   pinMode(LED_PIN, OUTPUT);
 //   pinMode(3, OUTPUT);
   digitalWrite(LED_PIN, LOW); // Start with LED off
-  Serial.println("DEBUG: GPIO Pins Initialized.");
-  delay(100);
+  init_overcurrent(); // Alert line released before the master can see it
 
-  // 3. Initialize I2C Slave
-  Serial.println("DEBUG: Initializing I2C Slave...");
-  delay(100);
+  // 3. Initialize I2C Slave (reads return a zeroed record without RESULT_FLAG_VALID until the first result)
   init_i2c_slave(); // Function defined in i2c_handler.cpp
-  Serial.println("DEBUG: I2C Slave Initialized.");
-  delay(100);
+  boot_milestone(BOOT_I2C_READY);
+
+  // 4. Optional self-benchmark, before the ADC runs or any task competes for the CPU
+  // (FFT tables first, so the self-benchmark can time the spectrum analysis too)
+  bool spectrum_ready = false;
+  bool bench_requested = benchmark_boot_requested();
+  if (SELF_BENCHMARK_AT_BOOT || bench_requested) {
+      spectrum_ready = SPECTRUM_MODE_ENABLED && init_spectrum();
+      Serial.println("DEBUG: Running self-benchmark...");
+      run_self_benchmark(spectrum_ready, bench_requested);
+  }
 
-  Serial.println("DEBUG: Initializing ADC Continuous Mode...");
-  delay(100);
+  // 5. ADC and its task, straight away
   if (!init_adc()) { // Function defined in adc_handler.cpp
       Serial.println("ADC Initialization Failed!");
       // Handle error - perhaps blink LED rapidly?
@@ -47,31 +61,43 @@ void setup() {
           delay(100);
       }
   }
-  Serial.println("DEBUG: ADC Initialized and Started.");
-  delay(100);
-
-  Serial.println("DEBUG: Creating FreeRTOS Tasks...");
-  delay(100);
+  boot_milestone(BOOT_ADC_STARTED);
+  init_stream(); // Raw sample stream to the S3 (no-op with STREAM_ENABLED false)
 
+  // Frames converted since adc_continuous_start() wait in the DMA pool; the task drains them first
   xTaskCreatePinnedToCore(
       adcProcessingTask,      // Task function
       "ADC Processing Task",  // Name of the task
-      8192*2,                   // Stack size in words (Increased from 4096)
+      ADC_TASK_STACK_BYTES,   // Stack size in bytes (frame buffers live in buffer_arena)
       NULL,                   // Task input parameter
       4,                      // Priority of the task (Reduced from 5)
       &adcProcessingTaskHandle, // Task handle
       0                       // Core where the task should run (ESP32-C3 only has Core 0)
   );
   Serial.println("DEBUG: ADC Task Created.");
-  delay(100);
 
-Serial.println("DEBUG: Attempting to create LED Task..."); // <-- Added log
-delay(100); // <-- Added delay for stability
+  // 6. Everything else runs below the ADC task's priority from here on
+  // Lowest priority: deferred log records are printed only when nothing else needs the CPU
+  xTaskCreatePinnedToCore(logTask, "Log Task", LOG_TASK_STACK_BYTES, NULL, 1, &logTaskHandle, 0);
+  Serial.println("DEBUG: Log Task Created.");
+
+  if (SPECTRUM_MODE_ENABLED) {
+      if (!(SELF_BENCHMARK_AT_BOOT || bench_requested)) {
+          spectrum_ready = init_spectrum(); // Captures completed before the task exists are dropped
+      }
+      // Below the ADC task's priority: FFT work only runs in the ADC task's idle time
+      if (spectrum_ready) {
+          xTaskCreatePinnedToCore(spectrumTask, "Spectrum Task", SPECTRUM_TASK_STACK_BYTES, NULL, 1, &spectrumTaskHandle, 0);
+          Serial.println("DEBUG: Spectrum Task Created.");
+      } else {
+          Serial.println("Spectrum Initialization Failed! Continuing without spectrum mode.");
+      }
+  }
 
 BaseType_t ledTaskCreated = xTaskCreatePinnedToCore( // <-- Check return value
     ledNormalFlashTask,
     "LED Flash Task",
-    2048, // Increased stack size for LED task
+    LED_TASK_STACK_BYTES,
     NULL,
     2,     // Low priority
     &ledNormalFlashTaskHandle,
@@ -83,15 +109,14 @@ if (ledTaskCreated == pdPASS) { // <-- Check if creation succeeded
 } else {
   Serial.printf("DEBUG: LED Task Creation FAILED! Code: %d\n", ledTaskCreated); // <-- Print error code if failed
 }
-delay(100);
-  delay(100);
 
-  Serial.println("--- Setup Complete ---");
-  delay(100);
+  init_cpu_idle_monitor(); // Live CPU idle %, reported with the ADC task's timing report
+  init_memory_diagnostics(); // Stack headroom and heap, reported with the same report
+
+  Serial.println("--- Setup Complete ---"); // Boot milestones are logged with the first steady result
 
     // ledcAttach(3,31,12); //ledcAttach(uint8_tpin,uint32_tfreq,uint8_tresolution); for ESP core V3
   
-  delay(115); 
 // ledcWrite(3,4095/2);
 }
 
@@ -113,6 +138,8 @@ void loop() {
   //   }
   // }
 
+  benchmark_poll_commands(); // "bench" on Serial (or I2C BENCH_CMD_RUN) restarts into the self-benchmark
+
   vTaskDelay(pdMS_TO_TICKS(300));// Nothing critical here, yield time
 }
 
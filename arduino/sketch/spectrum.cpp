@@ -0,0 +1,197 @@
+#include "spectrum.h"
+#include "logger.h"
+#include "profiler.h"
+#include <esp_dsp.h> // esp-dsp (bundled with the ESP32 Arduino core)
+#include <cmath>     // For sqrt/cos
+
+static const char *TAG = "Spectrum";
+
+// --- Define Global Variables (declared extern in globals.h / spectrum.h) ---
+TaskHandle_t spectrumTaskHandle = NULL;
+ResultSnapshot<SpectrumResult> latest_spectrum;
+SpectrumCapture spectrum_capture;
+
+// --- Capture Hand-off ---
+// Buffer index the spectrum task is analysing, or -1 while it is idle. Set by the
+// ADC task, cleared by the spectrum task once it no longer reads the buffer.
+static int32_t busy_index = -1;
+static uint32_t skipped_captures = 0; // Written by the ADC task only
+
+// --- Analysis Buffers (spectrum task only) ---
+static int16_t hann_q15[SPECTRUM_FFT_SIZE];
+static int16_t fft_data[SPECTRUM_FFT_SIZE * 2]; // Interleaved re/im
+static uint32_t bin_power[SPECTRUM_FFT_SIZE / 2]; // |X[k]|^2
+
+void spectrum_capture_complete(SpectrumCapture *cap) {
+    cap->position = 0;
+    if (spectrumTaskHandle == NULL || __atomic_load_n(&busy_index, __ATOMIC_ACQUIRE) >= 0) {
+        skipped_captures++; // Task still busy: overwrite this buffer with the next capture
+        return;
+    }
+    __atomic_store_n(&busy_index, (int32_t)cap->fill_index, __ATOMIC_RELEASE);
+    cap->fill_index ^= 1;
+    xTaskNotifyGive(spectrumTaskHandle);
+}
+
+bool init_spectrum() {
+    esp_err_t ret = dsps_fft2r_init_sc16(NULL, SPECTRUM_FFT_SIZE);
+    if (ret != ESP_OK) {
+        Serial.printf("E (%s): Failed to initialize FFT tables: %s\n", TAG, esp_err_to_name(ret));
+        return false;
+    }
+    // Periodic Hann window in Q15 (computed once, float is fine here)
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; ++i) {
+        hann_q15[i] = (int16_t)lround(16383.5 * (1.0 - cos(2.0 * M_PI * i / SPECTRUM_FFT_SIZE)));
+    }
+    Serial.printf("I (%s): Spectrum mode: %d-point FFT at %d Hz (%.2f Hz bins, %.0f ms per capture)\n", TAG,
+                  SPECTRUM_FFT_SIZE, SPECTRUM_SAMPLE_FREQ_HZ, (float)SPECTRUM_SAMPLE_FREQ_HZ / SPECTRUM_FFT_SIZE,
+                  SPECTRUM_FFT_SIZE * 1000.0f / SPECTRUM_SAMPLE_FREQ_HZ);
+    return true;
+}
+
+// Power of a tone around bin k: a Hann main lobe spans bins k-1..k+1.
+static uint64_t lobe_power(uint32_t k) {
+    uint64_t p = bin_power[k];
+    if (k > 0) {
+        p += bin_power[k - 1];
+    }
+    if (k + 1 < SPECTRUM_FFT_SIZE / 2) {
+        p += bin_power[k + 1];
+    }
+    return p;
+}
+
+// Converts a lobe power to the tone's RMS in mV. A sine of amplitude A gives a
+// Hann-windowed, 1/N-scaled bin of A/4, and the main lobe holds 1.5x (ENBW) the
+// centre bin's power, so RMS = A/sqrt(2) = 4*sqrt(P/1.5)/sqrt(2).
+static float lobe_rms_mv(uint64_t power, int shift) {
+    return (float)(sqrt((double)power) * 2.3094 / (double)(1 << shift));
+}
+
+// --- Analysis of one capture (mean removal, window, FFT, harmonics) ---
+void spectrum_analyse(const int16_t *samples, SpectrumResult *result) {
+    const int N = SPECTRUM_FFT_SIZE;
+    int32_t sum = 0;
+    for (int i = 0; i < N; ++i) {
+        sum += samples[i];
+    }
+    int32_t mean = (sum + N / 2) / N;
+    int32_t peak = 0;
+    for (int i = 0; i < N; ++i) {
+        peak = max(peak, (int32_t)abs(samples[i] - mean));
+    }
+    // Scale the AC part up to use the int16 range (the sc16 FFT halves every stage)
+    int shift = 0;
+    while (shift < 7 && (peak << (shift + 1)) < 16384) {
+        shift++;
+    }
+    for (int i = 0; i < N; ++i) {
+        int32_t x = (samples[i] - mean) << shift;
+        fft_data[2 * i] = (int16_t)((x * hann_q15[i]) >> 15);
+        fft_data[2 * i + 1] = 0;
+    }
+    esp_err_t ret = dsps_fft2r_sc16(fft_data, N);
+    if (ret == ESP_OK) {
+        ret = dsps_bit_rev_sc16_ansi(fft_data, N);
+    }
+    if (ret != ESP_OK) {
+        result->flags |= SPECTRUM_FLAG_FFT_ERROR;
+        return;
+    }
+    for (int k = 0; k < N / 2; ++k) {
+        int32_t re = fft_data[2 * k];
+        int32_t im = fft_data[2 * k + 1];
+        bin_power[k] = (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+
+    // Fundamental: strongest bin in the expected frequency range (skipping DC leakage)
+    uint32_t k_min = max(2, MIN_EXPECTED_FREQ_HZ * N / SPECTRUM_SAMPLE_FREQ_HZ);
+    uint32_t k_max = min(N / 2 - 2, MAX_EXPECTED_FREQ_HZ * N / SPECTRUM_SAMPLE_FREQ_HZ + 1);
+    uint32_t k1 = k_min;
+    for (uint32_t k = k_min + 1; k <= k_max; ++k) {
+        if (bin_power[k] > bin_power[k1]) {
+            k1 = k;
+        }
+    }
+    uint64_t p1 = lobe_power(k1);
+    if (bin_power[k1] == 0) {
+        return; // Flat input: no fundamental
+    }
+    // Parabolic interpolation on bin magnitudes for the fractional peak position
+    float m_prev = sqrtf((float)bin_power[k1 - 1]);
+    float m_peak = sqrtf((float)bin_power[k1]);
+    float m_next = sqrtf((float)bin_power[k1 + 1]);
+    float denom = m_prev - 2.0f * m_peak + m_next;
+    float delta = (denom != 0.0f) ? 0.5f * (m_prev - m_next) / denom : 0.0f;
+    float f0_bins = (float)k1 + delta;
+    float bin_hz = (float)SPECTRUM_SAMPLE_FREQ_HZ / N;
+    result->fundamental_dhz = (uint16_t)lroundf(f0_bins * bin_hz * 10.0f);
+    result->fundamental_mv = (uint16_t)lroundf(lobe_rms_mv(p1, shift));
+    result->flags |= SPECTRUM_FLAG_VALID;
+
+    // Harmonics 2..9: strongest bin within +-1 of the expected position
+    uint64_t harmonic_power_sum = 0;
+    for (int h = 0; h < SPECTRUM_RESULT_HARMONICS; ++h) {
+        uint32_t centre = (uint32_t)lroundf(f0_bins * (h + 2));
+        if (centre + 2 >= (uint32_t)N / 2) {
+            break; // Above Nyquist: reported as 0
+        }
+        uint32_t k = centre;
+        if (bin_power[centre - 1] > bin_power[k]) {
+            k = centre - 1;
+        }
+        if (bin_power[centre + 1] > bin_power[k]) {
+            k = centre + 1;
+        }
+        uint64_t p = lobe_power(k);
+        harmonic_power_sum += p;
+        result->harmonic_mv[h] = (uint16_t)lroundf(lobe_rms_mv(p, shift));
+    }
+    double thd = sqrt((double)harmonic_power_sum / (double)p1);
+    result->thd_dpct = (uint16_t)min(lround(thd * 1000.0), 65535L);
+}
+
+void spectrumTask(void *pvParameters) {
+    LOG_I(TAG, "Spectrum Task started.");
+    uint32_t sequence = 0;
+    uint32_t reported_skips = 0;
+    unsigned long last_print_time = 0;
+
+    while (1) {
+        // Sleep until the ADC task hands over a complete capture
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int32_t index = __atomic_load_n(&busy_index, __ATOMIC_ACQUIRE);
+        if (index < 0) {
+            continue;
+        }
+        uint32_t start_us = micros();
+        SpectrumResult result = {};
+        {
+            PROFILE_SCOPE(PROBE_SPECTRUM);
+            spectrum_analyse(spectrum_capture.buffers[index], &result);
+        }
+        __atomic_store_n(&busy_index, -1, __ATOMIC_RELEASE); // Buffer may be refilled now
+        uint32_t analysis_us = micros() - start_us;
+
+        uint32_t skips = __atomic_load_n(&skipped_captures, __ATOMIC_RELAXED);
+        result.sequence = ++sequence;
+        result.timestamp_ms = millis();
+        result.bin_cdhz = (uint16_t)(SPECTRUM_SAMPLE_FREQ_HZ * 100 / SPECTRUM_FFT_SIZE);
+        result.skipped = (uint16_t)min(skips - reported_skips, (uint32_t)UINT16_MAX);
+        if (skips != reported_skips) {
+            result.flags |= SPECTRUM_FLAG_CAPTURE_SKIPPED;
+        }
+        reported_skips = skips;
+        latest_spectrum.publish(result);
+
+        unsigned long now = millis();
+        if (now - last_print_time >= TARGET_BATCH_INTERVAL_MS) {
+            last_print_time = now;
+            LOG_I(TAG, "Capture #%lu: F0=%u.%uHz %umV, THD=%u.%u%%",
+                  result.sequence, result.fundamental_dhz / 10, result.fundamental_dhz % 10, result.fundamental_mv,
+                  result.thd_dpct / 10, result.thd_dpct % 10);
+            LOG_I(TAG, "Capture #%lu: H2=%umV H3=%umV, %lu us, %u skipped",
+                  result.sequence, result.harmonic_mv[0], result.harmonic_mv[1], analysis_us, result.skipped);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include "globals.h"
+
+// --- Spectrum Capture (filled by the ADC task, one sample at a time) ---
+// Boxcar-decimates the processed mV stream and fills one of two capture buffers.
+// A full buffer is handed to the spectrum task; the ADC task keeps filling the
+// other one, so it never touches a buffer that is being analysed.
+struct SpectrumCapture {
+    uint32_t boxcar_sum;  // Sum of the current SPECTRUM_DECIMATION input samples
+    uint32_t boxcar_count;
+    uint32_t position;    // Next write index in buffers[fill_index]
+    uint32_t fill_index;  // Buffer the ADC task is filling
+    int16_t buffers[2][SPECTRUM_FFT_SIZE];
+};
+
+extern SpectrumCapture spectrum_capture;
+
+/**
+ * @brief Completes a capture: hands the full buffer to the spectrum task if it is
+ * idle, otherwise drops it. Never blocks (called from the ADC task).
+ */
+void spectrum_capture_complete(SpectrumCapture *cap);
+
+/**
+ * @brief Adds one processed sample (mV) to the spectrum capture.
+ */
+static inline void spectrum_capture_push(SpectrumCapture *cap, uint32_t mv) {
+    cap->boxcar_sum += mv;
+    if (++cap->boxcar_count < (uint32_t)SPECTRUM_DECIMATION) {
+        return;
+    }
+    cap->buffers[cap->fill_index][cap->position] = (int16_t)((cap->boxcar_sum + SPECTRUM_DECIMATION / 2) / SPECTRUM_DECIMATION);
+    cap->boxcar_sum = 0;
+    cap->boxcar_count = 0;
+    if (++cap->position == (uint32_t)SPECTRUM_FFT_SIZE) {
+        spectrum_capture_complete(cap);
+    }
+}
+
+/**
+ * @brief Restarts the current capture after a gap in the sample stream, so every
+ * analysed capture is contiguous.
+ */
+static inline void spectrum_capture_reset(SpectrumCapture *cap) {
+    cap->boxcar_sum = 0;
+    cap->boxcar_count = 0;
+    cap->position = 0;
+}
+
+/**
+ * @brief Initializes the esp-dsp FFT tables and the Hann window.
+ * @return true on success.
+ */
+bool init_spectrum();
+
+/**
+ * @brief Analyses one capture of SPECTRUM_FFT_SIZE samples (mV): fills the frequency,
+ * harmonic, THD and flag fields of `result`. Uses the spectrum task's work buffers, so
+ * call it from that task only (or before it is created, as the self-benchmark does).
+ */
+void spectrum_analyse(const int16_t *samples, SpectrumResult *result);
+
+/**
+ * @brief Low-priority task that analyses completed captures: removes the mean,
+ * applies a Q15 Hann window, runs a fixed-point radix-2 FFT (dsps_fft2r_sc16),
+ * locates the fundamental between MIN_EXPECTED_FREQ_HZ and MAX_EXPECTED_FREQ_HZ,
+ * measures harmonics 2..9 and THD, and publishes a `SpectrumResult` through
+ * `latest_spectrum`.
+ * @param pvParameters Task parameters (unused).
+ */
+void spectrumTask(void *pvParameters);
+
+#endif // SPECTRUM_H
@@ -0,0 +1,194 @@
+#include "stream.h"
+#include "logger.h"
+#include "adc_kernel.h"
+#include "wave_codec.h"
+#include "arena.h"
+#include <driver/spi_slave.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <string.h> // For memset
+
+static const char *TAG = "Stream";
+
+// --- Transaction Ring ---
+// Buffers (buffer_arena.stream_frames) are queued and completed in order, so a ring with
+// an in-flight count is enough: the ADC task is the only writer, completions are collected
+// before each push.
+static spi_slave_transaction_t transactions[STREAM_QUEUE_DEPTH];
+static uint32_t next_buffer = 0; // Next buffer to fill
+static uint32_t in_flight = 0;   // Queued (or being clocked out) transactions
+static bool stream_running = false;
+static bool gap_pending = true;  // The first frame never continues anything
+static uint32_t frame_sequence = 0;
+static uint32_t frames_sent = 0;
+static uint32_t frames_dropped = 0;
+
+// Packed mode: the frame's codes are split by pattern slot (buffer_arena.stream_slot_codes)
+static_assert(ADC_PATTERN_LEN * WAVE_HEADER_BYTES + (ADC_READ_LEN * 12 + 7) / 8 <= ADC_READ_LEN * 2,
+              "Packed payload must fit the plain frame buffer");
+
+// CRC-16/CCITT-FALSE, one table lookup per byte (built by init_stream)
+static uint16_t crc16_table[256];
+
+static inline uint16_t crc16_update(uint16_t crc, uint8_t b) {
+    return (uint16_t)((crc << 8) ^ crc16_table[(crc >> 8) ^ b]);
+}
+
+// --- Handshake (SPI driver ISR context) ---
+// High once a transaction is loaded into the peripheral, low again when the master
+// has clocked it out.
+static void IRAM_ATTR stream_post_setup(spi_slave_transaction_t *trans) {
+    gpio_set_level((gpio_num_t)STREAM_READY_PIN, 1);
+}
+
+static void IRAM_ATTR stream_post_trans(spi_slave_transaction_t *trans) {
+    gpio_set_level((gpio_num_t)STREAM_READY_PIN, 0);
+}
+
+bool init_stream() {
+    if (!STREAM_ENABLED) {
+        return false;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+        crc16_table[i] = crc;
+    }
+
+    gpio_config_t ready_cfg = {};
+    ready_cfg.pin_bit_mask = 1ULL << STREAM_READY_PIN;
+    ready_cfg.mode = GPIO_MODE_OUTPUT;
+    gpio_config(&ready_cfg);
+    gpio_set_level((gpio_num_t)STREAM_READY_PIN, 0);
+
+    spi_bus_config_t bus_cfg = {};
+    bus_cfg.mosi_io_num = -1; // The master sends nothing
+    bus_cfg.miso_io_num = STREAM_MISO_PIN;
+    bus_cfg.sclk_io_num = STREAM_SCLK_PIN;
+    bus_cfg.quadwp_io_num = -1;
+    bus_cfg.quadhd_io_num = -1;
+    bus_cfg.max_transfer_sz = STREAM_FRAME_BYTES;
+
+    spi_slave_interface_config_t slave_cfg = {};
+    slave_cfg.spics_io_num = STREAM_CS_PIN;
+    slave_cfg.queue_size = STREAM_QUEUE_DEPTH;
+    slave_cfg.mode = 0;
+    slave_cfg.post_setup_cb = stream_post_setup;
+    slave_cfg.post_trans_cb = stream_post_trans;
+
+    esp_err_t ret = spi_slave_initialize(SPI2_HOST, &bus_cfg, &slave_cfg, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) {
+        Serial.printf("E (%s): Failed to initialize the SPI slave: %s\n", TAG, esp_err_to_name(ret));
+        return false;
+    }
+    stream_running = true;
+    // Plain frames at the conversion rate; packed ones are typically 2.5-5x smaller (host bench)
+    uint32_t bytes_per_s = (uint32_t)((uint64_t)ADC_CONVERSION_FREQ_HZ * STREAM_FRAME_BYTES / ADC_READ_LEN);
+    Serial.printf("I (%s): SPI slave stream started (SCLK=%d, MISO=%d, CS=%d, READY=%d): %s frames, <= %d bytes, <= %lu KB/s\n", TAG,
+                  STREAM_SCLK_PIN, STREAM_MISO_PIN, STREAM_CS_PIN, STREAM_READY_PIN, STREAM_PACKED ? "packed" : "plain",
+                  STREAM_FRAME_BYTES, (unsigned long)(bytes_per_s / 1024));
+    return true;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+void stream_push_frame(const uint8_t *frame, uint32_t samples) {
+    if (!stream_running) {
+        return;
+    }
+    // Collect the transactions the master has finished
+    spi_slave_transaction_t *done;
+    while (in_flight > 0 && spi_slave_get_trans_result(SPI2_HOST, &done, 0) == ESP_OK) {
+        in_flight--;
+    }
+    uint32_t sequence = frame_sequence++;
+    if (in_flight == (uint32_t)STREAM_QUEUE_DEPTH) {
+        frames_dropped++; // Master is behind: keep the queued frames, drop this one
+        return;
+    }
+
+    uint8_t *out = buffer_arena.stream_frames[next_buffer];
+    uint8_t *payload = &out[STREAM_HEADER_BYTES];
+    samples = min(samples, (uint32_t)ADC_READ_LEN);
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)frame;
+    uint32_t payload_bytes = 0;
+    uint32_t timestamp_ms = millis();
+    if (STREAM_PACKED) {
+        // One pass to split the slots, then one block per channel straight into the DMA buffer
+        uint32_t slot_count[ADC_PATTERN_LEN] = {};
+        for (uint32_t i = 0; i < samples; ++i) {
+            uint32_t slot = adc_channel_slot[p[i].type2.channel];
+            if (slot < (uint32_t)ADC_PATTERN_LEN) {
+                buffer_arena.stream_slot_codes[slot][slot_count[slot]++] = p[i].type2.data;
+            }
+        }
+        for (int slot = 0; slot < ADC_PATTERN_LEN; ++slot) {
+            if (slot_count[slot] > 0) {
+                payload_bytes += wave_encode_block(buffer_arena.stream_slot_codes[slot], slot_count[slot], ADC_PATTERN[slot].channel,
+                                                   timestamp_ms, &payload[payload_bytes]);
+            }
+        }
+    } else {
+        // TYPE2 result -> packed u16, straight into the DMA buffer
+        for (uint32_t i = 0; i < samples; ++i) {
+            uint16_t word = (uint16_t)((p[i].type2.channel << 12) | p[i].type2.data);
+            payload[2 * i] = word & 0xFF;
+            payload[2 * i + 1] = word >> 8;
+        }
+        payload_bytes = samples * 2;
+    }
+
+    put_u16(&out[0x00], STREAM_SYNC);
+    out[0x02] = STREAM_VERSION;
+    out[0x03] = (gap_pending ? STREAM_FLAG_GAP : 0) | (STREAM_PACKED ? STREAM_FLAG_PACKED : 0);
+    put_u32(&out[0x04], sequence);
+    put_u32(&out[0x08], frames_dropped);
+    put_u32(&out[0x0C], timestamp_ms);
+    put_u16(&out[0x10], (uint16_t)samples);
+    out[0x12] = ADC_PATTERN_LEN;
+    out[0x13] = 0;
+    put_u16(&out[0x14], (uint16_t)payload_bytes);
+    put_u16(&out[0x16], 0);
+    uint32_t crc_end = STREAM_HEADER_BYTES + payload_bytes;
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < crc_end; ++i) {
+        crc = crc16_update(crc, out[i]);
+    }
+    put_u16(&out[crc_end], crc);
+    uint32_t frame_bytes = stream_frame_bytes(payload_bytes);
+    memset(&out[crc_end + 2], 0, frame_bytes - (crc_end + 2));
+
+    spi_slave_transaction_t *t = &transactions[next_buffer];
+    memset(t, 0, sizeof(*t));
+    t->length = frame_bytes * 8; // Bits
+    t->tx_buffer = out;
+    if (spi_slave_queue_trans(SPI2_HOST, t, 0) != ESP_OK) {
+        frames_dropped++;
+        return;
+    }
+    next_buffer = (next_buffer + 1) % STREAM_QUEUE_DEPTH;
+    in_flight++;
+    frames_sent++;
+    gap_pending = false;
+}
+
+void stream_mark_gap() {
+    gap_pending = true;
+}
+
+void stream_get_counters(uint32_t *sent, uint32_t *dropped) {
+    *sent = frames_sent;
+    *dropped = frames_dropped;
+}
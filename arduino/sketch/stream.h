@@ -0,0 +1,69 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "globals.h"
+
+// --- Raw Sample Stream (SPI slave to the S3) ---
+// Every DMA frame becomes one SPI transaction. The master waits for STREAM_READY_PIN to
+// go high, pulls CS low, clocks out the header, then the rest of the frame
+// (stream_frame_bytes() of the payload length), and releases CS. Layout (little endian):
+//   0x00 u16  Sync (STREAM_SYNC)
+//   0x02 u8   Frame layout version (STREAM_VERSION)
+//   0x03 u8   Flags (STREAM_FLAG_*)
+//   0x04 u32  Frame sequence number (every frame offered since boot, dropped ones included)
+//   0x08 u32  Frames dropped since boot (all buffers still waiting for the master)
+//   0x0C u32  Timestamp (ms since C3 boot, when the frame was read from the DMA pool)
+//   0x10 u16  Sample count n (conversion slots, all channels)
+//   0x12 u8   Channel count (ADC_PATTERN_LEN)
+//   0x13 u8   Reserved (0)
+//   0x14 u16  Payload bytes p
+//   0x16 u16  Reserved (0)
+//   0x18      Payload: STREAM_FLAG_PACKED set: one wave_codec.h block per pattern channel
+//             (its samples in conversion order); clear: n x u16 ADC channel << 12 | code
+//             in conversion order
+//   then      u16 CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over bytes 0x00 .. 0x18 + p - 1
+//   zero padding to a multiple of 4 bytes
+// A jump in the sequence number means the C3 dropped frames; STREAM_FLAG_GAP means the
+// ADC task itself lost samples just before this frame (read timeout/error, legacy discard).
+// Version 1 had a 20-byte header without the payload length and always plain samples.
+
+const uint16_t STREAM_SYNC = 0xA55A;
+const uint8_t STREAM_VERSION = 2;
+const uint8_t STREAM_FLAG_GAP = 1 << 0;
+const uint8_t STREAM_FLAG_PACKED = 1 << 1;
+const int STREAM_HEADER_BYTES = 24;
+
+/**
+ * @brief Bytes on the wire for a payload of `payload_bytes` (header, CRC, padding).
+ */
+constexpr int stream_frame_bytes(int payload_bytes) {
+    return (STREAM_HEADER_BYTES + payload_bytes + 2 + 3) & ~3; // Multiple of 4 for the DMA
+}
+const int STREAM_FRAME_BYTES = stream_frame_bytes(ADC_READ_LEN * 2); // Largest frame (plain payload)
+
+/**
+ * @brief Sets up the SPI slave (GPSPI2, DMA), the handshake pin and the frame buffers.
+ * No-op with STREAM_ENABLED false.
+ * @return true if the stream is running.
+ */
+bool init_stream();
+
+/**
+ * @brief Packs one DMA frame into a free transaction buffer and queues it for the
+ * master, or counts it as dropped. Never blocks (ADC task).
+ * @param frame TYPE2 results as returned by adc_continuous_read().
+ * @param samples Number of results in the frame.
+ */
+void stream_push_frame(const uint8_t *frame, uint32_t samples);
+
+/**
+ * @brief Flags the next frame as following a gap in the sample stream (ADC task).
+ */
+void stream_mark_gap();
+
+/**
+ * @brief Frames queued and dropped since boot (0 if the stream is not running).
+ */
+void stream_get_counters(uint32_t *sent, uint32_t *dropped);
+
+#endif // STREAM_H
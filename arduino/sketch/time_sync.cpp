@@ -0,0 +1,47 @@
+#include "time_sync.h"
+#include "logger.h"
+
+static const char *TAG = "TimeSync";
+
+// Written by the I2C backend only, read by the ADC task per window
+static ResultSnapshot<TimeSyncStatus> latest_sync;
+
+// Larger corrections are a master clock step (e.g. its RTC set from GPS), not drift
+static const int64_t TIME_SYNC_STEP_US = 1000000;
+
+void time_sync_apply(int64_t local_us, int64_t master_us) {
+    TimeSyncStatus sync = {};
+    bool had_sync = latest_sync.read(&sync);
+    if (!had_sync) {
+        LOG_I(TAG, "First time sync: window times are now on the master's clock");
+    } else {
+        // How far the previous sync had drifted from the master by now
+        int64_t error_us = master_us - (sync.master_us + (local_us - sync.local_us));
+        int64_t elapsed_us = local_us - sync.local_us;
+        if (error_us > TIME_SYNC_STEP_US || error_us < -TIME_SYNC_STEP_US) {
+            LOG_I(TAG, "Master clock stepped by %ld ms", (int32_t)(error_us / 1000));
+        } else if (elapsed_us > 0) {
+            LOG_D(TAG, "Time sync #%lu: %ld us drift over %lu ms (%ld ppm)", sync.syncs + 1, (int32_t)error_us,
+                  (uint32_t)(elapsed_us / 1000), (int32_t)(error_us * 1000000 / elapsed_us));
+        }
+    }
+    sync.local_us = local_us;
+    sync.master_us = master_us;
+    sync.syncs++;
+    latest_sync.publish(sync);
+}
+
+bool time_sync_to_master(int64_t *us) {
+    TimeSyncStatus sync;
+    if (!latest_sync.read(&sync)) {
+        return false;
+    }
+    *us = sync.master_us + (*us - sync.local_us);
+    return true;
+}
+
+TimeSyncStatus time_sync_get_status() {
+    TimeSyncStatus sync = {};
+    latest_sync.read(&sync); // Never synced -> all zero
+    return sync;
+}
@@ -0,0 +1,38 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include "globals.h"
+
+// --- Master Time Sync ---
+// Window times are taken from esp_timer (us since C3 boot). The master writes its own
+// clock to REG_EXT_TIMES (extended bank); the I2C backend stamps the write with esp_timer
+// as it arrives, and from then on every window's first/last sample time is reported on the
+// master's clock (RESULT_FLAG_TIME_SYNCED), so current lines up with the master's GPS and
+// ESC logs without a second conversion. Offset only: the C3 crystal drifts by tens of ppm
+// against the master, so the master writes again every few seconds (each sync replaces the
+// previous one and logs how far the C3 had drifted since it). Not kept across a reset.
+
+struct TimeSyncStatus {
+    int64_t local_us;  // esp_timer when the latest sync write arrived
+    int64_t master_us; // Master clock the write carried
+    uint32_t syncs;    // Sync writes applied since boot (0 = never synced)
+};
+
+/**
+ * @brief Applies a master time write that arrived at `local_us` (esp_timer, stamped by the
+ * I2C backend as early as it can: the IDF receive callback, or the Wire receive handler).
+ */
+void time_sync_apply(int64_t local_us, int64_t master_us);
+
+/**
+ * @brief Converts an esp_timer time to the master's clock of the latest sync (any context).
+ * @return false, `us` unchanged, before the first sync.
+ */
+bool time_sync_to_master(int64_t *us);
+
+/**
+ * @brief Latest sync (all zero before the first one).
+ */
+TimeSyncStatus time_sync_get_status();
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,162 @@
+#include "wave_codec.h"
+
+// --- Bit I/O (MSB first) ---
+struct BitWriter {
+    uint8_t *p;
+    uint32_t acc;  // Pending bits in the low end
+    uint32_t bits; // Number of pending bits (< 8 between calls)
+};
+
+static inline void put_bits(BitWriter *w, uint32_t value, uint32_t n) {
+    w->acc = (w->acc << n) | value; // n <= 17, so nothing pending is shifted out
+    w->bits += n;
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        *w->p++ = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static inline void flush_bits(BitWriter *w) {
+    if (w->bits > 0) {
+        *w->p++ = (uint8_t)(w->acc << (8 - w->bits));
+        w->bits = 0;
+    }
+}
+
+struct BitReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t acc;
+    uint32_t bits;
+    bool overrun;
+};
+
+static inline uint32_t get_bits(BitReader *r, uint32_t n) {
+    while (r->bits < n) {
+        if (r->p < r->end) {
+            r->acc = (r->acc << 8) | *r->p++;
+        } else {
+            r->acc <<= 8;
+            r->overrun = true;
+        }
+        r->bits += 8;
+    }
+    r->bits -= n;
+    return (r->acc >> r->bits) & ((1u << n) - 1);
+}
+
+static inline uint32_t zigzag(int32_t d) {
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// Rice codes for codes[1 .. count-1]; false (output incomplete) as soon as the block
+// would grow past `budget_bits`, the size of plain 12-bit packing.
+static bool encode_rice(const uint16_t *codes, uint32_t count, uint32_t k, uint32_t budget_bits, BitWriter *w) {
+    uint32_t used_bits = 0;
+    const uint32_t low_mask = (1u << k) - 1;
+    for (uint32_t i = 1; i < count; ++i) {
+        uint32_t u = zigzag((int32_t)codes[i] - (int32_t)codes[i - 1]);
+        uint32_t q = u >> k;
+        uint32_t cost = (q < (uint32_t)WAVE_ESCAPE_QUOTIENT) ? q + 1 + k : WAVE_ESCAPE_QUOTIENT + WAVE_ESCAPE_BITS;
+        used_bits += cost;
+        if (used_bits > budget_bits) {
+            return false;
+        }
+        if (q < (uint32_t)WAVE_ESCAPE_QUOTIENT) {
+            put_bits(w, ((1u << q) - 1) << 1, q + 1); // q ones, then the terminating zero
+            put_bits(w, u & low_mask, k);
+        } else {
+            put_bits(w, (1u << WAVE_ESCAPE_QUOTIENT) - 1, WAVE_ESCAPE_QUOTIENT);
+            put_bits(w, u, WAVE_ESCAPE_BITS);
+        }
+    }
+    return true;
+}
+
+uint32_t wave_encode_block(const uint16_t *codes, uint32_t count, uint8_t channel, uint32_t timestamp_ms, uint8_t *out) {
+    // --- Pass 1: pick k from the mean zigzag difference ---
+    uint32_t sum = 0; // <= 4095 * 8190, no overflow
+    for (uint32_t i = 1; i < count; ++i) {
+        sum += zigzag((int32_t)codes[i] - (int32_t)codes[i - 1]);
+    }
+    uint32_t k = 0;
+    while (count > 1 && k < WAVE_K_MAX && ((count - 1) << (k + 1)) <= sum) {
+        k++; // Largest k with 2^k <= mean
+    }
+
+    // --- Pass 2: write the payload (Rice, or plain codes if that is not smaller) ---
+    BitWriter w = { out + WAVE_HEADER_BYTES, 0, 0 };
+    if (!encode_rice(codes, count, k, (count - 1) * 12, &w)) {
+        k = WAVE_K_PLAIN;
+        w = { out + WAVE_HEADER_BYTES, 0, 0 };
+        for (uint32_t i = 1; i < count; ++i) {
+            put_bits(&w, codes[i], 12);
+        }
+    }
+    flush_bits(&w);
+    uint32_t payload_bytes = (uint32_t)(w.p - (out + WAVE_HEADER_BYTES));
+
+    put_u16(&out[0x00], (uint16_t)count);
+    out[0x02] = channel;
+    out[0x03] = (uint8_t)k;
+    put_u32(&out[0x04], timestamp_ms);
+    put_u16(&out[0x08], codes[0]);
+    put_u16(&out[0x0A], (uint16_t)payload_bytes);
+    return WAVE_HEADER_BYTES + payload_bytes;
+}
+
+uint32_t wave_decode_block(const uint8_t *in, uint32_t len, uint16_t *out, uint32_t max_samples, WaveBlockInfo *info) {
+    if (len < (uint32_t)WAVE_HEADER_BYTES) {
+        return 0;
+    }
+    WaveBlockInfo h;
+    h.samples = (uint16_t)(in[0] | (in[1] << 8));
+    h.channel = in[2];
+    h.k = in[3];
+    h.timestamp_ms = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    h.payload_bytes = (uint16_t)(in[10] | (in[11] << 8));
+    uint32_t first = (uint32_t)(in[8] | (in[9] << 8));
+    if (h.samples == 0 || h.samples > max_samples || h.samples > WAVE_MAX_BLOCK_SAMPLES ||
+        (h.k > WAVE_K_MAX && h.k != WAVE_K_PLAIN) || first > 0x0FFF ||
+        WAVE_HEADER_BYTES + (uint32_t)h.payload_bytes > len) {
+        return 0;
+    }
+    BitReader r = { in + WAVE_HEADER_BYTES, in + WAVE_HEADER_BYTES + h.payload_bytes, 0, 0, false };
+    out[0] = (uint16_t)first;
+    int32_t prev = (int32_t)first;
+    for (uint32_t i = 1; i < h.samples; ++i) {
+        if (h.k == WAVE_K_PLAIN) {
+            prev = (int32_t)get_bits(&r, 12);
+        } else {
+            uint32_t q = 0;
+            while (q < (uint32_t)WAVE_ESCAPE_QUOTIENT && get_bits(&r, 1)) {
+                q++;
+            }
+            uint32_t u = (q == (uint32_t)WAVE_ESCAPE_QUOTIENT) ? get_bits(&r, WAVE_ESCAPE_BITS) : (q << h.k) | get_bits(&r, h.k);
+            prev += (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+            if (prev < 0 || prev > 0x0FFF) {
+                return 0;
+            }
+        }
+        out[i] = (uint16_t)prev;
+    }
+    if (r.overrun) {
+        return 0;
+    }
+    if (info) {
+        *info = h;
+    }
+    return WAVE_HEADER_BYTES + h.payload_bytes;
+}
@@ -0,0 +1,67 @@
+#ifndef WAVE_CODEC_H
+#define WAVE_CODEC_H
+
+#include <stdint.h>
+
+// --- Packed Waveform Blocks (lossless, delta + Rice) ---
+// One block carries consecutive raw 12-bit codes of one ADC channel. Consecutive motor
+// current samples are strongly correlated, so the sample-to-sample differences are
+// small: each difference is zigzag-mapped to an unsigned value u (0, -1, 1, -2 ... ->
+// 0, 1, 2, 3 ...) and Rice coded with parameter k: u >> k in unary (that many 1 bits,
+// then a 0), followed by the low k bits of u. k is picked per block from the mean of u.
+// A quotient of WAVE_ESCAPE_QUOTIENT or more is sent as that many 1 bits (no 0) and u
+// in WAVE_ESCAPE_BITS plain bits, which bounds the cost of a single outlier. When Rice
+// coding would not beat plain 12-bit packing, the block stores the codes that way
+// instead (k = WAVE_K_PLAIN), so a block is never larger than 12 bits per sample.
+//
+// Block layout (little endian header, payload bits MSB first):
+//   0x00 u16  Sample count n (1 .. WAVE_MAX_BLOCK_SAMPLES)
+//   0x02 u8   ADC channel
+//   0x03 u8   k: Rice parameter (0 .. 12) or WAVE_K_PLAIN
+//   0x04 u32  Timestamp of the first sample (ms since C3 boot)
+//   0x08 u16  First code, sent as is
+//   0x0A u16  Payload bytes
+//   0x0C      n - 1 codes (Rice coded differences, or 12-bit codes), zero padded to a byte
+// Blocks are self-delimiting and are simply concatenated. Decoders: wave_decode_block()
+// (host benchmark), chart/src/utils/waveCodec.ts, device/io_local/wave_codec.py.
+
+const int WAVE_HEADER_BYTES = 12;
+const int WAVE_MAX_BLOCK_SAMPLES = 4096;
+const uint8_t WAVE_K_MAX = 12;           // Differences of 12-bit codes need at most 13 bits
+const uint8_t WAVE_K_PLAIN = 0xFF;       // Payload is plain 12-bit codes
+const int WAVE_ESCAPE_QUOTIENT = 16;
+const int WAVE_ESCAPE_BITS = 13;
+
+/**
+ * @brief Worst-case block size for `samples` codes (plain 12-bit packing plus header).
+ */
+constexpr int wave_max_block_bytes(int samples) {
+    return WAVE_HEADER_BYTES + ((samples - 1) * 12 + 7) / 8;
+}
+
+struct WaveBlockInfo {
+    uint16_t samples;
+    uint8_t channel;
+    uint8_t k;
+    uint32_t timestamp_ms;
+    uint16_t payload_bytes;
+};
+
+/**
+ * @brief Encodes `count` codes (12-bit, 1 .. WAVE_MAX_BLOCK_SAMPLES) into one block.
+ * Two passes over the input: the sum of |differences| picks k, the second pass writes.
+ * @param out Room for at least wave_max_block_bytes(count) bytes.
+ * @return Bytes written (header included).
+ */
+uint32_t wave_encode_block(const uint16_t *codes, uint32_t count, uint8_t channel, uint32_t timestamp_ms, uint8_t *out);
+
+/**
+ * @brief Decodes one block.
+ * @param in Block start; `len` bytes available.
+ * @param out Room for `max_samples` codes.
+ * @param info Header of the block (may be NULL).
+ * @return Bytes consumed, or 0 if the block is malformed, truncated or too long for `out`.
+ */
+uint32_t wave_decode_block(const uint8_t *in, uint32_t len, uint16_t *out, uint32_t max_samples, WaveBlockInfo *info);
+
+#endif // WAVE_CODEC_H
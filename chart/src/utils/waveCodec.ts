@@ -0,0 +1,122 @@
+// Decoder for packed waveform blocks (delta + Rice coded raw ADC codes) written by the C3:
+// scope captures saved by the S3 as .wave files and packed stream frames. The format is
+// defined in arduino/sketch/wave_codec.h.
+
+export interface WaveBlock {
+	channel: number
+	timestampMs: number // First sample, ms since C3 boot
+	codes: Uint16Array // Raw 12-bit ADC codes
+}
+
+const HEADER_BYTES = 12
+const K_MAX = 12
+const K_PLAIN = 0xff
+const ESCAPE_QUOTIENT = 16
+const ESCAPE_BITS = 13
+
+class BitReader {
+	private pos = 0 // Bit position
+	private readonly endBit: number
+
+	constructor(
+		private readonly bytes: Uint8Array,
+		start: number,
+		length: number
+	) {
+		this.pos = start * 8
+		this.endBit = (start + length) * 8
+	}
+
+	bit(): number {
+		if (this.pos >= this.endBit) {
+			throw new Error('Packed block payload truncated')
+		}
+		const b = (this.bytes[this.pos >> 3] >> (7 - (this.pos & 7))) & 1
+		this.pos++
+		return b
+	}
+
+	bits(n: number): number {
+		let v = 0
+		for (let i = 0; i < n; i++) {
+			v = (v << 1) | this.bit()
+		}
+		return v
+	}
+}
+
+/**
+ * Decodes one block starting at `offset`.
+ * @returns The block and the offset of the next one.
+ */
+export function decodeWaveBlock(bytes: Uint8Array, offset = 0): { block: WaveBlock; next: number } {
+	if (offset + HEADER_BYTES > bytes.length) {
+		throw new Error(`Packed block header truncated at byte ${offset}`)
+	}
+	const view = new DataView(bytes.buffer, bytes.byteOffset + offset, HEADER_BYTES)
+	const samples = view.getUint16(0, true)
+	const channel = view.getUint8(2)
+	const k = view.getUint8(3)
+	const timestampMs = view.getUint32(4, true)
+	const first = view.getUint16(8, true)
+	const payloadBytes = view.getUint16(10, true)
+	if (samples === 0 || (k > K_MAX && k !== K_PLAIN) || first > 0x0fff) {
+		throw new Error(`Malformed packed block at byte ${offset}`)
+	}
+	if (offset + HEADER_BYTES + payloadBytes > bytes.length) {
+		throw new Error(`Packed block payload truncated at byte ${offset}`)
+	}
+
+	const reader = new BitReader(bytes, offset + HEADER_BYTES, payloadBytes)
+	const codes = new Uint16Array(samples)
+	codes[0] = first
+	let prev = first
+	for (let i = 1; i < samples; i++) {
+		if (k === K_PLAIN) {
+			prev = reader.bits(12)
+		} else {
+			let q = 0
+			while (q < ESCAPE_QUOTIENT && reader.bit()) {
+				q++
+			}
+			const u = q === ESCAPE_QUOTIENT ? reader.bits(ESCAPE_BITS) : q * (1 << k) + reader.bits(k)
+			prev += u & 1 ? -((u + 1) >> 1) : u >> 1 // Zigzag back to a signed difference
+			if (prev < 0 || prev > 0x0fff) {
+				throw new Error(`Packed block at byte ${offset} decodes out of range`)
+			}
+		}
+		codes[i] = prev
+	}
+	return { block: { channel, timestampMs, codes }, next: offset + HEADER_BYTES + payloadBytes }
+}
+
+/**
+ * Decodes a whole file or buffer of concatenated blocks (e.g. an S3 scope .wave file).
+ */
+export function decodeWaveBlocks(data: ArrayBuffer | Uint8Array): WaveBlock[] {
+	const bytes = data instanceof Uint8Array ? data : new Uint8Array(data)
+	const blocks: WaveBlock[] = []
+	let offset = 0
+	while (offset < bytes.length) {
+		const { block, next } = decodeWaveBlock(bytes, offset)
+		blocks.push(block)
+		offset = next
+	}
+	return blocks
+}
+
+/**
+ * Joins the blocks of one channel into a single code array (scope captures are one
+ * channel split into fixed-size blocks).
+ */
+export function concatWaveCodes(blocks: WaveBlock[], channel?: number): Uint16Array {
+	const selected = channel === undefined ? blocks : blocks.filter((b) => b.channel === channel)
+	const total = selected.reduce((n, b) => n + b.codes.length, 0)
+	const out = new Uint16Array(total)
+	let pos = 0
+	for (const b of selected) {
+		out.set(b.codes, pos)
+		pos += b.codes.length
+	}
+	return out
+}
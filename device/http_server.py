@@ -36,6 +36,7 @@ from io_local import gps_config
 from io_local import control
 from io_local import adc as adc_module  # Import the ADC module (device/ is root)
 from io_local import ds18b20 as ds18b20_module  # Import the DS18B20 module
+from io_local import motor_current_i2c
 from io_local.data_log import (
     get_current_data_log_file_path,
     get_previous_data_log_file_path,
@@ -223,6 +224,13 @@ def save_settings(request: Request):
         ):  # Check explicitly for None to allow empty string
             settings_manager.set_device_description(device_description)
 
+        # C3 acquisition config: stored for the next boot and sent to the C3 now
+        c3_acquisition = config_data.get("c3_acquisition")
+        if c3_acquisition is not None:
+            if not settings_manager.set_c3_acquisition(c3_acquisition):
+                raise ValueError("Invalid C3 acquisition settings")
+            motor_current_i2c.request_config(settings_manager.get_c3_acquisition())
+
         return Response(
             body=json.dumps({"success": True, "message": "Settings saved"}),
             status=HTTP_OK,
@@ -400,6 +408,8 @@ def get_settings_data(request):
             "current_ssid": current_network["ssid"] if current_network else "",
             "networks": networks_list,  # Directly use the list from settings_manager
             "device_description": settings_manager.get_device_description(),
+            "c3_acquisition": settings_manager.get_c3_acquisition(),
+            "c3_acquisition_status": motor_current_i2c.get_config_status(),
         }
         return Response(
             body=json.dumps(data), headers={"Content-Type": "application/json"}
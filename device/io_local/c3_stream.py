@@ -0,0 +1,247 @@
+import uasyncio as asyncio
+import struct
+from machine import SPI, Pin
+from log import log
+from globals import SD_MOUNT_POINT
+from . import wave_codec
+
+# Raw sample stream from the C3 over SPI (see arduino/sketch/stream.h). The C3 is the
+# SPI slave: it raises READY while a frame is armed, we pull CS low and clock it out.
+C3_STREAM_ENABLED = False  # Must match STREAM_ENABLED on the C3
+
+STREAM_SPI_ID = 2  # SPI3 host (the SD card uses the other one)
+STREAM_SCK_PIN = 40
+STREAM_MOSI_PIN = 41  # Not connected, the C3 receives nothing
+STREAM_MISO_PIN = 42
+STREAM_CS_PIN = 15
+STREAM_READY_PIN = 16
+STREAM_BAUDRATE = 10_000_000
+
+STREAM_SYNC = 0xA55A
+STREAM_VERSION = 2
+STREAM_FLAG_GAP = 1 << 0
+STREAM_FLAG_PACKED = 1 << 1
+STREAM_ADC_READ_LEN = 512  # ADC_READ_LEN on the C3
+STREAM_HEADER_LEN = 24
+STREAM_MAX_PAYLOAD = STREAM_ADC_READ_LEN * 2
+# sync, version, flags, seq, dropped, ts_ms, samples, channels, reserved, payload bytes, reserved
+STREAM_HEADER_FORMAT = "<HBBIIIHBBHH"
+
+
+def stream_frame_len(payload_len: int) -> int:
+    """Bytes clocked out for a payload (header, CRC, padding to 4 bytes)."""
+    return (STREAM_HEADER_LEN + payload_len + 2 + 3) & ~3
+
+
+STREAM_FRAME_LEN = stream_frame_len(STREAM_MAX_PAYLOAD)
+
+STREAM_DIR = f"{SD_MOUNT_POINT}/stream"
+STREAM_FILE_MAX_BYTES = 8 * 1024 * 1024  # Start a new file after this many bytes
+STREAM_STATS_INTERVAL_MS = 10000
+STREAM_POLL_INTERVAL_S = 0.005  # Frames arrive every ~20 ms, the C3 queues 4
+
+_spi = None
+_cs = None
+_ready = None
+_reader_task = None
+_logging = False
+_stats = {"frames": 0, "lost": 0, "gaps": 0, "bad": 0, "c3_dropped": 0}
+
+
+def init_c3_stream() -> None:
+    """Set up the SPI master and the handshake pins (no-op with C3_STREAM_ENABLED False)."""
+    global _spi, _cs, _ready
+    if not C3_STREAM_ENABLED:
+        return
+    try:
+        _cs = Pin(STREAM_CS_PIN, Pin.OUT, value=1)
+        _ready = Pin(STREAM_READY_PIN, Pin.IN, Pin.PULL_DOWN)
+        _spi = SPI(
+            STREAM_SPI_ID,
+            baudrate=STREAM_BAUDRATE,
+            polarity=0,
+            phase=0,
+            sck=Pin(STREAM_SCK_PIN),
+            mosi=Pin(STREAM_MOSI_PIN),
+            miso=Pin(STREAM_MISO_PIN),
+        )
+        log(f"C3 Stream: SPI({STREAM_SPI_ID}) initialized, {STREAM_FRAME_LEN}-byte frames")
+    except Exception as e:
+        log(f"C3 Stream: Initialization error: {e}")
+        _spi = None
+
+
+def _crc16(data, length) -> int:
+    """CRC-16/CCITT-FALSE, poly 0x1021, init 0xFFFF (matches the C3 encoder)."""
+    crc = 0xFFFF
+    for i in range(length):
+        crc ^= data[i] << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def decode_frame_header(frame) -> dict | None:
+    """Header of one stream frame, or None if sync, version or length do not match."""
+    sync, version, flags, seq, dropped, ts_ms, samples, channels, _, payload_len, _ = struct.unpack_from(
+        STREAM_HEADER_FORMAT, frame
+    )
+    if (
+        sync != STREAM_SYNC
+        or version != STREAM_VERSION
+        or samples > STREAM_ADC_READ_LEN
+        or payload_len > STREAM_MAX_PAYLOAD
+    ):
+        return None
+    return {
+        "flags": flags,
+        "seq": seq,
+        "dropped": dropped,
+        "ts_ms": ts_ms,
+        "samples": samples,
+        "channels": channels,
+        "payload_len": payload_len,
+    }
+
+
+def decode_frame(frame) -> dict | None:
+    """Header plus samples of one frame, None on a bad frame.
+
+    Plain frames give [(adc_channel, code), ...] in conversion order, packed frames one
+    wave_codec block per channel. Checks the CRC: too slow for every live frame on the
+    S3, meant for reading log files back (see read_stream_file())."""
+    header = decode_frame_header(frame)
+    if header is None:
+        return None
+    end = STREAM_HEADER_LEN + header["payload_len"]
+    (crc,) = struct.unpack_from("<H", frame, end)
+    if _crc16(frame, end) != crc:
+        return None
+    if header["flags"] & STREAM_FLAG_PACKED:
+        blocks = wave_codec.decode_blocks(frame, STREAM_HEADER_LEN, end)
+        if blocks is None:
+            return None
+        header["blocks"] = blocks
+    else:
+        words = struct.unpack_from(f"<{header['samples']}H", frame, STREAM_HEADER_LEN)
+        header["samples"] = [(w >> 12, w & 0x0FFF) for w in words]
+    return header
+
+
+def read_stream_file(path: str):
+    """Yields the decoded frames of a stream log file (bad frames are skipped)."""
+    buf = bytearray(STREAM_FRAME_LEN)
+    mv = memoryview(buf)
+    with open(path, "rb") as f:
+        while f.readinto(mv[:STREAM_HEADER_LEN]) == STREAM_HEADER_LEN:
+            header = decode_frame_header(buf)
+            if header is None:
+                return  # Frames are stored back to back: cannot resynchronise
+            rest = header["payload_len"] + 2
+            if f.readinto(mv[STREAM_HEADER_LEN : STREAM_HEADER_LEN + rest]) != rest:
+                return
+            frame = decode_frame(buf)
+            if frame is not None:
+                yield frame
+
+
+def _open_log_file():
+    from fs import recursive_mkdir
+    import os
+
+    recursive_mkdir(STREAM_DIR)
+    index = len(os.listdir(STREAM_DIR))
+    path = f"{STREAM_DIR}/stream_{index:04d}.bin"
+    log(f"C3 Stream: Logging to {path}")
+    return open(path, "wb")
+
+
+async def _c3_stream_task() -> None:
+    """Clock out every frame the C3 arms and append it to the SD log while logging is on."""
+    import time
+
+    frame = bytearray(STREAM_FRAME_LEN)
+    mv = memoryview(frame)
+    expected_seq = None
+    log_file = None
+    log_bytes = 0
+    last_stats_ms = time.ticks_ms()
+
+    while True:
+        try:
+            while _ready.value():
+                # Header first, then exactly the rest of this frame, in one CS assertion
+                _cs.value(0)
+                _spi.readinto(mv[:STREAM_HEADER_LEN])
+                header = decode_frame_header(frame)
+                if header is not None:
+                    frame_len = stream_frame_len(header["payload_len"])
+                    _spi.readinto(mv[STREAM_HEADER_LEN:frame_len])
+                _cs.value(1)
+                if header is None:
+                    _stats["bad"] += 1
+                    expected_seq = None  # Out of step: resynchronise on the next frame
+                    continue
+                _stats["frames"] += 1
+                if expected_seq is not None and header["seq"] != expected_seq:
+                    # Sequence numbers count every frame the C3 offered, sent or dropped
+                    _stats["lost"] += (header["seq"] - expected_seq) & 0xFFFFFFFF
+                expected_seq = (header["seq"] + 1) & 0xFFFFFFFF
+                if header["flags"] & STREAM_FLAG_GAP:
+                    _stats["gaps"] += 1
+                _stats["c3_dropped"] = header["dropped"]
+                if _logging:
+                    if log_file is None or log_bytes >= STREAM_FILE_MAX_BYTES:
+                        if log_file is not None:
+                            log_file.close()
+                        log_file = _open_log_file()
+                        log_bytes = 0
+                    # Frames as received (packed or plain, no padding), verified when read back
+                    used = STREAM_HEADER_LEN + header["payload_len"] + 2
+                    log_file.write(mv[:used])
+                    log_bytes += used
+                elif log_file is not None:
+                    log_file.close()
+                    log_file = None
+            if time.ticks_diff(time.ticks_ms(), last_stats_ms) >= STREAM_STATS_INTERVAL_MS:
+                last_stats_ms = time.ticks_ms()
+                log(
+                    f"C3 Stream: {_stats['frames']} frames, {_stats['lost']} lost, "
+                    f"{_stats['gaps']} gaps, {_stats['bad']} bad, C3 dropped {_stats['c3_dropped']}"
+                )
+        except Exception as e:
+            log(f"C3 Stream: Error: {e}")
+            _cs.value(1)
+        await asyncio.sleep(STREAM_POLL_INTERVAL_S)
+
+
+def get_stream_stats() -> dict:
+    """Frame counters since the reader started."""
+    return dict(_stats)
+
+
+def start_c3_stream_log() -> None:
+    """Append received frames to a new file under STREAM_DIR."""
+    global _logging
+    _logging = True
+
+
+def stop_c3_stream_log() -> None:
+    """Stop writing frames (the current file is closed by the reader task)."""
+    global _logging
+    _logging = False
+
+
+def start_c3_stream_reader() -> None:
+    """Start the async stream reader task if the stream is initialized."""
+    global _reader_task
+    if _spi is None:
+        return
+    if _reader_task is None:
+        try:
+            _reader_task = asyncio.create_task(_c3_stream_task())
+            log("C3 Stream: Reader task started")
+        except Exception as e:
+            log(f"C3 Stream: Failed to start reader task: {e}")
+    else:
+        log("C3 Stream: Reader task already running")
@@ -1,6 +1,7 @@
 import uasyncio as asyncio
 import uos
 import json
+import time
 import settings_manager
 import log
 from lib.queue import Queue, QueueEmpty, QueueFull
@@ -115,10 +116,13 @@ def report_data(
     sensor_name: str,
     timestamp: int,
     data: dict | list | tuple | str | int | float | bool | None,
+    acquired_us: int | None = None,
 ) -> None:
+    """Queue a sensor value. acquired_us: when the value was measured (epoch us, the
+    time.time_ns() clock), if the sensor knows better than its arrival time; written as "at"."""
     q = _get_raw_data_queue()
     try:
-        q.put_nowait((sensor_name, data))
+        q.put_nowait((sensor_name, data, acquired_us))
     except QueueFull:
         log.log(f"DataLog: Raw data queue full. Dropping data from {sensor_name}")
 
@@ -187,7 +191,7 @@ def _write_jsonl_entry(
 
 def _check_esc_rpm_zero_trigger(sensors_data: list) -> bool:
     """Check if any sensor in the batch is 'esc' with rpm value of 0"""
-    for sensor_name, data in sensors_data:
+    for sensor_name, data, _ in sensors_data:
         if sensor_name == "esc" and isinstance(data, dict) and data.get("rpm") == 0:
             return True
     return False
@@ -231,11 +235,16 @@ def _write_sensors_array(sensors_data: list) -> bool:
         common_entry_json_string = f'{{"t":{json.dumps(time_str)}}}'
 
         sensor_specific_entries = []
-        for sensor_name, data in sensors_data:
-            # Create sensor-specific part: {"n": name, "v": value}
+        for sensor_name, data, acquired_us in sensors_data:
+            # Create sensor-specific part: {"n": name, "v": value}, plus "at" (acquisition
+            # time of day with ms, same form as "t") when the sensor reported one
             # needed to override error
             s = json.dumps(data, separators=(",", ":"))
-            sensor_part_json_string = f'{{"n":{json.dumps(sensor_name)},' f'"v":{s}}}'
+            at = ""
+            if acquired_us is not None:
+                at_str = format_time(time.gmtime(acquired_us // 1_000_000), True, (acquired_us // 1000) % 1000)
+                at = f',"at":{json.dumps(at_str)}'
+            sensor_part_json_string = f'{{"n":{json.dumps(sensor_name)},' f'"v":{s}{at}}}'
             sensor_specific_entries.append(sensor_part_json_string)
 
         # Combine common entry with all sensor-specific entries
@@ -268,7 +277,7 @@ async def data_report_task():
         while True:
             try:
                 rename_file_if_rtc_updated()
-                sensor_name, data = raw_q.get_nowait()
+                sensor_name, data, acquired_us = raw_q.get_nowait()
 
                 # Get timestamp for this specific data point for the live cache
                 _timestamp_str_for_jsonl, current_sensor_time_for_cache = (
@@ -276,7 +285,7 @@ async def data_report_task():
                 )
 
                 # Collect sensor data for batch writing
-                sensors_batch.append((sensor_name, data))
+                sensors_batch.append((sensor_name, data, acquired_us))
 
                 # Update latest_data with value and its specific timestamp
                 latest_data[sensor_name] = {
@@ -13,6 +13,7 @@ from . import ds18b20
 # from . import ina226 # Keep file but don't init
 from . import gps_reader
 from . import motor_current_i2c
+from . import c3_stream
 from . import throttle_reader
 from . import fan
 
@@ -40,6 +41,7 @@ def init_io():
     # adc.init_adc()
     esc_telemetry.init_esc_telemetry()
     motor_current_i2c.init_rms_motor_current_i2c()
+    c3_stream.init_c3_stream()  # No-op unless C3_STREAM_ENABLED
     throttle_reader.init_throttle_reader()
     fan.init_fan()
     ds18b20.init_ds18b20()
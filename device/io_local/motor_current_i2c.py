@@ -1,7 +1,9 @@
 import uasyncio as asyncio
+import struct
 from machine import I2C, Pin
 from log import log
 from . import data_log
+from globals import SD_MOUNT_POINT
 
 I2C_ID = 0
 I2C_SCL_PIN = 39
@@ -15,7 +17,133 @@ _reader_task = None
 SENSOR_NAME = "mc"
 FACTOR = 0.2
 
+# C3 register map (see arduino/sketch/i2c_registers.h)
+REG_RESULT = 0x00
+RESULT_RECORD_LEN = 32
+# rms, freq_dhz, peak, mean, samples, seq, ts_ms, min, max, crest_x100, config_version, status, version, crc
+RESULT_RECORD_FORMAT = "<HHHHIIIHHHHHBB"
+RESULT_RECORD_VERSION = 3
+RESULT_FLAG_VALID = 1 << 0
+RESULT_STATE_SHIFT = 6  # Warm-up state, bits 6..7 of the status flags
+RESULT_STATES = ("steady", "warming_up", "provisional")
+RESULT_FLAG_OVERCURRENT = 1 << 8  # Overcurrent alert latched on the C3 until clear_alert()
+RESULT_FLAG_SAMPLES_DROPPED = 1 << 9  # C3 DMA pool overflowed in the window (its processing fell behind)
+RESULT_FLAG_ADC_RESTARTED = 1 << 10  # C3 restarted its stalled ADC driver in the window
+RESULT_FLAG_TIME_SYNCED = 1 << 11  # Window sample times are on our clock (sync_time() since the C3 booted)
+# Extended bank: write REG_BANK_SELECT, bank, start register (+ payload), then a plain read
+REG_BANK_SELECT = 0xFE
+BANK_EXTENDED = 1
+# Window times (extended bank): first/last sample of the latest window
+REG_EXT_TIMES = 0x00
+TIMES_RECORD_LEN = 28
+TIMES_RECORD_FORMAT = "<IqqIHBB"  # seq, start_us, end_us, syncs, status, version, crc
+TIMES_RECORD_VERSION = 1
+# Master time sync: our clock (epoch us, time.time_ns()) written to REG_EXT_TIMES, which
+# dates every window's first/last sample with it. Offset only, so repeated to absorb C3 drift.
+TIME_SYNC_INTERVAL_MS = 5000
+# The C3 stamps the write when its last byte arrives: address, bank select (3 bytes) and 9 payload bytes
+TIME_SYNC_TRANSFER_US = 13 * 9 * 1_000_000 // I2C_FREQ
+REG_CHANNELS = 0x80
+CHANNELS_RECORD_LEN = 40
+CHANNELS_RECORD_VERSION = 1
+CHANNEL_ENTRY_FORMAT = "<BBHH"  # adc channel, role, rms_mv, mean_mv
+CHANNEL_ROLES = ("current", "current_aux", "battery_voltage")
+
+_channel_count = 1  # Pattern length read from the C3 at init
+
+# Scope (triggered raw capture) registers
+REG_SCOPE = 0xC0
+SCOPE_STATUS_LEN = 24
+# state, source, trigger_idx, length, chunk, seq, trigger_ms, chunk_samples, packed_bytes, packed_block, version, crc
+SCOPE_STATUS_FORMAT = "<BBHHHIIHHHBB"
+SCOPE_STATUS_VERSION = 2
+REG_SCOPE_CHUNK = 0xC6
+REG_SCOPE_DATA = 0xE0
+REG_SCOPE_PACKED = 0xE1  # Packed capture (arduino/sketch/wave_codec.h), same chunk index
+SCOPE_CMD_ARM = 0x01
+SCOPE_CMD_TRIGGER = 0x02
+SCOPE_STATE_FROZEN = 2
+SCOPE_CHECK_INTERVAL_MS = 1000
+SCOPE_DIR = f"{SD_MOUNT_POINT}/scope"
+
+_last_scope_seq = 0
+
+# Profiler diagnostics (C3 hot-path timing probes, statistics since C3 boot)
+REG_PROFILE = 0x20
+PROFILE_RECORD_LEN = 32
+PROFILE_RECORD_FORMAT = "<BBHIIIIIIHBB"  # probe, probe_count, cpu_mhz, count, avg, p50, p90, p99, max (us), reserved, version, crc
+PROFILE_PROBE_NAMES = ("adc_read", "read_gap", "kernel", "window", "discard_read", "i2c_request", "spectrum")
+
+# Self-benchmark (stage costs measured at C3 boot) and live CPU idle
+REG_BENCH = 0x68
+BENCH_RECORD_LEN = 24
+BENCH_RECORD_FORMAT = "<HHHHHHIIHBB"  # decode, accumulate, detector, cic, kernel (0.1 cycles), idle (0.1 %), fft, max_rate_hz, status, version, crc
+BENCH_CMD_RUN = 0x01
+BENCH_FLAG_VALID = 1 << 0
+CPU_IDLE_UNKNOWN = 0xFFFF
+
+# Memory diagnostics (heap, per-task stack headroom in bytes)
+REG_MEMORY = 0xA8
+MEMORY_RECORD_LEN = 24
+MEMORY_RECORD_FORMAT = "<IIIHHHHHBB"  # free, min free, largest block, 5 x stack headroom, version, crc
+MEMORY_RECORD_VERSION = 1
+MEMORY_TASK_NAMES = ("adc", "spectrum", "log", "led", "loop")
+STACK_HEADROOM_UNKNOWN = 0xFFFF
+
+# C3 I2C slave counters since boot (wrapping u16)
+REG_I2C_STATS = 0xD8
+I2C_STATS_RECORD_LEN = 8
+I2C_STATS_RECORD_FORMAT = "<HHHBB"  # bus errors, dropped writes, stretched reads, version, crc
+I2C_STATS_RECORD_VERSION = 1
+
+# Charge and energy counter (extended bank; C3 integrals over every sample, see arduino/sketch/charge_counter.h)
+REG_EXT_CHARGE = 0x20
+CHARGE_RECORD_LEN = 32
+CHARGE_RECORD_FORMAT = "<qqIIHHBBBB"  # charge_uc, energy_uj, covered_ms, elapsed_ms, resets, snapshots, flags, reserved, version, crc
+CHARGE_RECORD_VERSION = 1
+CHARGE_FLAG_HELD = 1 << 0
+CHARGE_FLAG_ENERGY = 1 << 1
+CHARGE_CMD_SNAPSHOT = 1 << 0  # Hold the totals in the record
+CHARGE_CMD_RESET = 1 << 1  # Restart the totals from zero (after the snapshot, if both)
+CHARGE_CMD_LIVE = 1 << 2  # Release the held snapshot
+
+# Runtime acquisition config (applied by the C3 at a block boundary, lost on a C3 reset)
+REG_CONFIG = 0xE2
+CONFIG_RECORD_LEN = 16
+# sample_hz, window_ms, output_hz, atten, filter, filter_available, config_version, state, reject, version, crc
+CONFIG_RECORD_FORMAT = "<IHBBBBHBBBB"
+CONFIG_WRITE_FORMAT = "<IHBBB"  # sample_hz, window_ms, output_hz, atten, filter (+ CRC-8)
+CONFIG_RECORD_VERSION = 2
+CONFIG_STATES = ("active", "pending", "rejected", "failed")
+CONFIG_REJECT_NAMES = ("format", "sample_rate", "output_rate", "window", "atten", "filter")
+CONFIG_KEYS = ("sample_rate_hz", "window_ms", "output_rate_hz", "atten", "filter_sections")
+# filter_sections bits: 0 DC blocker, 1 + i biquad i of the C3 build's FILTER_BIQUADS
+
+# Overcurrent alert (C3 per-frame peak/RMS check, see arduino/sketch/overcurrent.h)
+REG_ALERT = 0xF2
+ALERT_RECORD_LEN = 12
+ALERT_RECORD_FORMAT = "<BBHHHHBB"  # state, source, peak_trip, rms_trip, hysteresis, trips, version, crc
+ALERT_WRITE_FORMAT = "<HHH"  # peak_trip_mv, rms_trip_mv, hysteresis_mv (+ CRC-8)
+ALERT_RECORD_VERSION = 1
+ALERT_STATE_ACTIVE = 1 << 0
+ALERT_STATE_LATCHED = 1 << 1
+ALERT_SOURCE_NAMES = ("peak", "rms")
+ALERT_CMD_CLEAR = 0x01
+# C3 open-drain alert line (C3 GPIO10), low within one DMA frame (~20 ms) of an overcurrent
+ALERT_PIN = 5
+
+_alert_pin = None
+_alert_handler = None  # Set by set_alert_handler(), called with True on a trip and False on release
+_alert_changed = False  # Set by the pin IRQ, handled by the reader task
+_alert_status = None  # Latest read_alert() result, see get_alert_status()
+
+_pending_config = None  # Set by request_config(), sent by the reader task between polls
+_config_status = None  # Latest read_config() result, see get_config_status()
+
+_last_record = None  # Latest decoded record dict, see get_latest_record()
+
 LOW_CURRENT_LOG_INTERVAL_MS: int = 5000
+POLL_INTERVAL_S = 0.1  # Matches OUTPUT_RATE_HZ (10 Hz) on the C3
 
 
 def init_rms_motor_current_i2c() -> None:
@@ -35,17 +163,548 @@ def init_rms_motor_current_i2c() -> None:
             log(f"RMS I2C: Device not found at address 0x{I2C_ADDR:02X}")
         else:
             log(f"RMS I2C: Device found at address 0x{I2C_ADDR:02X}")
+            _read_channel_count()
+            _init_alert_pin()
+            import settings_manager
+
+            request_config(settings_manager.get_c3_acquisition())
     except Exception as e:
         log(f"RMS I2C: Initialization error: {e}")
         _i2c = None
 
 
+def _crc8(data) -> int:
+    """CRC-8, poly 0x07, init 0x00 (matches the C3 encoder)."""
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def _decode_record(data) -> dict | None:
+    """Decode a 32-byte measurement record, or None if the CRC or version does not match."""
+    if _crc8(data[: RESULT_RECORD_LEN - 1]) != data[RESULT_RECORD_LEN - 1]:
+        return None
+    (
+        rms,
+        freq_dhz,
+        peak,
+        mean,
+        samples,
+        seq,
+        ts_ms,
+        min_mv,
+        max_mv,
+        crest_x100,
+        config_version,
+        status,
+        version,
+        _,
+    ) = struct.unpack(RESULT_RECORD_FORMAT, data)
+    if version != RESULT_RECORD_VERSION:
+        return None
+    return {
+        "rms_mv": rms,
+        "freq_hz": freq_dhz / 10,
+        "peak_mv": peak,
+        "mean_mv": mean,
+        "min_mv": min_mv,
+        "max_mv": max_mv,
+        "crest": crest_x100 / 100,
+        "samples": samples,
+        "seq": seq,
+        "ts_ms": ts_ms,
+        "synced": bool(status & RESULT_FLAG_TIME_SYNCED),
+        "status": status,
+        "version": version,
+        "config_version": config_version,
+        "state": _result_state(status),
+        "gap": bool(status & (RESULT_FLAG_SAMPLES_DROPPED | RESULT_FLAG_ADC_RESTARTED)),
+    }
+
+
+def _read_extended(reg: int, length: int) -> bytes:
+    """Read `length` bytes from an extended bank register (one bank select per read)."""
+    _i2c.writeto_mem(I2C_ADDR, REG_BANK_SELECT, bytes([BANK_EXTENDED, reg]))
+    return _i2c.readfrom(I2C_ADDR, length)
+
+
+def read_window_times() -> dict | None:
+    """First/last sample time of the latest C3 window, or None on CRC/version mismatch.
+
+    Epoch us on our clock when "synced", else us since C3 boot.
+    """
+    data = _read_extended(REG_EXT_TIMES, TIMES_RECORD_LEN)
+    if len(data) != TIMES_RECORD_LEN or _crc8(data[: TIMES_RECORD_LEN - 1]) != data[TIMES_RECORD_LEN - 1]:
+        return None
+    seq, start_us, end_us, syncs, status, version, _ = struct.unpack(TIMES_RECORD_FORMAT, data)
+    if version != TIMES_RECORD_VERSION:
+        return None
+    return {
+        "seq": seq,
+        "start_us": start_us,
+        "end_us": end_us,
+        "syncs": syncs,
+        "synced": bool(status & RESULT_FLAG_TIME_SYNCED),
+    }
+
+
+def _now_us() -> int:
+    """Our clock for the time sync: epoch us (RTC, GPS-set once there is a fix)."""
+    import time
+
+    return time.time_ns() // 1000
+
+
+def sync_time() -> None:
+    """Write our clock to the C3: window times are reported on it from the next window."""
+    payload = struct.pack("<Q", _now_us() + TIME_SYNC_TRANSFER_US)
+    select = bytes([BANK_EXTENDED, REG_EXT_TIMES])
+    _i2c.writeto_mem(I2C_ADDR, REG_BANK_SELECT, select + payload + bytes([_crc8(payload)]))
+
+
+def _result_state(status) -> str:
+    """Warm-up state of a result: short first block, filling window, or a full window."""
+    state = (status >> RESULT_STATE_SHIFT) & 0x3
+    return RESULT_STATES[state] if state < len(RESULT_STATES) else "unknown"
+
+
+def _decode_channels(data) -> dict | None:
+    """Decode the 40-byte per-channel record, or None if the CRC or version does not match."""
+    if _crc8(data[: CHANNELS_RECORD_LEN - 1]) != data[CHANNELS_RECORD_LEN - 1]:
+        return None
+    if data[CHANNELS_RECORD_LEN - 2] != CHANNELS_RECORD_VERSION:
+        return None
+    seq, count, _, battery_mv, power_mw = struct.unpack("<IBBHi", data[:12])
+    channels = []
+    for i in range(count):
+        adc_ch, role, rms, mean = struct.unpack(
+            CHANNEL_ENTRY_FORMAT, data[12 + 6 * i : 18 + 6 * i]
+        )
+        channels.append(
+            {
+                "adc_channel": adc_ch,
+                "role": CHANNEL_ROLES[role] if role < len(CHANNEL_ROLES) else role,
+                "rms_mv": rms,
+                "mean_mv": mean,
+            }
+        )
+    return {
+        "seq": seq,
+        "battery_mv": battery_mv,
+        "power_mw": power_mw,
+        "channels": channels,
+    }
+
+
+def _read_channel_count() -> None:
+    """Read how many pattern channels the C3 samples (1 = current only)."""
+    global _channel_count
+    try:
+        data = _i2c.readfrom_mem(I2C_ADDR, REG_CHANNELS, CHANNELS_RECORD_LEN)
+        channels = _decode_channels(data)
+        if channels is not None:
+            _channel_count = len(channels["channels"])
+            log(f"RMS I2C: C3 samples {_channel_count} channel(s)")
+    except Exception as e:
+        log(f"RMS I2C: Channel record read failed: {e}")
+
+
+def _alert_irq(pin) -> None:
+    """Alert line edge (hard IRQ context): hand the new level to the handler, flag it for the reader task."""
+    global _alert_changed
+    _alert_changed = True
+    if _alert_handler is not None:
+        import micropython
+
+        try:
+            micropython.schedule(_alert_handler, pin.value() == 0)
+        except RuntimeError:
+            pass  # Schedule queue full: the reader task still reports it
+
+
+def _init_alert_pin() -> None:
+    """Watch the C3 overcurrent alert line (open drain, active low: pulled up here)."""
+    global _alert_pin
+    try:
+        _alert_pin = Pin(ALERT_PIN, Pin.IN, Pin.PULL_UP)
+        _alert_pin.irq(trigger=Pin.IRQ_FALLING | Pin.IRQ_RISING, handler=_alert_irq)
+        log(f"RMS I2C: Overcurrent alert line on pin {ALERT_PIN}")
+    except Exception as e:
+        log(f"RMS I2C: Alert pin {ALERT_PIN} setup failed: {e}")
+        _alert_pin = None
+
+
+def set_alert_handler(handler) -> None:
+    """Call handler(True) as soon as the C3 asserts the overcurrent alert, handler(False) on release.
+
+    Runs as a MicroPython scheduled callback right after the pin edge, not from the 100 ms poll,
+    so it is the place to cut throttle."""
+    global _alert_handler
+    _alert_handler = handler
+
+
+def overcurrent_active() -> bool:
+    """Level of the alert line: True while the C3 sees an overcurrent."""
+    return _alert_pin is not None and _alert_pin.value() == 0
+
+
+def read_alert() -> dict | None:
+    """Read the C3 overcurrent alert state and trip levels, or None on CRC/version mismatch."""
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_ALERT, ALERT_RECORD_LEN)
+    if _crc8(data[: ALERT_RECORD_LEN - 1]) != data[ALERT_RECORD_LEN - 1]:
+        return None
+    state, source, peak_trip, rms_trip, hysteresis, trips, version, _ = struct.unpack(ALERT_RECORD_FORMAT, data)
+    if version != ALERT_RECORD_VERSION:
+        return None
+    return {
+        "active": bool(state & ALERT_STATE_ACTIVE),
+        "latched": bool(state & ALERT_STATE_LATCHED),
+        "sources": [name for i, name in enumerate(ALERT_SOURCE_NAMES) if source & (1 << i)],
+        "peak_trip_mv": peak_trip,
+        "rms_trip_mv": rms_trip,
+        "hysteresis_mv": hysteresis,
+        "trips": trips,
+    }
+
+
+def write_alert_thresholds(peak_trip_mv: int, rms_trip_mv: int, hysteresis_mv: int) -> None:
+    """Set the C3 trip levels (mV at the ADC pin about the sensor zero, 0 disables one); check with read_alert()."""
+    payload = struct.pack(ALERT_WRITE_FORMAT, peak_trip_mv, rms_trip_mv, hysteresis_mv)
+    _i2c.writeto_mem(I2C_ADDR, REG_ALERT, payload + bytes([_crc8(payload)]))
+
+
+def clear_alert() -> None:
+    """Clear the C3 overcurrent latch (it sets again at once if the alert is still asserted)."""
+    _i2c.writeto_mem(I2C_ADDR, REG_ALERT, bytes([ALERT_CMD_CLEAR]))
+
+
+def get_alert_status() -> dict | None:
+    """C3 overcurrent alert as last read back by the reader task, if any."""
+    return _alert_status
+
+
+def _check_alert() -> None:
+    """Read the alert record after a pin edge or while results carry the latch: log each trip once, clear the latch once released."""
+    global _alert_changed, _alert_status
+    import time
+
+    _alert_changed = False
+    status = read_alert()
+    if status is None:
+        return
+    previous, _alert_status = _alert_status, status
+    if status["latched"] and (previous is None or status["trips"] != previous["trips"]):
+        data_log.report_error(
+            SENSOR_NAME,
+            time.ticks_ms(),
+            f"C3 overcurrent ({', '.join(status['sources'])}), trip #{status['trips']}",
+        )
+    if status["latched"] and not status["active"]:
+        clear_alert()  # Logged; the next trip latches again
+
+
+def get_latest_record() -> dict | None:
+    """Return the most recent valid record read from the C3, if any."""
+    return _last_record
+
+
+def read_scope_status() -> dict | None:
+    """Read the C3 scope status block, or None on CRC mismatch."""
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_SCOPE, SCOPE_STATUS_LEN)
+    if _crc8(data[: SCOPE_STATUS_LEN - 1]) != data[SCOPE_STATUS_LEN - 1]:
+        return None
+    (
+        state,
+        source,
+        trig_idx,
+        length,
+        _,
+        seq,
+        trig_ms,
+        chunk_samples,
+        packed_bytes,
+        packed_block,
+        version,
+        _,
+    ) = struct.unpack(SCOPE_STATUS_FORMAT, data)
+    if version != SCOPE_STATUS_VERSION:
+        return None
+    return {
+        "state": state,
+        "source": source,
+        "trigger_index": trig_idx,
+        "length": length,
+        "seq": seq,
+        "trigger_ms": trig_ms,
+        "chunk_samples": chunk_samples,
+        "packed_bytes": packed_bytes,
+        "packed_block_samples": packed_block,
+    }
+
+
+def scope_command(cmd: int) -> None:
+    """Send SCOPE_CMD_ARM (re-arm) or SCOPE_CMD_TRIGGER (force a capture) to the C3."""
+    _i2c.writeto_mem(I2C_ADDR, REG_SCOPE, bytes([cmd]))
+
+
+async def read_scope_capture(status: dict) -> list | None:
+    """Stream a frozen capture chunk by chunk; returns the raw ADC codes or None."""
+    chunk_samples = status["chunk_samples"]
+    chunk_len = 2 + 2 * chunk_samples + 1
+    _i2c.writeto_mem(I2C_ADDR, REG_SCOPE_CHUNK, struct.pack("<H", 0))
+    samples = []
+    for chunk in range(status["length"] // chunk_samples):
+        data = _i2c.readfrom_mem(I2C_ADDR, REG_SCOPE_DATA, chunk_len)
+        if _crc8(data[: chunk_len - 1]) != data[chunk_len - 1]:
+            return None
+        index = struct.unpack("<H", data[:2])[0]
+        if index != chunk:
+            return None  # Capture re-armed or chunk skipped
+        samples.extend(struct.unpack(f"<{chunk_samples}H", data[2 : chunk_len - 1]))
+        await asyncio.sleep(0)  # Let other tasks run between chunks
+    return samples
+
+
+async def read_scope_packed(status: dict) -> bytes | None:
+    """Stream the packed form of a frozen capture (wave_codec blocks); returns its bytes or None."""
+    chunk_bytes = 2 * status["chunk_samples"]
+    chunk_len = 2 + chunk_bytes + 1
+    _i2c.writeto_mem(I2C_ADDR, REG_SCOPE_CHUNK, struct.pack("<H", 0))
+    packed = bytearray()
+    for chunk in range((status["packed_bytes"] + chunk_bytes - 1) // chunk_bytes):
+        data = _i2c.readfrom_mem(I2C_ADDR, REG_SCOPE_PACKED, chunk_len)
+        if _crc8(data[: chunk_len - 1]) != data[chunk_len - 1]:
+            return None
+        index = struct.unpack("<H", data[:2])[0]
+        if index != chunk:
+            return None  # Capture re-armed or chunk skipped
+        packed.extend(data[2 : chunk_len - 1])
+        await asyncio.sleep(0)  # Let other tasks run between chunks
+    return bytes(packed[: status["packed_bytes"]])
+
+
+def read_profile() -> list | None:
+    """Read every C3 profiler probe (timings in us since C3 boot), or None on CRC mismatch."""
+    _i2c.writeto_mem(I2C_ADDR, REG_PROFILE, bytes([0]))
+    probes = []
+    count = 1
+    while len(probes) < count:
+        data = _i2c.readfrom_mem(I2C_ADDR, REG_PROFILE, PROFILE_RECORD_LEN)
+        if _crc8(data[: PROFILE_RECORD_LEN - 1]) != data[PROFILE_RECORD_LEN - 1]:
+            return None
+        probe, count, cpu_mhz, n, avg, p50, p90, p99, peak, _, _, _ = struct.unpack(PROFILE_RECORD_FORMAT, data)
+        name = PROFILE_PROBE_NAMES[probe] if probe < len(PROFILE_PROBE_NAMES) else f"probe{probe}"
+        probes.append(
+            {"probe": name, "count": n, "avg_us": avg, "p50_us": p50, "p90_us": p90, "p99_us": p99, "max_us": peak}
+        )
+    return probes
+
+
+def read_benchmark() -> dict | None:
+    """Read the C3 self-benchmark of this boot and the live CPU idle, or None on CRC mismatch."""
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_BENCH, BENCH_RECORD_LEN)
+    if _crc8(data[: BENCH_RECORD_LEN - 1]) != data[BENCH_RECORD_LEN - 1]:
+        return None
+    decode, accumulate, detector, cic, kernel, idle, fft, max_rate, status, _, _ = struct.unpack(BENCH_RECORD_FORMAT, data)
+    return {
+        "valid": bool(status & BENCH_FLAG_VALID),
+        "decode_cycles": decode / 10,
+        "accumulate_cycles": accumulate / 10,
+        "detector_cycles": detector / 10,
+        "cic_cycles": cic / 10,
+        "kernel_cycles": kernel / 10,
+        "fft_cycles": fft,
+        "max_rate_hz": max_rate,
+        "cpu_idle_pct": None if idle == CPU_IDLE_UNKNOWN else idle / 10,
+        "status": status,
+    }
+
+
+def read_memory() -> dict | None:
+    """Read the C3 heap and stack headroom figures, or None on CRC/version mismatch."""
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_MEMORY, MEMORY_RECORD_LEN)
+    if _crc8(data[: MEMORY_RECORD_LEN - 1]) != data[MEMORY_RECORD_LEN - 1]:
+        return None
+    fields = struct.unpack(MEMORY_RECORD_FORMAT, data)
+    if fields[-2] != MEMORY_RECORD_VERSION:
+        return None
+    stacks = {}
+    for name, headroom in zip(MEMORY_TASK_NAMES, fields[3:8]):
+        if headroom != STACK_HEADROOM_UNKNOWN:
+            stacks[name] = headroom
+    return {
+        "free_heap": fields[0],
+        "min_free_heap": fields[1],
+        "largest_free_block": fields[2],
+        "stack_headroom": stacks,
+    }
+
+
+def read_i2c_stats() -> dict | None:
+    """Read the C3 I2C slave counters, or None on CRC/version mismatch.
+
+    stretched_reads counts every read of a C3 built with the Wire backend; with the
+    IDF backend it counts reads that found no response staged (clock stretched).
+    """
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_I2C_STATS, I2C_STATS_RECORD_LEN)
+    if _crc8(data[: I2C_STATS_RECORD_LEN - 1]) != data[I2C_STATS_RECORD_LEN - 1]:
+        return None
+    bus_errors, dropped, stretched, version, _ = struct.unpack(I2C_STATS_RECORD_FORMAT, data)
+    if version != I2C_STATS_RECORD_VERSION:
+        return None
+    return {"bus_errors": bus_errors, "dropped_writes": dropped, "stretched_reads": stretched}
+
+
+def read_charge() -> dict | None:
+    """Read the C3 charge/energy totals (mAh, Wh), or None on CRC/version mismatch.
+
+    covered_s below elapsed_s means the C3 lost frames; "held" totals are a snapshot.
+    """
+    data = _read_extended(REG_EXT_CHARGE, CHARGE_RECORD_LEN)
+    if len(data) != CHARGE_RECORD_LEN or _crc8(data[: CHARGE_RECORD_LEN - 1]) != data[CHARGE_RECORD_LEN - 1]:
+        return None
+    charge_uc, energy_uj, covered_ms, elapsed_ms, resets, snapshots, flags, _, version, _ = struct.unpack(
+        CHARGE_RECORD_FORMAT, data
+    )
+    if version != CHARGE_RECORD_VERSION:
+        return None
+    return {
+        "charge_mah": charge_uc / 3_600_000,
+        "energy_wh": energy_uj / 3_600_000_000 if flags & CHARGE_FLAG_ENERGY else None,
+        "covered_s": covered_ms / 1000,
+        "elapsed_s": elapsed_ms / 1000,
+        "resets": resets,
+        "snapshots": snapshots,
+        "held": bool(flags & CHARGE_FLAG_HELD),
+    }
+
+
+def charge_command(cmd: int) -> None:
+    """Send CHARGE_CMD_* bits to the C3 (applied at its next block, read back with read_charge())."""
+    _i2c.writeto_mem(I2C_ADDR, REG_BANK_SELECT, bytes([BANK_EXTENDED, REG_EXT_CHARGE, cmd]))
+
+
+def read_config() -> dict | None:
+    """Read the C3 acquisition config and the outcome of the last write, or None on CRC/version mismatch."""
+    data = _i2c.readfrom_mem(I2C_ADDR, REG_CONFIG, CONFIG_RECORD_LEN)
+    if _crc8(data[: CONFIG_RECORD_LEN - 1]) != data[CONFIG_RECORD_LEN - 1]:
+        return None
+    (
+        sample_hz,
+        window_ms,
+        output_hz,
+        atten,
+        filter_sections,
+        filter_available,
+        config_version,
+        state,
+        reject,
+        version,
+        _,
+    ) = struct.unpack(CONFIG_RECORD_FORMAT, data)
+    if version != CONFIG_RECORD_VERSION:
+        return None
+    return {
+        "sample_rate_hz": sample_hz,
+        "window_ms": window_ms,
+        "output_rate_hz": output_hz,
+        "atten": atten,
+        "filter_sections": filter_sections,
+        "filter_available": filter_available,
+        "config_version": config_version,
+        "state": CONFIG_STATES[state] if state < len(CONFIG_STATES) else state,
+        "rejected": [name for i, name in enumerate(CONFIG_REJECT_NAMES) if reject & (1 << i)],
+    }
+
+
+def write_config(cfg: dict) -> None:
+    """Send a new acquisition config (keys as in read_config()); check read_config()["state"] for the outcome."""
+    payload = struct.pack(
+        CONFIG_WRITE_FORMAT,
+        cfg["sample_rate_hz"],
+        cfg["window_ms"],
+        cfg["output_rate_hz"],
+        cfg["atten"],
+        cfg["filter_sections"],
+    )
+    _i2c.writeto_mem(I2C_ADDR, REG_CONFIG, payload + bytes([_crc8(payload)]))
+
+
+async def apply_config(cfg: dict) -> dict | None:
+    """Write a config (unless already active) and wait for the C3 to take it at a block boundary.
+
+    Returns the final read_config()."""
+    status = read_config()
+    if status is not None and all(status[key] == cfg[key] for key in CONFIG_KEYS):
+        return status
+    write_config(cfg)
+    for _ in range(15):  # A block lasts up to 1 s at the lowest output rate
+        await asyncio.sleep(0.1)
+        status = read_config()
+        if status is not None and status["state"] != "pending":
+            break
+    if status is None or status["state"] != "active":
+        log(f"RMS I2C: C3 config {cfg} not applied: {status}")
+    else:
+        log(f"RMS I2C: C3 config #{status['config_version']} active: {cfg}")
+    return status
+
+
+def request_config(cfg: dict) -> None:
+    """Queue a config for the reader task (safe from other threads, e.g. the HTTP server)."""
+    global _pending_config
+    _pending_config = {key: int(cfg[key]) for key in CONFIG_KEYS}
+
+
+def get_config_status() -> dict | None:
+    """C3 acquisition config as last read back by the reader task, if any."""
+    return _config_status
+
+
+def request_benchmark() -> None:
+    """Restart the C3 into its self-benchmark (acquisition pauses for about a second)."""
+    _i2c.writeto_mem(I2C_ADDR, REG_BENCH, bytes([BENCH_CMD_RUN]))
+
+
+async def _check_scope() -> None:
+    """Save a newly frozen C3 capture to SD (packed .wave plus .json metadata), then re-arm the trigger."""
+    global _last_scope_seq
+    import json
+    from fs import recursive_mkdir
+
+    status = read_scope_status()
+    if status is None or status["state"] != SCOPE_STATE_FROZEN:
+        return
+    if status["seq"] != _last_scope_seq:
+        # Packed: about a third of the I2C reads and of the SD space of the plain codes
+        packed = await read_scope_packed(status)
+        if packed is None:
+            log("RMS I2C: Scope capture read failed, retrying")
+            return
+        _last_scope_seq = status["seq"]
+        recursive_mkdir(SCOPE_DIR)
+        base = f"{SCOPE_DIR}/capture_{status['seq']:04d}_{status['trigger_ms']}"
+        with open(base + ".wave", "wb") as f:
+            f.write(packed)
+        with open(base + ".json", "w") as f:
+            status["wave_file"] = base.split("/")[-1] + ".wave"
+            f.write(json.dumps(status))
+        log(f"RMS I2C: Scope capture #{status['seq']} saved to {base}.wave ({len(packed)} bytes)")
+    scope_command(SCOPE_CMD_ARM)
+
+
 async def _rms_motor_current_i2c_task() -> None:
-    """Async task to poll RMS motor current from I2C 10 times/sec, log once/sec."""
-    global _i2c
+    """Async task to poll the C3 measurement record over I2C and log motor current."""
+    global _i2c, _last_record, _pending_config, _config_status
     import time
 
     last_low_current_log_time_ms: int = 0
+    last_seq = None
+    last_scope_check_ms: int = 0
+    last_sync_ms = None  # None: sync before the next read
 
     while True:
         try:
@@ -56,30 +715,86 @@ async def _rms_motor_current_i2c_task() -> None:
                     "RMS I2C: Not initialized, skipping read",
                 )
             else:
-                data = _i2c.readfrom(I2C_ADDR, 2)
-                if len(data) == 2:
-                    rms_mv = data[0] | (data[1] << 8)
-                    motor_current = rms_mv * FACTOR
+                if (
+                    last_sync_ms is None
+                    or time.ticks_diff(time.ticks_ms(), last_sync_ms) >= TIME_SYNC_INTERVAL_MS
+                ):
+                    sync_time()
+                    last_sync_ms = time.ticks_ms()
+                # One burst read of the whole record from REG_RESULT
+                data = _i2c.readfrom_mem(I2C_ADDR, REG_RESULT, RESULT_RECORD_LEN)
+                record = (
+                    _decode_record(data) if len(data) == RESULT_RECORD_LEN else None
+                )
+                if record is None:
+                    data_log.report_error(
+                        SENSOR_NAME,
+                        time.ticks_ms(),
+                        f"RMS I2C: Bad record ({len(data)} bytes, CRC or version mismatch)",
+                    )
+                elif record["seq"] == last_seq or not (
+                    record["status"] & RESULT_FLAG_VALID
+                ):
+                    pass  # Same window as the previous poll, or an invalid window
+                else:
+                    if last_seq is not None and record["seq"] < last_seq:
+                        # C3 restarted: its first results cover a shorter window until it fills,
+                        # and its times are on its own boot clock until the next sync
+                        log(
+                            f"RMS I2C: C3 restarted, window #{record['seq']} ({record['state']}) at {record['ts_ms']} ms"
+                        )
+                        last_sync_ms = None
+                    if record["gap"] and (_last_record is None or not _last_record["gap"]):
+                        data_log.report_error(
+                            SENSOR_NAME,
+                            time.ticks_ms(),
+                            f"RMS I2C: C3 window #{record['seq']} has a gap (status 0x{record['status']:04X})",
+                        )
+                    last_seq = record["seq"]
+                    if _channel_count > 1:
+                        # Extra channels (second phase, battery voltage) and V*I power
+                        channels = _decode_channels(
+                            _i2c.readfrom_mem(I2C_ADDR, REG_CHANNELS, CHANNELS_RECORD_LEN)
+                        )
+                        if channels is not None and channels["seq"] == record["seq"]:
+                            record["channels"] = channels
+                    acquired_us = None
+                    if record["synced"]:
+                        # Logged at the middle of the window's samples, not when this poll got it
+                        times = read_window_times()
+                        if times is not None and times["seq"] == record["seq"] and times["synced"]:
+                            record["start_us"] = times["start_us"]
+                            record["end_us"] = times["end_us"]
+                            acquired_us = (times["start_us"] + times["end_us"]) // 2
+                    _last_record = record
+                    motor_current = record["rms_mv"] * FACTOR
                     current_ticks: int = time.ticks_ms()
 
                     if motor_current >= 1.3:
-                        data_log.report_data(SENSOR_NAME, current_ticks, motor_current)
+                        data_log.report_data(SENSOR_NAME, current_ticks, motor_current, acquired_us)
                     else:  # motor_current < 2
                         if (
                             time.ticks_diff(current_ticks, last_low_current_log_time_ms)
                             >= LOW_CURRENT_LOG_INTERVAL_MS
                         ):
                             data_log.report_data(
-                                SENSOR_NAME, current_ticks, motor_current
+                                SENSOR_NAME, current_ticks, motor_current, acquired_us
                             )
                             last_low_current_log_time_ms = current_ticks
-
-                else:
-                    data_log.report_error(
-                        SENSOR_NAME,
-                        time.ticks_ms(),
-                        f"RMS I2C: Incomplete read, got {len(data)} bytes",
-                    )
+            if _i2c is not None and (
+                _alert_changed
+                or (_last_record is not None and _last_record["status"] & RESULT_FLAG_OVERCURRENT)
+            ):
+                _check_alert()
+            if _i2c is not None and _pending_config is not None:
+                cfg, _pending_config = _pending_config, None
+                _config_status = await apply_config(cfg)
+            if _i2c is not None and (
+                time.ticks_diff(time.ticks_ms(), last_scope_check_ms)
+                >= SCOPE_CHECK_INTERVAL_MS
+            ):
+                last_scope_check_ms = time.ticks_ms()
+                await _check_scope()
         except Exception as e:
             pass
             data_log.report_error(
@@ -87,7 +802,7 @@ async def _rms_motor_current_i2c_task() -> None:
                 time.ticks_ms(),
                 "no data",
             )
-        await asyncio.sleep(0.9)
+        await asyncio.sleep(POLL_INTERVAL_S)
 
 
 def start_rms_motor_current_i2c_reader() -> None:
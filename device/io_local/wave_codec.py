@@ -0,0 +1,67 @@
+# Decoder for packed waveform blocks (delta + Rice coded raw ADC codes) from the C3,
+# see arduino/sketch/wave_codec.h. Slow in MicroPython: meant for reading files back,
+# the live paths store the packed bytes as they are.
+import struct
+
+WAVE_HEADER_LEN = 12
+WAVE_HEADER_FORMAT = "<HBBIHH"  # samples, channel, k, ts_ms, first code, payload bytes
+WAVE_K_MAX = 12
+WAVE_K_PLAIN = 0xFF
+WAVE_ESCAPE_QUOTIENT = 16
+WAVE_ESCAPE_BITS = 13
+
+
+def decode_block(data, offset=0, limit=None):
+    """Decode the block at `offset` (ending by data[limit]); returns (block dict, next offset) or (None, 0)."""
+    limit = len(data) if limit is None else limit
+    if offset + WAVE_HEADER_LEN > limit:
+        return None, 0
+    samples, channel, k, ts_ms, first, payload_len = struct.unpack_from(
+        WAVE_HEADER_FORMAT, data, offset
+    )
+    end = offset + WAVE_HEADER_LEN + payload_len
+    if samples == 0 or (k > WAVE_K_MAX and k != WAVE_K_PLAIN) or first > 0x0FFF or end > limit:
+        return None, 0
+    pos = (offset + WAVE_HEADER_LEN) * 8  # Bit position, MSB first
+    end_bit = end * 8
+
+    def bits(n):
+        nonlocal pos
+        v = 0
+        for _ in range(n):
+            if pos >= end_bit:
+                raise ValueError("truncated")
+            v = (v << 1) | ((data[pos >> 3] >> (7 - (pos & 7))) & 1)
+            pos += 1
+        return v
+
+    codes = [first]
+    prev = first
+    try:
+        for _ in range(samples - 1):
+            if k == WAVE_K_PLAIN:
+                prev = bits(12)
+            else:
+                q = 0
+                while q < WAVE_ESCAPE_QUOTIENT and bits(1):
+                    q += 1
+                u = bits(WAVE_ESCAPE_BITS) if q == WAVE_ESCAPE_QUOTIENT else (q << k) | bits(k)
+                prev += -((u + 1) >> 1) if u & 1 else u >> 1
+                if prev < 0 or prev > 0x0FFF:
+                    return None, 0
+            codes.append(prev)
+    except ValueError:
+        return None, 0
+    return {"channel": channel, "ts_ms": ts_ms, "codes": codes}, end
+
+
+def decode_blocks(data, offset=0, end=None) -> list | None:
+    """Decode concatenated blocks in data[offset:end]; None if any block is malformed."""
+    end = len(data) if end is None else end
+    blocks = []
+    while offset < end:
+        block, offset = decode_block(data, offset, end)
+        if block is None:
+            return None
+        blocks.append(block)
+    return blocks
@@ -18,6 +18,7 @@ import io_local.esc_telemetry as esc_telemetry
 import io_local.gps_reader as gps_reader
 import io_local.ds18b20 as ds18b20
 import io_local.motor_current_i2c as motor_current_i2c
+import io_local.c3_stream as c3_stream
 import io_local.throttle_reader as throttle_reader
 import io_local.data_log as data_log
 
@@ -58,6 +59,7 @@ async def main():
         asyncio.create_task(data_log.data_log_task())
         asyncio.create_task(data_log.error_log_task())
         motor_current_i2c.start_rms_motor_current_i2c_reader()
+        c3_stream.start_c3_stream_reader()
         throttle_reader.start_throttle_reader()
 
         log("Entering main loop (logger task running, threads running)...")
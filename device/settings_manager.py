@@ -6,6 +6,15 @@ import log  # Changed to resolve circular import
 SETTINGS_FILE_PATH = "/sd/system_config.json"
 SETTINGS_FILE_TMP_PATH = "/sd/system_config.json.tmp"
 
+# C3 acquisition defaults (match the build settings in arduino/sketch/globals.h)
+C3_ACQUISITION_DEFAULTS = {
+    "sample_rate_hz": 25000,
+    "window_ms": 1000,
+    "output_rate_hz": 10,
+    "atten": 3,  # ADC_ATTEN_DB_11 (0..3)
+    "filter_sections": 0,  # Bit 0 DC blocker, bit 1 + i biquad i (FILTER_DEFAULT_SECTIONS)
+}
+
 # --- Module State ---
 _settings_data: dict = {}
 _sd_card_ok: bool = (
@@ -29,6 +38,7 @@ def _default_settings() -> dict:
             "fan_enabled": False,
             "device_description": "",
             "ds_associations": [],
+            "c3_acquisition": dict(C3_ACQUISITION_DEFAULTS),
         },
         "status": {
             "reset_counter": 0,
@@ -311,6 +321,17 @@ def get_ds_associations() -> list:
     return []
 
 
+def get_c3_acquisition() -> dict:
+    """C3 acquisition config to apply at boot (defaults for missing keys)."""
+    cfg = dict(C3_ACQUISITION_DEFAULTS)
+    stored = get_setting("configuration.c3_acquisition", default_value={})
+    if isinstance(stored, dict):
+        for key in cfg:
+            if isinstance(stored.get(key), int):
+                cfg[key] = stored[key]
+    return cfg
+
+
 # Specific Setters
 def set_wifi_networks(networks: list) -> bool:
     if not isinstance(networks, list):
@@ -365,6 +386,32 @@ def set_device_description(description: str) -> bool:
     return update_setting("configuration.device_description", description)
 
 
+def set_c3_acquisition(cfg: dict) -> bool:
+    """Stores the C3 acquisition config after basic checks (the C3 validates it fully)."""
+    if not isinstance(cfg, dict):
+        log.log("set_c3_acquisition: cfg argument must be a dict.")
+        return False
+    try:
+        clean = {key: int(cfg[key]) for key in C3_ACQUISITION_DEFAULTS}
+    except (KeyError, ValueError, TypeError):
+        log.log(f"set_c3_acquisition: cfg needs integer {list(C3_ACQUISITION_DEFAULTS)}.")
+        return False
+    rate, window, output = clean["sample_rate_hz"], clean["window_ms"], clean["output_rate_hz"]
+    if not (1 <= output <= 50) or rate % output or (window * output) % 1000 or not (1 <= window * output // 1000 <= 64):
+        log.log(
+            f"set_c3_acquisition: output rate must be 1..50 Hz dividing the sample rate, "
+            f"window a multiple of the output period (at most 64): {clean}"
+        )
+        return False
+    if not (0 <= clean["atten"] <= 3):
+        log.log(f"set_c3_acquisition: atten must be 0..3: {clean['atten']}")
+        return False
+    if not (0 <= clean["filter_sections"] <= 0xFF):
+        log.log(f"set_c3_acquisition: filter_sections must be a bit mask 0..255: {clean['filter_sections']}")
+        return False
+    return update_setting("configuration.c3_acquisition", clean)
+
+
 def set_ds_associations(associations: list) -> bool:
     """Sets DS18B20 sensor name associations."""
     if not isinstance(associations, list):